@@ -17,4 +17,9 @@ int main() {
   auto result1 = fx1.get_data_and_premium();
 
   std::cout << result1 << "\n";
+
+  auto quote = fx.get_premium();
+
+  std::cout << "premium only: premium = " << quote.premium << ", delta = " << quote.delta
+            << ", gamma = " << quote.gamma << "\n";
 }
\ No newline at end of file
@@ -0,0 +1,345 @@
+#include <benchmark/benchmark.h>
+
+#include "cds.hpp"
+#include "credit.hpp"
+#include "equity.hpp"
+#include "fx.hpp"
+#include "grid_io.hpp"
+#include "linalg.hpp"
+#include "portfolio.hpp"
+#include "random.hpp"
+#include "rates.hpp"
+#include "scenario.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Engine benchmarks take (N, M, threads) unless noted; items processed count
+// path steps, so the rates compare across sizes.
+namespace
+{
+    void engine_args(benchmark::internal::Benchmark *b)
+    {
+        b->ArgNames({"N", "M", "threads"})
+            ->ArgsProduct({{50, 250}, {10000, 100000}, {1, 4}})
+            ->Unit(benchmark::kMillisecond)
+            ->UseRealTime();
+    }
+
+    void set_path_steps(benchmark::State &state)
+    {
+        state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(1));
+    }
+}
+
+static void BM_SampleBoxMuller(benchmark::State &state)
+{
+    SampleBoxMuller normal(default_rng_seed);
+    std::int64_t n = state.range(0);
+
+    for (auto _ : state)
+        for (std::int64_t i = 0; i < n; ++i)
+            benchmark::DoNotOptimize(normal());
+
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_SampleBoxMuller)->Arg(1 << 16);
+
+static void BM_NormalGenerator_fill(benchmark::State &state)
+{
+    NormalGenerator normal(default_rng_seed, 0);
+    std::vector<double> out(state.range(0));
+
+    for (auto _ : state)
+    {
+        normal.fill(out.data(), out.size());
+        benchmark::DoNotOptimize(out.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_NormalGenerator_fill)->Arg(1 << 16);
+
+// Grows an N x N matrix to 2N x 2N, copying the old elements
+static void BM_matrix_resize(benchmark::State &state)
+{
+    std::size_t n = state.range(0);
+
+    for (auto _ : state)
+    {
+        matrix<double> u(n, n, matrix_layout::column_major, 1.);
+        matrix_resize(u, 2 * n, 2 * n);
+        benchmark::DoNotOptimize(u.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * 4 * n * n * sizeof(double));
+}
+BENCHMARK(BM_matrix_resize)->ArgName("N")->Arg(64)->Arg(512);
+
+static void BM_EQ1(benchmark::State &state)
+{
+    EQ1 option(1., 100., 100., 0.2, 0.05, state.range(0), state.range(1));
+    option.set_threads(state.range(2));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(option.get_premium());
+
+    set_path_steps(state);
+}
+BENCHMARK(BM_EQ1)->Apply(engine_args);
+
+static void BM_EQ1_greeks(benchmark::State &state)
+{
+    EQ1 option(1., 100., 100., 0.2, 0.05, state.range(0), state.range(1));
+    option.set_threads(state.range(2));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(option.get_greeks());
+
+    set_path_steps(state);
+}
+BENCHMARK(BM_EQ1_greeks)->Apply(engine_args);
+
+static void BM_EQ2(benchmark::State &state)
+{
+    EQ2 option(1., 0.05, 100., 100., 0.2, 0.3, 0.5, state.range(0), state.range(1));
+    option.set_threads(state.range(2));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(option.get_premium());
+
+    set_path_steps(state);
+}
+BENCHMARK(BM_EQ2)->Apply(engine_args);
+
+// Eight correlated assets, basket call
+static void BM_EQN(benchmark::State &state)
+{
+    constexpr std::size_t n_assets = 8;
+    EQN option(1., 0.05, std::vector<double>(n_assets, 100.), std::vector<double>(n_assets, 0.2),
+               exponential_correlation(n_assets, 0.2), state.range(0), state.range(1));
+    option.set_threads(state.range(2));
+    option.set_payoff(std::make_shared<BasketCallPayoff>(std::vector<double>(n_assets, 1. / n_assets), 100.));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(option.get_premium());
+
+    set_path_steps(state);
+}
+BENCHMARK(BM_EQN)->Apply(engine_args);
+
+// FX1 takes (space nodes N, time slices M, scheme); dt and dx keep the grid
+// inside the explicit stability limit
+static void BM_FX1(benchmark::State &state)
+{
+    int N = state.range(0), M = state.range(1);
+    double dx = 2. / (N - 1), dt = 0.5 / M;
+
+    FX1 option(0.5, 75., 75., 0.3, 0.05, dt, dx, N, M);
+    option.set_scheme(static_cast<FX_scheme>(state.range(2)));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(option.get_premium());
+
+    set_path_steps(state);
+}
+BENCHMARK(BM_FX1)
+    ->ArgNames({"N", "M", "scheme"})
+    ->ArgsProduct({{101, 401}, {1000, 10000}, {0, 1, 2}})
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_FX1_full_grid(benchmark::State &state)
+{
+    int N = state.range(0), M = state.range(1);
+    FX1 option(0.5, 75., 75., 0.3, 0.05, 0.5 / M, 2. / (N - 1), N, M);
+    option.set_scheme(FX_scheme::crank_nicolson);
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(option.get_data_and_premium());
+
+    set_path_steps(state);
+}
+BENCHMARK(BM_FX1_full_grid)
+    ->ArgNames({"N", "M"})
+    ->ArgsProduct({{101, 401}, {1000}})
+    ->Unit(benchmark::kMillisecond);
+
+// Full grid streamed to a binary file (codec 0 = none, 1 = zlib), against
+// the text operator<<
+static void BM_FX1_write_grid(benchmark::State &state)
+{
+    int N = state.range(0), M = state.range(1);
+    FX1 option(0.5, 75., 75., 0.3, 0.05, 0.5 / M, 2. / (N - 1), N, M);
+    option.set_scheme(FX_scheme::crank_nicolson);
+
+    GridCodec codec = static_cast<GridCodec>(state.range(2));
+    if (codec == GridCodec::zlib && !grid_compression_available())
+    {
+        state.SkipWithError("built without zlib");
+        return;
+    }
+
+    const char *path = "fx1_benchmark.grid";
+    for (auto _ : state)
+    {
+        GridWriter writer(path, codec);
+        benchmark::DoNotOptimize(option.write_data_and_premium(writer));
+    }
+    std::remove(path);
+
+    state.SetBytesProcessed(state.iterations() * 2 * sizeof(double) * static_cast<std::int64_t>(N) * M);
+}
+BENCHMARK(BM_FX1_write_grid)
+    ->ArgNames({"N", "M", "codec"})
+    ->ArgsProduct({{401}, {1000}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_FX1_text_grid(benchmark::State &state)
+{
+    int N = state.range(0), M = state.range(1);
+    FX1 option(0.5, 75., 75., 0.3, 0.05, 0.5 / M, 2. / (N - 1), N, M);
+    option.set_scheme(FX_scheme::crank_nicolson);
+
+    for (auto _ : state)
+    {
+        std::ostringstream text;
+        text << option.get_data_and_premium();
+        benchmark::DoNotOptimize(text.str().size());
+    }
+
+    state.SetBytesProcessed(state.iterations() * 2 * sizeof(double) * static_cast<std::int64_t>(N) * M);
+}
+BENCHMARK(BM_FX1_text_grid)
+    ->ArgNames({"N", "M"})
+    ->Args({401, 1000})
+    ->Unit(benchmark::kMillisecond);
+
+// IR takes (forward rates N, simulations M, threads); a cap on 6-month rates
+static void BM_IR(benchmark::State &state)
+{
+    IR cap(1e6, 0.05, 0.5, 0.15, 0.5, state.range(0), state.range(1), true);
+    cap.set_threads(state.range(2));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(cap.get_simulation_data());
+
+    state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(0) * state.range(1));
+}
+BENCHMARK(BM_IR)
+    ->ArgNames({"N", "M", "threads"})
+    ->ArgsProduct({{8, 40, 120}, {10000}, {1, 4}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+static void BM_CR1(benchmark::State &state)
+{
+    CR1 firm(1., 70., 100., 0.2, 0.05, state.range(0), state.range(1));
+    firm.set_threads(state.range(2));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(firm.get_payoff_and_defaults());
+
+    set_path_steps(state);
+}
+BENCHMARK(BM_CR1)->Apply(engine_args);
+
+// CR2 takes N; with T = 10 its loop runs over 10 N dates
+static void BM_CR2(benchmark::State &state)
+{
+    CR2 cds(10., state.range(0), 100., 0.05, 0.01, 0.4);
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(cds.get_pv_premium_and_default_legs_and_cds_spread());
+
+    state.SetItemsProcessed(state.iterations() * 10 * state.range(0));
+}
+BENCHMARK(BM_CR2)->ArgName("N")->Arg(4)->Arg(12)->Arg(52);
+
+// Batched CDS: trades on one quarterly 10-year schedule, six hazard knots
+static void BM_CdsBatchPricer(benchmark::State &state)
+{
+    std::size_t n_trades = state.range(0);
+    std::vector<double> knots{1, 2, 3, 5, 7, 10};
+
+    CdsBatchPricer pricer(PiecewiseFlatCurve(0.03), cds_payment_times(10., 4), knots);
+    matrix<double> hazards(n_trades, knots.size(), matrix_layout::row_major, 0.02);
+    std::vector<double> recovery(n_trades, 0.4), notional(n_trades, 1e6);
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(pricer.price(hazards, recovery, notional));
+
+    state.SetItemsProcessed(state.iterations() * n_trades);
+}
+BENCHMARK(BM_CdsBatchPricer)->ArgName("trades")->Arg(1000)->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+// 50 strikes priced on one path set: simulated for each strike (0), or
+// written once to a scenario file and priced off the mapping (1)
+static void BM_EQ1_strikes(benchmark::State &state)
+{
+    EQ1 eq1(1., 100., 100., 0.2, 0.05, 250, 100000);
+    bool from_file = state.range(0);
+    std::string path = "bm_eq1_scenarios.wab";
+
+    for (auto _ : state)
+    {
+        EQ1 pricer = eq1;
+        if (from_file)
+        {
+            eq1.write_scenarios(path);
+            pricer.set_scenarios(std::make_shared<ScenarioSet>(path));
+        }
+
+        for (int k = 0; k < 50; ++k)
+        {
+            pricer.set_strike(80. + k);
+            benchmark::DoNotOptimize(pricer.get_premium());
+        }
+    }
+
+    std::remove(path.c_str());
+}
+BENCHMARK(BM_EQ1_strikes)->ArgName("scenarios")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+// Longstaff-Schwartz put with `dates` evenly spaced exercise dates on 250 steps
+static void BM_EQ1_bermudan(benchmark::State &state)
+{
+    EQ1 eq1(1., 100., 100., 0.2, 0.05, 250, 100000);
+    eq1.set_payoff(std::make_shared<PutPayoff>(100.));
+
+    int dates = state.range(0);
+    std::vector<double> times(dates);
+    for (int d = 0; d < dates; ++d)
+        times[d] = (d + 1.) / dates;
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(eq1.get_bermudan_premium(times));
+}
+BENCHMARK(BM_EQ1_bermudan)->ArgName("dates")->Arg(4)->Arg(50)->Arg(250)->Unit(benchmark::kMillisecond);
+
+// One-factor portfolio of 10k obligors; engine 1 is the recursion, 0 Monte Carlo
+static void BM_CreditPortfolio(benchmark::State &state)
+{
+    std::size_t n = state.range(0);
+    std::vector<double> pd(n), exposure(n), recovery(n, 0.4);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        pd[i] = 0.002 + 0.02 * (i % 10) / 9.;
+        exposure[i] = 1. + i % 5;
+    }
+
+    CreditPortfolio portfolio(pd, exposure, recovery, 0.2);
+    portfolio.set_engine(static_cast<PricingEngine>(state.range(1)));
+    portfolio.set_confidence(0.999);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(portfolio.get_loss_distribution());
+}
+BENCHMARK(BM_CreditPortfolio)
+    ->ArgNames({"obligors", "engine"})
+    ->ArgsProduct({{10000}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -1,20 +1,214 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <pybind11/numpy.h>
 #include <pybind11/operators.h>
 
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "analytic.hpp"
+#include "cache.hpp"
 #include "equity.hpp"
+#include "greeks.hpp"
+#include "payoff.hpp"
+#include "statistics.hpp"
 #include "fx.hpp"
+#include "grid_io.hpp"
+#include "instrumentation.hpp"
 #include "rates.hpp"
+#include "scenario.hpp"
 #include "credit.hpp"
+#include "cds.hpp"
+#include "portfolio.hpp"
 #include "random.hpp"
 #include "linalg.hpp"
+#include "correlation.hpp"
+#include "qmc.hpp"
+#include "simd.hpp"
+#include "variance_reduction.hpp"
 
 namespace py = pybind11;
 
+namespace
+{
+    // Getter returning a 1-D numpy view of a vector member; the array keeps
+    // the owning Python object alive. Assigning the attribute replaces the
+    // vector, which invalidates views taken before.
+    template <class Owner>
+    auto vector_view(std::vector<double> Owner::*member)
+    {
+        return [member](py::object owner)
+        {
+            std::vector<double> &values = owner.cast<Owner &>().*member;
+            return py::array_t<double>({static_cast<py::ssize_t>(values.size())},
+                                       {static_cast<py::ssize_t>(sizeof(double))}, values.data(), owner);
+        };
+    }
+
+    template <class Owner>
+    auto vector_setter(std::vector<double> Owner::*member)
+    {
+        return [member](Owner &owner, std::vector<double> values)
+        { owner.*member = std::move(values); };
+    }
+}
+
 PYBIND11_MODULE(wab_advanced_qf_py, m)
 {
     m.doc() = "Python bindings for WAB Advanced Quantitative Finance Library";
 
+    // ========== Payoffs ==========
+    py::enum_<PathStatistic>(m, "PathStatistic", py::arithmetic())
+        .value("terminal", path_terminal)
+        .value("maximum", path_maximum)
+        .value("minimum", path_minimum)
+        .value("average", path_average);
+
+    py::class_<PathState>(m, "PathState")
+        .def(py::init<>())
+        .def_readwrite("terminal", &PathState::terminal)
+        .def_readwrite("maximum", &PathState::maximum)
+        .def_readwrite("minimum", &PathState::minimum)
+        .def_readwrite("average", &PathState::average);
+
+    py::class_<Payoff, std::shared_ptr<Payoff>>(m, "Payoff")
+        .def("statistics", &Payoff::statistics,
+             "Bit mask of the PathStatistic values the payoff needs")
+        .def("__call__", &Payoff::operator(), py::arg("state"),
+             "Evaluate the payoff on a path state")
+        .def("terminal_slope", &Payoff::terminal_slope, py::arg("terminal"),
+             "Derivative with respect to S(T) (payoffs of the terminal value only)");
+
+    py::class_<CallPayoff, Payoff, std::shared_ptr<CallPayoff>>(m, "CallPayoff")
+        .def(py::init<double>(), py::arg("K"), "European call on the terminal value");
+
+    py::class_<PutPayoff, Payoff, std::shared_ptr<PutPayoff>>(m, "PutPayoff")
+        .def(py::init<double>(), py::arg("K"), "European put on the terminal value");
+
+    py::class_<AsianCallPayoff, Payoff, std::shared_ptr<AsianCallPayoff>>(m, "AsianCallPayoff")
+        .def(py::init<double>(), py::arg("K"), "Arithmetic-average call over the time steps");
+
+    py::class_<LookbackCallPayoff, Payoff, std::shared_ptr<LookbackCallPayoff>>(m, "LookbackCallPayoff")
+        .def(py::init<>(), "Floating-strike lookback call S(T) - min S(t)");
+
+    py::class_<UpAndOutCallPayoff, Payoff, std::shared_ptr<UpAndOutCallPayoff>>(m, "UpAndOutCallPayoff")
+        .def(py::init<double, double>(), py::arg("K"), py::arg("barrier"),
+             "Call knocked out when the path reaches the barrier");
+
+    py::class_<BasketPayoff, std::shared_ptr<BasketPayoff>>(m, "BasketPayoff")
+        .def("__call__", [](const BasketPayoff &self, py::array_t<double, py::array::c_style | py::array::forcecast> S)
+             {
+                 if (S.ndim() != 2)
+                     throw std::invalid_argument("BasketPayoff: S must have shape (assets, paths)");
+
+                 py::array_t<double> out(S.shape(1));
+                 self(S.data(), S.shape(0), S.shape(1), out.mutable_data());
+                 return out; },
+             py::arg("S"), "Payoffs of terminal values S with shape (assets, paths)");
+
+    py::class_<MaxOfAssetsPayoff, BasketPayoff, std::shared_ptr<MaxOfAssetsPayoff>>(m, "MaxOfAssetsPayoff")
+        .def(py::init<>(), "max of the assets at maturity");
+
+    py::class_<BestOfCallPayoff, BasketPayoff, std::shared_ptr<BestOfCallPayoff>>(m, "BestOfCallPayoff")
+        .def(py::init<double>(), py::arg("K"), "Call on the best-performing asset");
+
+    py::class_<WorstOfPutPayoff, BasketPayoff, std::shared_ptr<WorstOfPutPayoff>>(m, "WorstOfPutPayoff")
+        .def(py::init<double>(), py::arg("K"), "Put on the worst-performing asset");
+
+    py::class_<BasketCallPayoff, BasketPayoff, std::shared_ptr<BasketCallPayoff>>(m, "BasketCallPayoff")
+        .def(py::init<std::vector<double>, double>(), py::arg("weights"), py::arg("K"),
+             "Call on the weighted sum of the assets");
+
+    py::class_<BasketPutPayoff, BasketPayoff, std::shared_ptr<BasketPutPayoff>>(m, "BasketPutPayoff")
+        .def(py::init<std::vector<double>, double>(), py::arg("weights"), py::arg("K"),
+             "Put on the weighted sum of the assets");
+
+    // ========== Monte Carlo Estimates ==========
+    py::class_<ConfidenceInterval>(m, "ConfidenceInterval")
+        .def(py::init<>())
+        .def_readwrite("lower", &ConfidenceInterval::lower)
+        .def_readwrite("upper", &ConfidenceInterval::upper);
+
+    py::class_<MCEstimate>(m, "MCEstimate")
+        .def(py::init<>())
+        .def_readwrite("value", &MCEstimate::value)
+        .def_readwrite("standard_error", &MCEstimate::standard_error)
+        .def_readwrite("samples", &MCEstimate::samples, "Number of paths simulated")
+        .def("confidence_interval", &MCEstimate::confidence_interval, py::arg("level") = 0.95,
+             "Two-sided normal confidence interval")
+        .def("__repr__", [](const MCEstimate &e)
+             { return "MCEstimate(" + std::to_string(e.value) + " +/- " + std::to_string(e.standard_error) + ")"; });
+
+    m.def("normal_quantile", &normal_quantile, py::arg("p"),
+          "Inverse of the standard normal CDF");
+
+    py::enum_<VarianceReduction>(m, "VarianceReduction", py::arithmetic())
+        .value("none", vr_none)
+        .value("antithetic", vr_antithetic)
+        .value("moment_matching", vr_moment_matching)
+        .value("control_variate", vr_control_variate);
+
+    py::enum_<SamplingMethod>(m, "SamplingMethod")
+        .value("pseudo_random", SamplingMethod::pseudo_random)
+        .value("sobol", SamplingMethod::sobol);
+
+    py::enum_<CorrelationFactorization>(m, "CorrelationFactorization")
+        .value("cholesky", CorrelationFactorization::cholesky)
+        .value("pca", CorrelationFactorization::pca);
+
+    // ========== Closed Forms ==========
+    py::enum_<PricingEngine>(m, "PricingEngine")
+        .value("monte_carlo", PricingEngine::monte_carlo)
+        .value("analytic", PricingEngine::analytic)
+        .value("automatic", PricingEngine::automatic);
+
+    m.def("normal_cdf", &normal_cdf, py::arg("x"), "Standard normal CDF");
+    m.def("black_scholes_call", &black_scholes_call,
+          py::arg("S0"), py::arg("K"), py::arg("r"), py::arg("sigma"), py::arg("T"),
+          "Black-Scholes European call");
+    m.def("black_scholes_put", &black_scholes_put,
+          py::arg("S0"), py::arg("K"), py::arg("r"), py::arg("sigma"), py::arg("T"),
+          "Black-Scholes European put");
+    m.def("margrabe_exchange", &margrabe_exchange,
+          py::arg("S1"), py::arg("S2"), py::arg("sigma1"), py::arg("sigma2"), py::arg("rho"), py::arg("T"),
+          "Margrabe price of max(S1(T) - S2(T), 0)");
+    m.def("merton_equity", &merton_equity,
+          py::arg("V0"), py::arg("D"), py::arg("r"), py::arg("sigma"), py::arg("T"),
+          "Merton equity value: a call on the firm value struck at the debt");
+    m.def("merton_debt", &merton_debt,
+          py::arg("V0"), py::arg("D"), py::arg("r"), py::arg("sigma"), py::arg("T"),
+          "Merton debt value V0 - equity");
+    m.def("merton_default_probability", &merton_default_probability,
+          py::arg("V0"), py::arg("D"), py::arg("r"), py::arg("sigma"), py::arg("T"),
+          "Risk-neutral probability that V(T) < D");
+    m.def("black_caplet", &black_caplet,
+          py::arg("F"), py::arg("K"), py::arg("sigma"), py::arg("T"), py::arg("discount"),
+          "Black caplet on forward F fixing at T, discounted by `discount`");
+
+    py::class_<Greeks>(m, "Greeks")
+        .def(py::init<>())
+        .def_readwrite("premium", &Greeks::premium)
+        .def_readwrite("delta", &Greeks::delta)
+        .def_readwrite("gamma", &Greeks::gamma)
+        .def_readwrite("vega", &Greeks::vega)
+        .def_readwrite("rho", &Greeks::rho);
+
+    py::class_<EQ2_greeks>(m, "EQ2Greeks")
+        .def(py::init<>())
+        .def_readwrite("premium", &EQ2_greeks::premium)
+        .def_readwrite("delta1", &EQ2_greeks::delta1)
+        .def_readwrite("delta2", &EQ2_greeks::delta2)
+        .def_readwrite("gamma1", &EQ2_greeks::gamma1)
+        .def_readwrite("gamma2", &EQ2_greeks::gamma2)
+        .def_readwrite("vega1", &EQ2_greeks::vega1)
+        .def_readwrite("vega2", &EQ2_greeks::vega2)
+        .def_readwrite("rho", &EQ2_greeks::rho);
+
+    py::class_<CacheStats>(m, "CacheStats")
+        .def_readonly("hits", &CacheStats::hits, "Calls that reused a cached stage")
+        .def_readonly("misses", &CacheStats::misses, "Calls that rebuilt a stage");
+
     // ========== Equity Options ==========
     py::class_<EQ1>(m, "EQ1")
         .def(py::init<>(), "Default constructor")
@@ -23,8 +217,65 @@ PYBIND11_MODULE(wab_advanced_qf_py, m)
              py::arg("r"), py::arg("N"), py::arg("M"),
              "Constructor with parameters: T (maturity), K (strike), S0 (spot), "
              "sigma (volatility), r (risk-free rate), N (time steps), M (simulations)")
-        .def("get_premium", &EQ1::get_premium,
-             "Calculate option premium using Monte Carlo simulation");
+        .def("get_premium", &EQ1::get_premium, py::call_guard<py::gil_scoped_release>(),
+             "Calculate option premium using Monte Carlo simulation")
+        .def("get_premium_estimate", &EQ1::get_premium_estimate, py::call_guard<py::gil_scoped_release>(),
+             "Premium with its standard error and the number of paths used")
+        .def("set_engine", &EQ1::set_engine, py::arg("engine"),
+             "PricingEngine: closed form (Black-Scholes for calls and puts) or Monte Carlo")
+        .def("set_spot", &EQ1::set_spot, py::arg("S0"))
+        .def("set_strike", &EQ1::set_strike, py::arg("K"))
+        .def("set_volatility", &EQ1::set_volatility, py::arg("sigma"))
+        .def("set_rate", &EQ1::set_rate, py::arg("r"))
+        .def("set_caching", &EQ1::set_caching, py::arg("caching"),
+             "Keep simulated path states so new payoffs and strikes reuse the same paths")
+        .def("get_cache_stats", &EQ1::get_cache_stats)
+        .def("set_variance_reduction", &EQ1::set_variance_reduction, py::arg("flags"),
+             "VarianceReduction flags combined with | (control variate: Black-Scholes call)")
+        .def("set_target_error", &EQ1::set_target_error, py::arg("target_error"),
+             "Stop once the standard error reaches target_error (M is the path budget, 0 disables)")
+        .def("set_sampling", &EQ1::set_sampling, py::arg("sampling"),
+             "Pseudo-random or Sobol paths with a Brownian bridge (Sobol ignores variance reduction)")
+        .def("get_greeks", &EQ1::get_greeks, py::call_guard<py::gil_scoped_release>(),
+             "Premium, delta, gamma, vega and rho with standard errors from one simulation")
+        .def("get_premiums", [](const EQ1 &self,
+                                py::array_t<double, py::array::c_style | py::array::forcecast> maturities,
+                                py::array_t<double, py::array::c_style | py::array::forcecast> strikes)
+             {
+                 if (maturities.ndim() != 1 || strikes.ndim() != 1 || maturities.size() != strikes.size())
+                     throw std::invalid_argument("get_premiums expects 1-D maturities and strikes of equal length");
+
+                 py::array_t<double> premiums(maturities.size());
+                 const double *T = maturities.data(), *K = strikes.data();
+                 double *out = premiums.mutable_data();
+
+                 py::gil_scoped_release release;
+                 self.get_premiums(T, K, out, static_cast<std::size_t>(premiums.size()));
+
+                 return premiums;
+             },
+             py::arg("maturities"), py::arg("strikes"),
+             "Price European calls for arrays of maturities and strikes on one set of paths")
+        .def("get_bermudan_premium", &EQ1::get_bermudan_premium, py::call_guard<py::gil_scoped_release>(),
+             py::arg("exercise_times"),
+             "Longstaff-Schwartz premium of the payoff exercisable at the given times in (0, T]")
+        .def("get_american_premium", &EQ1::get_american_premium, py::call_guard<py::gil_scoped_release>(),
+             "Longstaff-Schwartz premium of the payoff exercisable after every time step")
+        .def("set_regression_paths", &EQ1::set_regression_paths, py::arg("paths"),
+             "Paths fitting the early-exercise rule, apart from the M priced (0 uses M)")
+        .def("set_seed", &EQ1::set_seed, py::arg("seed"),
+             "Set the seed of the per-path random streams")
+        .def("set_threads", &EQ1::set_threads, py::arg("threads"),
+             "Number of simulation threads (0 = all hardware threads)")
+        .def("set_payoff", [](EQ1 &self, std::shared_ptr<Payoff> payoff)
+             { self.set_payoff(std::move(payoff)); },
+             py::arg("payoff"), "Price another payoff on the same paths (None restores the call on K)")
+        .def("write_scenarios", &EQ1::write_scenarios, py::call_guard<py::gil_scoped_release>(),
+             py::arg("path"), py::arg("full_paths") = false,
+             "Simulate the paths get_premium would and write them to a scenario file")
+        .def("set_scenarios", [](EQ1 &self, std::shared_ptr<ScenarioSet> scenarios)
+             { self.set_scenarios(std::move(scenarios)); },
+             py::arg("scenarios"), "Price off a ScenarioSet instead of simulating (None simulates again)");
 
     py::class_<EQ2>(m, "EQ2")
         .def(py::init<>(), "Default constructor")
@@ -35,8 +286,57 @@ PYBIND11_MODULE(wab_advanced_qf_py, m)
              "Constructor for two-asset option: T (maturity), r (risk-free rate), "
              "S10/S20 (initial spots), sigma1/sigma2 (volatilities), "
              "rho (correlation), N (time steps), M (simulations)")
-        .def("get_premium", &EQ2::get_premium,
-             "Calculate two-asset option premium using Monte Carlo simulation");
+        .def("get_premium", &EQ2::get_premium, py::call_guard<py::gil_scoped_release>(),
+             "Calculate two-asset option premium using Monte Carlo simulation")
+        .def("get_premium_estimate", &EQ2::get_premium_estimate, py::call_guard<py::gil_scoped_release>(),
+             "Premium with its standard error and the number of paths used")
+        .def("set_engine", &EQ2::set_engine, py::arg("engine"),
+             "PricingEngine: closed form (S2(0) plus Margrabe) or Monte Carlo")
+        .def("set_variance_reduction", &EQ2::set_variance_reduction, py::arg("flags"),
+             "VarianceReduction flags combined with | (control variate: geometric average)")
+        .def("set_target_error", &EQ2::set_target_error, py::arg("target_error"),
+             "Stop once the standard error reaches target_error (M is the path budget, 0 disables)")
+        .def("set_sampling", &EQ2::set_sampling, py::arg("sampling"),
+             "Pseudo-random or Sobol paths with a Brownian bridge (Sobol ignores variance reduction)")
+        .def("get_greeks", &EQ2::get_greeks, py::call_guard<py::gil_scoped_release>(),
+             "Premium and per-asset Greeks with standard errors from one simulation")
+        .def("set_seed", &EQ2::set_seed, py::arg("seed"),
+             "Set the seed of the per-path random streams")
+        .def("set_threads", &EQ2::set_threads, py::arg("threads"),
+             "Number of simulation threads (0 = all hardware threads)")
+        .def("write_scenarios", &EQ2::write_scenarios, py::call_guard<py::gil_scoped_release>(),
+             py::arg("path"), py::arg("full_paths") = false,
+             "Simulate the paths get_premium would and write them to a scenario file")
+        .def("set_scenarios", [](EQ2 &self, std::shared_ptr<ScenarioSet> scenarios)
+             { self.set_scenarios(std::move(scenarios)); },
+             py::arg("scenarios"), "Price off a ScenarioSet instead of simulating (None simulates again)");
+
+    py::class_<EQN>(m, "EQN")
+        .def(py::init<double, double, std::vector<double>, std::vector<double>, const matrix<double> &, int, int,
+                      CorrelationFactorization, std::size_t>(),
+             py::arg("T"), py::arg("r"), py::arg("S0"), py::arg("sigma"), py::arg("correlation"),
+             py::arg("N"), py::arg("M"), py::arg("method") = CorrelationFactorization::cholesky,
+             py::arg("factors") = 0,
+             "Basket/rainbow option on len(S0) correlated assets; the correlation matrix "
+             "is factorized once (Cholesky, or PCA keeping `factors`)")
+        .def("get_premium", &EQN::get_premium, py::call_guard<py::gil_scoped_release>(),
+             "Premium of the basket payoff (default: max of the assets)")
+        .def("get_premium_estimate", &EQN::get_premium_estimate, py::call_guard<py::gil_scoped_release>(),
+             "Premium with its standard error and the number of paths used")
+        .def_property_readonly("assets", &EQN::assets)
+        .def("set_payoff", [](EQN &self, std::shared_ptr<BasketPayoff> payoff)
+             { self.set_payoff(std::move(payoff)); },
+             py::arg("payoff"), "Price another basket payoff (None restores the max of the assets)")
+        .def("set_variance_reduction", &EQN::set_variance_reduction, py::arg("flags"),
+             "Antithetic and moment-matching VarianceReduction flags")
+        .def("set_target_error", &EQN::set_target_error, py::arg("target_error"),
+             "Stop once the standard error reaches target_error (M is the path budget, 0 disables)")
+        .def("set_sampling", &EQN::set_sampling, py::arg("sampling"),
+             "Pseudo-random or Sobol paths with a Brownian bridge")
+        .def("set_seed", &EQN::set_seed, py::arg("seed"),
+             "Set the seed of the per-path random streams")
+        .def("set_threads", &EQN::set_threads, py::arg("threads"),
+             "Number of simulation threads (0 = all hardware threads)");
 
     // ========== FX Options ==========
     py::class_<result_data>(m, "FXResultData")
@@ -50,13 +350,28 @@ PYBIND11_MODULE(wab_advanced_qf_py, m)
         .def_readwrite("alpha", &result_data::alpha)
         .def_readwrite("dtau", &result_data::dtau)
         .def_readwrite("k", &result_data::k)
-        .def_readwrite("x", &result_data::x)
-        .def_readwrite("S", &result_data::S)
-        .def_readwrite("t", &result_data::t)
-        .def_readwrite("tau", &result_data::tau)
+        .def_property("x", vector_view(&result_data::x), vector_setter(&result_data::x))
+        .def_property("S", vector_view(&result_data::S), vector_setter(&result_data::S))
+        .def_property("t", vector_view(&result_data::t), vector_setter(&result_data::t))
+        .def_property("tau", vector_view(&result_data::tau), vector_setter(&result_data::tau))
         .def_readwrite("u", &result_data::u, "Option value grid")
         .def_readwrite("v", &result_data::v, "Option value grid (alternative)");
 
+    py::class_<premium_data>(m, "FXPremiumData")
+        .def(py::init<>(), "Default constructor")
+        .def_readwrite("premium", &premium_data::premium, "Premium at S0")
+        .def_readwrite("delta", &premium_data::delta, "Delta at S0")
+        .def_readwrite("gamma", &premium_data::gamma, "Gamma at S0")
+        .def_readwrite("alpha", &premium_data::alpha)
+        .def_property("S", vector_view(&premium_data::S), vector_setter(&premium_data::S), "Spot grid (numpy view)")
+        .def_property("v", vector_view(&premium_data::v), vector_setter(&premium_data::v),
+                      "Option values on the final time slice (numpy view)");
+
+    py::enum_<FX_scheme>(m, "FXScheme")
+        .value("explicit_fd", FX_scheme::explicit_fd)
+        .value("implicit_fd", FX_scheme::implicit_fd)
+        .value("crank_nicolson", FX_scheme::crank_nicolson);
+
     py::class_<FX1>(m, "FX1")
         .def(py::init<>(), "Default constructor")
         .def(py::init<double, double, double, double, double, double, double, int, int, bool>(),
@@ -66,20 +381,36 @@ PYBIND11_MODULE(wab_advanced_qf_py, m)
              "Constructor for FX option pricing using PDE: T (maturity), K (strike), "
              "S0 (spot), sigma (volatility), r (risk-free rate), dt (time step), "
              "dx (space step), N (time grid size), M (space grid size), barrier (bool)")
-        .def("get_data_and_premium", &FX1::get_data_and_premium,
+        .def("get_data_and_premium", &FX1::get_data_and_premium, py::call_guard<py::gil_scoped_release>(),
              "Calculate option premium and grid data using PDE solver")
+        .def("get_premium", &FX1::get_premium, py::call_guard<py::gil_scoped_release>(),
+             "Premium, delta and gamma at spot, keeping only two time slices")
+        .def("write_data_and_premium", &FX1::write_data_and_premium, py::arg("writer"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Stream the full grid to a GridWriter one time slice at a time; returns the premium data")
         .def("set_barrier", &FX1::set_barrier, py::arg("barrier"),
-             "Enable or disable barrier option pricing");
+             "Enable or disable barrier option pricing")
+        .def("set_scheme", &FX1::set_scheme, py::arg("scheme"),
+             "Select the time-stepping scheme (explicit needs alpha <= 0.5)")
+        .def("set_spot", &FX1::set_spot, py::arg("S0"))
+        .def("set_strike", &FX1::set_strike, py::arg("K"))
+        .def("set_volatility", &FX1::set_volatility, py::arg("sigma"))
+        .def("set_rate", &FX1::set_rate, py::arg("r"))
+        .def("set_caching", &FX1::set_caching, py::arg("caching"),
+             "Keep the final heat-equation slice so new spots and strikes skip the time stepping")
+        .def("get_cache_stats", &FX1::get_cache_stats);
 
     // ========== Interest Rates ==========
     py::class_<IR_results>(m, "IRResults")
         .def(py::init<>(), "Default constructor")
         .def(py::init<std::vector<double>&, double>(),
              py::arg("datapoints"), py::arg("value"))
-        .def_readwrite("datapoints", &IR_results::datapoints,
-                      "LIBOR simulation datapoints")
+        .def_property("datapoints", vector_view(&IR_results::datapoints), vector_setter(&IR_results::datapoints),
+                      "Per-path values (numpy view)")
         .def_readwrite("value", &IR_results::value,
-                      "Present value of cap/floor");
+                      "Present value of cap/floor")
+        .def_readwrite("estimate", &IR_results::estimate,
+                      "Present value with its standard error");
 
     py::class_<IR>(m, "IR")
         .def(py::init<>(), "Default constructor")
@@ -94,8 +425,140 @@ PYBIND11_MODULE(wab_advanced_qf_py, m)
              py::arg("K"), py::arg("alpha"), py::arg("sigma"),
              py::arg("dT"), py::arg("N"), py::arg("M"), py::arg("cap"),
              "Constructor without notional parameter")
-        .def("get_simulation_data", &IR::get_simulation_data,
-             "Run LIBOR simulations and return results");
+        .def("get_simulation_data", &IR::get_simulation_data, py::call_guard<py::gil_scoped_release>(),
+             "Run LIBOR simulations and return results")
+        .def("set_seed", &IR::set_seed, py::arg("seed"),
+             "Set the seed of the per-path random streams")
+        .def("set_threads", &IR::set_threads, py::arg("threads"),
+             "Worker threads (0 = all hardware threads); results do not depend on it")
+        .def("set_target_error", &IR::set_target_error, py::arg("target_error"),
+             "Stop once the standard error reaches target_error (M is the path budget, 0 disables)")
+        .def("set_sampling", &IR::set_sampling, py::arg("sampling"),
+             "Pseudo-random or Sobol increments with a Brownian bridge")
+        .def("set_engine", &IR::set_engine, py::arg("engine"),
+             "PricingEngine: Black caplets for caps or Monte Carlo")
+        .def("set_correlation", &IR::set_correlation, py::arg("correlation"),
+             py::arg("method") = CorrelationFactorization::pca, py::arg("factors") = 0,
+             "Multi-factor model from an (N + 1) x (N + 1) forward-rate correlation matrix")
+        .def("set_strike", &IR::set_strike, py::arg("K"))
+        .def("set_notional", &IR::set_notional, py::arg("notional"))
+        .def("set_caching", &IR::set_caching, py::arg("caching"),
+             "Keep simulated fixings so new strikes and notionals reuse the same paths")
+        .def("get_cache_stats", &IR::get_cache_stats)
+        .def("write_scenarios", &IR::write_scenarios, py::call_guard<py::gil_scoped_release>(), py::arg("path"),
+             "Simulate the fixings get_simulation_data would and write them to a scenario file")
+        .def("set_scenarios", [](IR &self, std::shared_ptr<ScenarioSet> scenarios)
+             { self.set_scenarios(std::move(scenarios)); },
+             py::arg("scenarios"), "Value a ScenarioSet's fixings instead of simulating (None simulates again)");
+
+    // ========== Binary Grid Files ==========
+    py::enum_<GridDtype>(m, "GridDtype")
+        .value("float64", GridDtype::float64)
+        .value("float32", GridDtype::float32);
+
+    py::enum_<GridCodec>(m, "GridCodec")
+        .value("none", GridCodec::none)
+        .value("zlib", GridCodec::zlib);
+
+    m.def("grid_compression_available", &grid_compression_available,
+          "Whether the library was built with zlib");
+
+    py::class_<GridArrayInfo>(m, "GridArrayInfo")
+        .def_readonly("name", &GridArrayInfo::name)
+        .def_readonly("dtype", &GridArrayInfo::dtype)
+        .def_readonly("codec", &GridArrayInfo::codec)
+        .def_readonly("rows", &GridArrayInfo::rows, "Values per slice")
+        .def_readonly("cols", &GridArrayInfo::cols, "Number of slices");
+
+    py::class_<GridWriter>(m, "GridWriter")
+        .def(py::init<const std::string &, GridCodec>(), py::arg("path"), py::arg("codec") = GridCodec::none,
+             "Create (or truncate) a binary grid file")
+        .def("declare", &GridWriter::declare, py::arg("name"), py::arg("slice_size"),
+             py::arg("dtype") = GridDtype::float64, "New array to append slices to; returns its id")
+        .def("append", [](GridWriter &self, std::size_t id, py::array_t<double, py::array::c_style | py::array::forcecast> values)
+             {
+                 // GridWriter::append reads the declared slice_size values
+                 if (values.ndim() != 1 || static_cast<std::size_t>(values.size()) != self.info(id).rows)
+                     throw std::invalid_argument("GridWriter.append expects a 1-D array of slice_size values");
+
+                 self.append(id, values.data()); },
+             py::arg("id"), py::arg("values"), "Append one slice (slice_size values)")
+        .def("write", [](GridWriter &self, const std::string &name, py::array_t<double, py::array::f_style | py::array::forcecast> values, GridDtype dtype)
+             {
+                 if (values.ndim() > 2)
+                     throw std::invalid_argument("GridWriter.write expects a 1-D or 2-D array");
+
+                 // Columns of a 2-D array are the slices
+                 std::size_t rows = values.ndim() == 0 ? 1 : values.shape(0);
+                 std::size_t cols = values.ndim() == 2 ? values.shape(1) : 1;
+
+                 std::size_t id = self.declare(name, rows, dtype);
+                 for (std::size_t j = 0; j < cols; ++j)
+                     self.append(id, values.data() + j * rows); },
+             py::arg("name"), py::arg("values"), py::arg("dtype") = GridDtype::float64,
+             "Write a whole array; the columns of a 2-D array become its slices")
+        .def("info", &GridWriter::info, py::arg("id"), py::return_value_policy::copy,
+             "Declared array id; rows is its slice_size")
+        .def("flush", &GridWriter::flush)
+        .def("close", &GridWriter::close)
+        .def("__enter__", [](GridWriter &self) -> GridWriter & { return self; }, py::return_value_policy::reference)
+        .def("__exit__", [](GridWriter &self, py::args)
+             { self.close(); });
+
+    py::class_<GridReader>(m, "GridReader")
+        .def(py::init<const std::string &>(), py::arg("path"), "Memory-map a binary grid file")
+        .def("arrays", &GridReader::arrays)
+        .def("__contains__", &GridReader::contains, py::arg("name"))
+        .def("info", &GridReader::info, py::arg("name"), py::return_value_policy::copy)
+        .def("view", [](py::object self, const std::string &name)
+             {
+                 matrix_view<const double> v = self.cast<const GridReader &>().view(name);
+                 py::ssize_t item = sizeof(double);
+
+                 // The mapping is read-only, and the array keeps the reader alive
+                 py::array_t<double> result({static_cast<py::ssize_t>(v.rows()), static_cast<py::ssize_t>(v.cols())},
+                                            {item * v.row_stride(), item * v.col_stride()}, v.data(), self);
+                 result.attr("setflags")(py::arg("write") = false);
+                 return result; },
+             py::arg("name"), "Read-only numpy view of an uncompressed float64 array, without copying")
+        .def("read", &GridReader::read, py::arg("name"), "Decoded copy; slice j is column j")
+        .def("read_vector", &GridReader::read_vector, py::arg("name"), "Every slice, one after the other")
+        .def("read_scalar", &GridReader::read_scalar, py::arg("name"));
+
+    m.def("write_result_data", &write_result_data, py::arg("writer"), py::arg("grid"),
+          "Write an FX1 grid to a GridWriter");
+    m.def("read_result_data", &read_result_data, py::arg("reader"),
+          "Read an FX1 grid written by write_result_data or FX1.write_data_and_premium");
+    m.def("write_datapoints", &write_datapoints, py::arg("writer"), py::arg("results"),
+          "Write IR per-path values and the estimate to a GridWriter");
+    m.def("read_datapoints", &read_datapoints, py::arg("reader"),
+          "Read IR results written by write_datapoints");
+
+    // ========== Scenario Files ==========
+    py::enum_<ScenarioEngine>(m, "ScenarioEngine")
+        .value("EQ1", ScenarioEngine::EQ1)
+        .value("EQ2", ScenarioEngine::EQ2)
+        .value("CR1", ScenarioEngine::CR1)
+        .value("IR", ScenarioEngine::IR);
+
+    py::class_<ScenarioSet, std::shared_ptr<ScenarioSet>>(m, "ScenarioSet")
+        .def(py::init<const std::string &>(), py::arg("path"), "Memory-map a scenario file")
+        .def_property_readonly("engine", &ScenarioSet::engine)
+        .def_property_readonly("key", &ScenarioSet::key, "Inputs the paths depend on")
+        .def_property_readonly("paths", &ScenarioSet::paths)
+        .def_property_readonly("chunks", &ScenarioSet::chunks)
+        .def("chunk_paths", &ScenarioSet::chunk_paths, py::arg("chunk"))
+        .def("__contains__", &ScenarioSet::contains, py::arg("name"))
+        .def("chunk", [](py::object self, const std::string &name, std::size_t chunk)
+             {
+                 const auto &scenarios = self.cast<const ScenarioSet &>();
+                 std::size_t values = scenarios.chunk_values(name, chunk);
+
+                 py::array_t<double> result({static_cast<py::ssize_t>(values)}, {static_cast<py::ssize_t>(sizeof(double))},
+                                            scenarios.chunk(name, chunk), self);
+                 result.attr("setflags")(py::arg("write") = false);
+                 return result; },
+             py::arg("name"), py::arg("chunk"), "Read-only numpy view of one chunk of an array, without copying");
 
     // ========== Credit Risk ==========
     py::class_<CR1_results>(m, "CR1Results")
@@ -103,7 +566,11 @@ PYBIND11_MODULE(wab_advanced_qf_py, m)
         .def_readwrite("equity_payoff", &CR1_results::equity_payoff,
                       "Expected equity payoff")
         .def_readwrite("percentage_defaults", &CR1_results::percentage_defaults,
-                      "Percentage of default scenarios");
+                      "Percentage of default scenarios")
+        .def_readwrite("equity_payoff_estimate", &CR1_results::equity_payoff_estimate,
+                      "Equity payoff with its standard error")
+        .def_readwrite("percentage_defaults_estimate", &CR1_results::percentage_defaults_estimate,
+                      "Percentage of default scenarios with its standard error");
 
     py::class_<CR2_results>(m, "CR2Results")
         .def(py::init<>(), "Default constructor")
@@ -121,8 +588,27 @@ PYBIND11_MODULE(wab_advanced_qf_py, m)
              py::arg("r"), py::arg("N"), py::arg("M"),
              "Merton model for credit risk: T (maturity), D (debt), V0 (firm value), "
              "sigma (volatility), r (risk-free rate), N (time steps), M (simulations)")
-        .def("get_payoff_and_defaults", &CR1::get_payoff_and_defaults,
-             "Calculate equity payoff and default percentage");
+        .def("get_payoff_and_defaults", &CR1::get_payoff_and_defaults, py::call_guard<py::gil_scoped_release>(),
+             "Calculate equity payoff and default percentage")
+        .def("set_engine", &CR1::set_engine, py::arg("engine"),
+             "PricingEngine: closed form (Merton equity and survival probability) or Monte Carlo")
+        .def("set_variance_reduction", &CR1::set_variance_reduction, py::arg("flags"),
+             "VarianceReduction flags combined with | (control variate: Black-Scholes call on V)")
+        .def("set_target_error", &CR1::set_target_error, py::arg("target_error"),
+             "Stop once the equity payoff's standard error reaches target_error (M is the path budget)")
+        .def("get_greeks", &CR1::get_greeks, py::call_guard<py::gil_scoped_release>(),
+             "Equity value and its sensitivities to V0, sigma and r, with standard errors")
+        .def("set_seed", &CR1::set_seed, py::arg("seed"),
+             "Set the seed of the per-path random streams")
+        .def("set_threads", &CR1::set_threads, py::arg("threads"),
+             "Number of simulation threads (0 = all hardware threads)")
+        .def("set_debt", &CR1::set_debt, py::arg("D"))
+        .def("write_scenarios", &CR1::write_scenarios, py::call_guard<py::gil_scoped_release>(),
+             py::arg("path"), py::arg("full_paths") = false,
+             "Simulate the firm-value paths and write them to a scenario file")
+        .def("set_scenarios", [](CR1 &self, std::shared_ptr<ScenarioSet> scenarios)
+             { self.set_scenarios(std::move(scenarios)); },
+             py::arg("scenarios"), "Price off a ScenarioSet instead of simulating (None simulates again)");
 
     py::class_<CR2>(m, "CR2")
         .def(py::init<>(), "Default constructor")
@@ -132,16 +618,246 @@ PYBIND11_MODULE(wab_advanced_qf_py, m)
              "CDS pricing: T (maturity), N (payment periods), notional, "
              "r (risk-free rate), h (hazard rate), rr (recovery rate)")
         .def("get_pv_premium_and_default_legs_and_cds_spread",
-             &CR2::get_pv_premium_and_default_legs_and_cds_spread,
-             "Calculate PV of premium/default legs and CDS spread");
+             &CR2::get_pv_premium_and_default_legs_and_cds_spread, py::call_guard<py::gil_scoped_release>(),
+             "Calculate PV of premium/default legs and CDS spread")
+        .def("set_notional", &CR2::set_notional, py::arg("notional"))
+        .def("set_rate", &CR2::set_rate, py::arg("r"))
+        .def("set_hazard_rate", &CR2::set_hazard_rate, py::arg("h"))
+        .def("set_recovery_rate", &CR2::set_recovery_rate, py::arg("rr"))
+        .def("set_caching", &CR2::set_caching, py::arg("caching"),
+             "Keep discount factors and survival probabilities between calls")
+        .def("get_cache_stats", &CR2::get_cache_stats);
+
+    py::class_<PiecewiseFlatCurve>(m, "PiecewiseFlatCurve")
+        .def(py::init<double>(), py::arg("rate"), "Flat curve")
+        .def(py::init<std::vector<double>, std::vector<double>>(),
+             py::arg("times"), py::arg("rates"),
+             "rates[k] applies up to times[k]; the last rate continues past the last time")
+        .def("integral", &PiecewiseFlatCurve::integral, py::arg("t"), "Integral of the rate over [0, t]")
+        .def("factor", &PiecewiseFlatCurve::factor, py::arg("t"), "exp(-integral(t)): discount factor or survival probability")
+        .def_property_readonly("knots", &PiecewiseFlatCurve::knots)
+        .def_property_readonly("values", &PiecewiseFlatCurve::values);
+
+    m.def("cds_payment_times", &cds_payment_times, py::arg("maturity"), py::arg("payments_per_year") = 4,
+          "CDS premium dates, with a short last period if maturity is off the grid");
+
+    py::class_<CdsBatchResults>(m, "CdsBatchResults")
+        .def_property_readonly("pv_premium_leg", vector_view(&CdsBatchResults::pv_premium_leg))
+        .def_property_readonly("pv_default_leg", vector_view(&CdsBatchResults::pv_default_leg))
+        .def_property_readonly("cds_spread_in_bps", vector_view(&CdsBatchResults::cds_spread_in_bps));
+
+    py::class_<CdsBatchPricer>(m, "CdsBatchPricer")
+        .def(py::init<const PiecewiseFlatCurve &, std::vector<double>, std::vector<double>>(),
+             py::arg("discount_curve"), py::arg("payment_times"), py::arg("hazard_times"),
+             "CDS legs for many trades on one premium schedule, hazard curves on shared knots")
+        .def("price", py::overload_cast<const matrix<double> &, const std::vector<double> &, const std::vector<double> &>(&CdsBatchPricer::price, py::const_),
+             py::call_guard<py::gil_scoped_release>(),
+             py::arg("hazards"), py::arg("recovery"), py::arg("notional"),
+             "Legs and spreads; hazards has one row per trade and one column per hazard knot")
+        .def_property_readonly("periods", &CdsBatchPricer::periods);
+
+    m.def("bootstrap_hazard_curve", &bootstrap_hazard_curve, py::call_guard<py::gil_scoped_release>(),
+          py::arg("discount_curve"), py::arg("tenors"), py::arg("spreads_in_bps"),
+          py::arg("recovery"), py::arg("payments_per_year") = 4,
+          "Piecewise-flat hazard curve repricing CDS quotes at the tenors");
+
+    m.def("hazard_default_probability", py::overload_cast<double, double>(&hazard_default_probability),
+          py::arg("h"), py::arg("T"), "1 - exp(-h T): default probability under a flat hazard rate");
+    m.def("hazard_default_probability", py::overload_cast<const PiecewiseFlatCurve &, double>(&hazard_default_probability),
+          py::arg("hazard"), py::arg("T"), "Default probability by T under a hazard curve");
+
+    py::class_<PortfolioLossResults>(m, "PortfolioLossResults")
+        .def_property_readonly("loss", vector_view(&PortfolioLossResults::loss),
+                               "Increasing loss levels (numpy view)")
+        .def_property_readonly("probability", vector_view(&PortfolioLossResults::probability),
+                               "Probability of each loss level (numpy view)")
+        .def_readonly("expected_loss", &PortfolioLossResults::expected_loss)
+        .def_readonly("value_at_risk", &PortfolioLossResults::value_at_risk)
+        .def_readonly("expected_shortfall", &PortfolioLossResults::expected_shortfall)
+        .def_readonly("expected_defaults", &PortfolioLossResults::expected_defaults)
+        .def_readonly("expected_loss_estimate", &PortfolioLossResults::expected_loss_estimate,
+                      "Monte Carlo only: expected loss with its standard error")
+        .def("quantile", &PortfolioLossResults::quantile, py::arg("level"),
+             "Smallest loss with P(L <= loss) >= level")
+        .def("shortfall", &PortfolioLossResults::shortfall, py::arg("level"),
+             "Mean of the worst 1 - level of outcomes")
+        .def("tranche_loss", &PortfolioLossResults::tranche_loss, py::arg("attachment"), py::arg("detachment"),
+             "Expected loss of the tranche between attachment and detachment");
+
+    py::class_<CreditPortfolio>(m, "CreditPortfolio")
+        .def(py::init<std::vector<double>, std::vector<double>, std::vector<double>, double>(),
+             py::arg("default_probability"), py::arg("exposure"), py::arg("recovery"), py::arg("rho"),
+             "One-factor Gaussian copula portfolio with asset correlation rho")
+        .def(py::init<std::vector<double>, std::vector<double>, std::vector<double>, matrix<double>>(),
+             py::arg("default_probability"), py::arg("exposure"), py::arg("recovery"), py::arg("loadings"),
+             "Multi-factor Gaussian copula portfolio; loadings has one row per obligor")
+        .def("get_loss_distribution", &CreditPortfolio::get_loss_distribution,
+             py::call_guard<py::gil_scoped_release>(),
+             "Loss distribution with expected loss, VaR and expected shortfall")
+        .def("set_engine", &CreditPortfolio::set_engine, py::arg("engine"),
+             "PricingEngine: recursion over obligors with factor quadrature, or Monte Carlo")
+        .def("set_confidence", &CreditPortfolio::set_confidence, py::arg("confidence"),
+             "VaR and expected shortfall level, e.g. 0.999")
+        .def("set_scenarios", &CreditPortfolio::set_scenarios, py::arg("M"))
+        .def("set_seed", &CreditPortfolio::set_seed, py::arg("seed"))
+        .def("set_threads", &CreditPortfolio::set_threads, py::arg("threads"),
+             "Number of threads (0 = all hardware threads)")
+        .def("set_quadrature_nodes", &CreditPortfolio::set_quadrature_nodes, py::arg("nodes"),
+             "Quadrature nodes per factor (0 = default)")
+        .def("set_loss_unit", &CreditPortfolio::set_loss_unit, py::arg("loss_unit"),
+             "Loss grid spacing of the recursion (0 = total loss / 2000)")
+        .def_property_readonly("obligors", &CreditPortfolio::obligors)
+        .def_property_readonly("factors", &CreditPortfolio::factors);
 
     // ========== Random Number Generation ==========
+    m.attr("default_rng_seed") = default_rng_seed;
+
     py::class_<SampleBoxMuller>(m, "SampleBoxMuller")
         .def(py::init<>(), "Box-Muller random number generator")
+        .def(py::init<std::uint64_t, std::uint64_t>(),
+             py::arg("seed"), py::arg("stream") = 0,
+             "Box-Muller generator on a seeded Philox stream")
         .def("__call__", &SampleBoxMuller::operator(),
              "Generate a standard normal random variable");
 
+    py::class_<NormalGenerator>(m, "NormalGenerator")
+        .def(py::init<>(), "Counter-based normal generator with the default seed")
+        .def(py::init<std::uint64_t, std::uint64_t>(),
+             py::arg("seed"), py::arg("stream") = 0,
+             "Counter-based normal generator: seed, stream (independent substream id)")
+        .def("__call__", &NormalGenerator::operator(),
+             "Generate a standard normal random variable")
+        .def("fill", [](NormalGenerator &self, py::array_t<double, py::array::c_style> out)
+             {
+                 auto buffer = out.mutable_unchecked<1>();
+                 self.fill(buffer.mutable_data(0), static_cast<std::size_t>(buffer.shape(0)));
+             },
+             py::arg("out").noconvert(), "Fill a contiguous float64 array with the next normals")
+        .def("skip_ahead", &NormalGenerator::skip_ahead, py::arg("n"),
+             "Skip the next n normals")
+        .def("split", &NormalGenerator::split, py::arg("stream"),
+             "Generator on another stream with the same seed")
+        .def_property_readonly("position", &NormalGenerator::get_position,
+                               "Index of the next normal in the stream");
+
+    // ========== SIMD Dispatch ==========
+    py::enum_<SimdLevel>(m, "SimdLevel")
+        .value("scalar", SimdLevel::scalar)
+        .value("avx2", SimdLevel::avx2)
+        .value("avx512", SimdLevel::avx512);
+
+    m.def("detected_simd_level", &detected_simd_level,
+          "Best instruction set supported by this CPU");
+    m.def("active_simd_level", &active_simd_level,
+          "Instruction set currently used by the Monte Carlo kernels");
+    m.def("set_simd_level", &set_simd_level, py::arg("level"),
+          "Limit the Monte Carlo kernels to an instruction set (results do not change)");
+
     // ========== Linear Algebra Utilities ==========
+    py::enum_<matrix_layout>(m, "MatrixLayout")
+        .value("row_major", matrix_layout::row_major)
+        .value("column_major", matrix_layout::column_major);
+
+    // Exposes the buffer protocol: numpy.asarray(matrix) is a view, not a copy
+    py::class_<matrix<double>>(m, "Matrix", py::buffer_protocol())
+        .def(py::init<>(), "Empty matrix")
+        .def(py::init<std::size_t, std::size_t, matrix_layout>(),
+             py::arg("rows"), py::arg("cols"), py::arg("layout") = matrix_layout::row_major,
+             "Zero matrix with the given shape and storage layout")
+        .def(py::init([](py::array_t<double> array, matrix_layout layout)
+                      {
+                          if (array.ndim() != 2)
+                              throw std::invalid_argument("Matrix expects a 2-D array");
+
+                          auto values = array.unchecked<2>();
+                          matrix<double> result(values.shape(0), values.shape(1), layout);
+                          for (py::ssize_t i = 0; i < values.shape(0); ++i)
+                              for (py::ssize_t j = 0; j < values.shape(1); ++j)
+                                  result(i, j) = values(i, j);
+                          return result; }),
+             py::arg("array"), py::arg("layout") = matrix_layout::row_major,
+             "Copy a 2-D array into a new matrix")
+        .def(py::init([](const std::vector<std::vector<double>> &rows)
+                      {
+                          std::size_t n_cols = rows.empty() ? 0 : rows[0].size();
+                          matrix<double> result(rows.size(), n_cols);
+                          for (std::size_t i = 0; i < rows.size(); ++i)
+                          {
+                              if (rows[i].size() != n_cols)
+                                  throw std::invalid_argument("Matrix rows must have equal length");
+                              for (std::size_t j = 0; j < n_cols; ++j)
+                                  result(i, j) = rows[i][j];
+                          }
+                          return result; }),
+             py::arg("rows"), "Copy a list of rows into a new matrix")
+        .def_buffer([](matrix<double> &a) -> py::buffer_info
+                    {
+                        py::ssize_t item = sizeof(double);
+                        return py::buffer_info(a.data(), item, py::format_descriptor<double>::format(), 2,
+                                               {static_cast<py::ssize_t>(a.rows()), static_cast<py::ssize_t>(a.cols())},
+                                               {item * a.row_stride(), item * a.col_stride()}); })
+        .def_property_readonly("shape", [](const matrix<double> &a)
+                               { return py::make_tuple(a.rows(), a.cols()); })
+        .def_property_readonly("layout", &matrix<double>::layout)
+        .def("__len__", &matrix<double>::rows)
+        .def("__getitem__", [](py::object self, std::size_t i)
+             {
+                 auto &a = self.cast<matrix<double> &>();
+                 if (i >= a.rows())
+                     throw py::index_error();
+                 return py::array_t<double>({static_cast<py::ssize_t>(a.cols())},
+                                            {static_cast<py::ssize_t>(sizeof(double)) * a.col_stride()},
+                                            &a(i, 0), self); },
+             py::arg("i"), "Row i as a numpy view")
+        .def("__getitem__", [](const matrix<double> &a, std::pair<std::size_t, std::size_t> ij)
+             {
+                 if (ij.first >= a.rows() || ij.second >= a.cols())
+                     throw py::index_error();
+                 return a(ij.first, ij.second); },
+             py::arg("ij"), "Element (i, j)");
+
+    py::implicitly_convertible<py::array, matrix<double>>();
+    py::implicitly_convertible<std::vector<std::vector<double>>, matrix<double>>();
+
+    py::class_<CorrelatedNormals>(m, "CorrelatedNormals")
+        .def(py::init<const matrix<double> &, CorrelationFactorization, std::size_t>(),
+             py::arg("correlation"), py::arg("method") = CorrelationFactorization::cholesky,
+             py::arg("factors") = 0,
+             "Factorize a correlation matrix once (Cholesky, or PCA keeping `factors`)")
+        .def("apply", [](const CorrelatedNormals &self, py::array_t<double, py::array::c_style | py::array::forcecast> z)
+             {
+                 if (z.ndim() != 2 || static_cast<std::size_t>(z.shape(0)) != self.factors())
+                     throw std::invalid_argument("CorrelatedNormals.apply: z must have shape (factors, n_paths)");
+
+                 std::size_t n_paths = z.shape(1);
+                 py::array_t<double> out({static_cast<py::ssize_t>(self.dimensions()), static_cast<py::ssize_t>(n_paths)});
+                 self.apply(z.data(), out.mutable_data(), n_paths);
+                 return out; },
+             py::arg("z"), "Correlated draws of shape (dimensions, n_paths) from independent z (factors, n_paths)")
+        .def_property_readonly("loadings", &CorrelatedNormals::loadings, "Loadings A with A A^T ~ correlation")
+        .def_property_readonly("dimensions", &CorrelatedNormals::dimensions)
+        .def_property_readonly("factors", &CorrelatedNormals::factors);
+
+    m.def("exponential_correlation", &exponential_correlation,
+          py::arg("dimensions"), py::arg("beta"), py::arg("spacing") = 1.,
+          "Correlation exp(-beta |i - j| spacing) of forward rates");
+
+    // ========== Instrumentation ==========
+    py::class_<InstrumentationRecord>(m, "InstrumentationRecord")
+        .def_readonly("name", &InstrumentationRecord::name)
+        .def_readonly("calls", &InstrumentationRecord::calls, "Times a timed scope was entered")
+        .def_readonly("total_ns", &InstrumentationRecord::total_ns, "Nanoseconds spent in a timed scope")
+        .def_readonly("count", &InstrumentationRecord::count, "Value of a counter")
+        .def("__repr__", [](const InstrumentationRecord &record)
+             { return "<InstrumentationRecord " + record.name + " calls=" + std::to_string(record.calls) +
+                      " total_ns=" + std::to_string(record.total_ns) + " count=" + std::to_string(record.count) + ">"; });
+
+    m.def("instrumentation_enabled", &instrumentation_enabled,
+          "Whether the library was built with WAB_INSTRUMENTATION");
+    m.def("instrumentation_report", &instrumentation_report,
+          "Timers and counters touched since the last reset, sorted by name");
+    m.def("reset_instrumentation", &reset_instrumentation, "Zero every timer and counter");
+
     m.def("matrix_creator", &matrix_creator,
           "Create a sample matrix (utility function)");
 }
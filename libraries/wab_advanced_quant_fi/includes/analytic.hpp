@@ -0,0 +1,36 @@
+#pragma once
+
+// How an engine prices a contract that has a closed form. automatic uses the
+// closed form when the contract has one and simulates otherwise; analytic
+// requires it (std::logic_error if there is none). Closed-form results come
+// back as an MCEstimate with zero standard error and zero samples.
+enum class PricingEngine
+{
+    monte_carlo,
+    analytic,
+    automatic
+};
+
+double normal_cdf(double x);
+
+// Black-Scholes price of a European call with no dividends.
+double black_scholes_call(double S0, double K, double r, double sigma, double T);
+
+double black_scholes_put(double S0, double K, double r, double sigma, double T);
+
+// Margrabe: exchange option max(S1(T) - S2(T), 0) on two correlated
+// lognormal assets, independent of r.
+double margrabe_exchange(double S1, double S2, double sigma1, double sigma2, double rho, double T);
+
+// Merton structural model: equity is a call on the firm value V0 struck at
+// the face value D of the debt, and the firm defaults if V(T) < D.
+double merton_equity(double V0, double D, double r, double sigma, double T);
+
+double merton_debt(double V0, double D, double r, double sigma, double T);
+
+// Risk-neutral probability of V(T) < D
+double merton_default_probability(double V0, double D, double r, double sigma, double T);
+
+// Black caplet on a forward rate F fixing at T, paying max(L - K, 0) (per
+// unit notional and accrual) discounted by `discount`.
+double black_caplet(double F, double K, double sigma, double T, double discount);
@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+struct CacheStats
+{
+    std::size_t hits{}, misses{};
+};
+
+// One stage of an engine's incremental repricing: an intermediate result
+// (simulated path states, a PDE slice, discount factors) kept with the
+// inputs it was built from. A stage is rebuilt only when its own key
+// changes, so moving a downstream input (a strike, a notional, the payoff,
+// the spot read off a PDE slice) reuses everything upstream.
+//
+// Engines hold stages in mutable members. Copies of an engine start with
+// empty stages, and the calling thread holds lock() while it uses a value.
+template <class Key, class Value>
+class CacheStage
+{
+public:
+    CacheStage() = default;
+
+    CacheStage(const CacheStage &) {}
+
+    CacheStage &operator=(const CacheStage &)
+    {
+        clear();
+        return *this;
+    }
+
+    std::unique_lock<std::mutex> lock() const
+    {
+        return std::unique_lock<std::mutex>(mutex);
+    }
+
+    // The value built for key; on a miss it is rebuilt by build(Value &)
+    // from a default-constructed Value.
+    template <class Build>
+    Value &fetch(const Key &key, Build build)
+    {
+        if (entry && entry->key == key)
+        {
+            ++stats.hits;
+            return entry->value;
+        }
+
+        entry.reset();
+        auto fresh = std::make_unique<Entry>(Entry{key, Value{}});
+        build(fresh->value);
+        entry = std::move(fresh);
+        ++stats.misses;
+
+        return entry->value;
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        entry.reset();
+    }
+
+    CacheStats counters() const
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        return stats;
+    }
+
+private:
+    struct Entry
+    {
+        Key key;
+        Value value;
+    };
+
+    std::unique_ptr<Entry> entry;
+    CacheStats stats;
+    mutable std::mutex mutex;
+};
+
+inline CacheStats operator+(CacheStats a, const CacheStats &b)
+{
+    return CacheStats{a.hits + b.hits, a.misses + b.misses};
+}
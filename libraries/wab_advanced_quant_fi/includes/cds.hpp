@@ -0,0 +1,111 @@
+#pragma once
+#include "linalg.hpp"
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// Piecewise-flat term structure of an instantaneous rate (short rate or
+// hazard rate): rates[k] applies on (times[k-1], times[k]], with times[-1] = 0,
+// and the last rate continues past the last time.
+class PiecewiseFlatCurve
+{
+public:
+    PiecewiseFlatCurve() = default;
+
+    explicit PiecewiseFlatCurve(double rate) : times{1.}, rates{rate} {}
+
+    // Throws std::invalid_argument unless there is at least one rate and the
+    // times are positive, increasing and as many as the rates.
+    PiecewiseFlatCurve(std::vector<double> times, std::vector<double> rates);
+
+    // Integral of the rate over [0, t]
+    double integral(double t) const;
+
+    // exp(-integral(t)): discount factor or survival probability
+    double factor(double t) const
+    {
+        return std::exp(-integral(t));
+    }
+
+    const std::vector<double> &knots() const
+    {
+        return times;
+    }
+
+    const std::vector<double> &values() const
+    {
+        return rates;
+    }
+
+private:
+    std::vector<double> times, rates;
+};
+
+// Premium dates of a CDS: every 1 / payments_per_year years up to maturity,
+// ending with a short period if maturity is not on that grid.
+std::vector<double> cds_payment_times(double maturity, int payments_per_year);
+
+struct CdsBatchResults
+{
+    std::vector<double> pv_premium_leg, pv_default_leg, cds_spread_in_bps;
+};
+
+// Legs of many CDS on one premium schedule, in the convention of CR2: the
+// premium leg is notional x sum D(t_j) dt_j Q(t_j) (the PV of a unit running
+// spread) and the default leg (1 - R) x notional x sum D(t_j) (Q(t_j-1) - Q(t_j)).
+// Discount factors and accruals are computed once per schedule. Each
+// trade's hazard curve is piecewise flat on knots shared by the batch, so
+// survival is a running product of exp(-h dt) factors with one exp per
+// distinct period shape, and the legs are accumulated across trades with
+// the SIMD kernels (bit-identical at every level).
+class CdsBatchPricer
+{
+public:
+    CdsBatchPricer() = default;
+
+    // Throws std::invalid_argument if payment_times is not increasing and
+    // positive or hazard_times is empty or not increasing.
+    CdsBatchPricer(const PiecewiseFlatCurve &discount_curve, std::vector<double> payment_times, std::vector<double> hazard_times);
+
+    // hazards(i, k): hazard rate of trade i on knot interval k, one row per
+    // trade; recovery and notional per trade.
+    CdsBatchResults price(const matrix<double> &hazards, const std::vector<double> &recovery, const std::vector<double> &notional) const;
+
+    // hazards row-major, n_trades x hazard knots
+    void price(const double *hazards, const double *recovery, const double *notional, std::size_t n_trades,
+               double *pv_premium_leg, double *pv_default_leg, double *cds_spread_in_bps) const
+    {
+        find_legs(matrix_view<const double>(hazards, n_trades, hazard_times.size(), static_cast<std::ptrdiff_t>(hazard_times.size()), 1),
+                  recovery, notional, pv_premium_leg, pv_default_leg, cds_spread_in_bps);
+    }
+
+    std::size_t periods() const
+    {
+        return pattern.size();
+    }
+
+private:
+    std::vector<double> hazard_times;
+    std::vector<double> discount, discount_accrual;
+
+    // Period j has shape pattern[j]: its overlap with knot interval k is
+    // overlap[pattern[j] * hazard_times.size() + k]
+    std::vector<std::size_t> pattern;
+    std::vector<double> overlap;
+    std::size_t n_patterns{};
+
+    void find_legs(matrix_view<const double> hazards, const double *recovery, const double *notional,
+                   double *pv_premium_leg, double *pv_default_leg, double *cds_spread_in_bps) const;
+};
+
+// Piecewise-flat hazard curve with knots at the tenors that reprices CDS
+// quoted at spreads_in_bps (CR2 convention, premium dates from
+// cds_payment_times). Each tenor is solved by Newton's method from the
+// credit-triangle guess spread / (1 - recovery), safeguarded by bisection.
+// Throws std::invalid_argument if tenors and spreads differ in length, tenors
+// are not increasing, a quote needs a negative hazard rate, or a quote is not
+// attainable: the earlier pillars already lock in more premium than any
+// hazard rate's default leg can match. Throws std::runtime_error naming the
+// pillar and the last residual if the iteration does not converge.
+PiecewiseFlatCurve bootstrap_hazard_curve(const PiecewiseFlatCurve &discount_curve, const std::vector<double> &tenors,
+                                          const std::vector<double> &spreads_in_bps, double recovery, int payments_per_year = 4);
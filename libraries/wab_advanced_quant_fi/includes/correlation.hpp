@@ -0,0 +1,69 @@
+#pragma once
+#include "linalg.hpp"
+#include <cstddef>
+#include <vector>
+
+enum class CorrelationFactorization
+{
+    cholesky,
+    pca
+};
+
+// Correlated standard normals x = A z from independent ones, with the
+// loadings A (dimensions x factors) factorized once from a correlation
+// matrix. Cholesky is exact and lower triangular; PCA keeps the `factors`
+// leading eigenvectors and rescales each row of A to unit length, so every
+// x_i keeps unit variance while the correlations are approximated.
+class CorrelatedNormals
+{
+public:
+    CorrelatedNormals() = default;
+
+    // factors == 0 keeps every factor. Throws std::invalid_argument if the
+    // matrix is not square with a unit diagonal, or (Cholesky) not positive
+    // semi-definite, and std::runtime_error if (PCA) the eigen decomposition
+    // does not converge.
+    explicit CorrelatedNormals(const matrix<double> &correlation,
+                               CorrelationFactorization method = CorrelationFactorization::cholesky,
+                               std::size_t factors = 0);
+
+    // Uses the given loadings as they are, e.g. one factor of all ones
+    static CorrelatedNormals from_loadings(const matrix<double> &loadings);
+
+    // Factor-major batches: z[f * n_paths + p] -> out[i * n_paths + p].
+    // Paths are processed in blocks small enough that z stays in L1.
+    void apply(const double *z, double *out, std::size_t n_paths) const;
+
+    std::size_t dimensions() const
+    {
+        return loadings_.rows();
+    }
+
+    std::size_t factors() const
+    {
+        return loadings_.cols();
+    }
+
+    // Row i holds the loadings of x_i; loadings()(i, f) is A(i, f)
+    const matrix<double> &loadings() const
+    {
+        return loadings_;
+    }
+
+    bool empty() const
+    {
+        return loadings_.empty();
+    }
+
+private:
+    matrix<double> loadings_;
+
+    // A(i, f) is zero for f >= row_factors[i] (Cholesky rows)
+    std::vector<std::size_t> row_factors;
+
+    void find_row_factors();
+};
+
+// rho_ij = exp(-beta |i - j| spacing), the usual parametric correlation of
+// forward rates fixing `spacing` years apart.
+matrix<double> exponential_correlation(std::size_t dimensions, double beta, double spacing = 1.);
@@ -1,4 +1,16 @@
 #pragma once
+#include "analytic.hpp"
+#include "cache.hpp"
+#include "greeks.hpp"
+#include "random.hpp"
+#include "scenario.hpp"
+#include "statistics.hpp"
+#include "variance_reduction.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
 
 class CR1_results
 {
@@ -7,6 +19,9 @@ public:
     CR1_results() = default;
 
     double equity_payoff{}, percentage_defaults{};
+
+    // The same two quantities with standard errors
+    MCEstimate equity_payoff_estimate, percentage_defaults_estimate;
 };
 
 class CR2_results
@@ -29,11 +44,75 @@ public:
         return find_payoff_and_defaults();
     }
 
+    // Sensitivities of the equity value max(V(T) - D, 0) to V0, sigma and r
+    Greeks get_greeks() const
+    {
+        return find_greeks();
+    }
+
+    void set_seed(std::uint64_t newSeed)
+    {
+        this->seed = newSeed;
+    }
+
+    void set_threads(int newThreads)
+    {
+        this->threads = newThreads;
+    }
+
+    // Stop once the equity payoff's standard error is at most newTargetError,
+    // with M as the path budget. 0 always simulates M paths.
+    void set_target_error(double newTargetError)
+    {
+        this->target_error = newTargetError;
+    }
+
+    // VarianceReduction flags; the control variate (equity payoff only) is
+    // the Black-Scholes call on V with strike D.
+    void set_variance_reduction(unsigned newVarianceReduction)
+    {
+        this->variance_reduction = newVarianceReduction;
+    }
+
+    // Closed form: Merton equity value and survival probability.
+    void set_engine(PricingEngine newEngine)
+    {
+        this->engine = newEngine;
+    }
+
+    void set_debt(double newDebt)
+    {
+        this->D = newDebt;
+    }
+
+    // Simulates the M firm-value paths get_payoff_and_defaults would and
+    // writes them to a scenario file: per chunk, "terminal" holds V(T),
+    // "brownian" the sum of each path's step normals if the control variate
+    // is on, and, with full_paths, "path" V after every step, step-major.
+    void write_scenarios(const std::string &path, bool full_paths = false) const;
+
+    // get_payoff_and_defaults prices off these scenarios instead of
+    // simulating. They must come from a CR1 with the same T, V0, sigma, r, N,
+    // M, seed and variance reduction, or it throws std::invalid_argument; the
+    // debt D is free. nullptr simulates again.
+    void set_scenarios(std::shared_ptr<const ScenarioSet> newScenarios)
+    {
+        this->scenarios = std::move(newScenarios);
+    }
+
 private:
     double T{4}, D{70}, V0{100}, sigma{0.2}, r{0.05};
     int N{500}, M{1000};
+    std::uint64_t seed{default_rng_seed};
+    int threads{1};
+    double target_error{};
+    unsigned variance_reduction{vr_none};
+    PricingEngine engine{PricingEngine::monte_carlo};
+    std::shared_ptr<const ScenarioSet> scenarios;
 
+    std::vector<double> find_scenario_key() const;
     CR1_results find_payoff_and_defaults() const;
+    Greeks find_greeks() const;
 };
 
 class CR2
@@ -48,8 +127,48 @@ public:
         return find_pv_premium_and_default_legs_and_cds_spread();
     }
 
+    void set_notional(double newNotional)
+    {
+        this->notional = newNotional;
+    }
+
+    void set_rate(double newRate)
+    {
+        this->r = newRate;
+    }
+
+    void set_hazard_rate(double newHazardRate)
+    {
+        this->h = newHazardRate;
+    }
+
+    void set_recovery_rate(double newRecoveryRate)
+    {
+        this->rr = newRecoveryRate;
+    }
+
+    // Keep the discount factors (keyed on T, N, r) and survival
+    // probabilities (T, N, h) between calls, so moving the notional,
+    // recovery or one of the two curves recomputes only what depends on it.
+    void set_caching(bool newCaching)
+    {
+        this->caching = newCaching;
+        discount_cache.clear();
+        survival_cache.clear();
+    }
+
+    CacheStats get_cache_stats() const
+    {
+        return discount_cache.counters() + survival_cache.counters();
+    }
+
 private:
     double T{1}, notional{100}, r{0.05}, h{0.01}, rr{0.5};
     int N{4};
+    bool caching{false};
+
+    using curve_key = std::tuple<double, int, double>;
+    mutable CacheStage<curve_key, std::vector<double>> discount_cache, survival_cache;
+
     CR2_results find_pv_premium_and_default_legs_and_cds_spread() const;
 };
\ No newline at end of file
@@ -1,4 +1,39 @@
 #pragma once
+#include "analytic.hpp"
+#include "cache.hpp"
+#include "correlation.hpp"
+#include "greeks.hpp"
+#include "linalg.hpp"
+#include "payoff.hpp"
+#include "qmc.hpp"
+#include "random.hpp"
+#include "scenario.hpp"
+#include "statistics.hpp"
+#include "variance_reduction.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Path states of the chunks EQ1 has simulated, so other payoffs and strikes
+// are priced on the same paths. Chunk c stays empty until it is simulated.
+struct PathStateStore
+{
+    unsigned statistics{};
+    std::vector<std::vector<PathState>> states;
+
+    // Sum of each path's step normals, for the control variate
+    std::vector<std::vector<double>> brownian;
+};
+
+// Sensitivities of max(S1(T), S2(T)); index 1 and 2 refer to the two assets.
+struct EQ2_greeks
+{
+    MCEstimate premium, delta1, delta2, gamma1, gamma2, vega1, vega2, rho;
+};
 
 class EQ1
 {
@@ -7,14 +42,181 @@ public:
     EQ1(double T, double K, double S0, double sigma, double r, int N, int M) : T(T), K(K), S0(S0), sigma(sigma), r(r), N(N), M(M) {}
 
     double get_premium() const
+    {
+        return find_premium().value;
+    }
+
+    // Premium with its standard error and number of paths used
+    MCEstimate get_premium_estimate() const
     {
         return find_premium();
     }
 
+    // Premium, delta, gamma, vega and rho from one simulation, with standard
+    // errors. Needs a payoff of S(T) only (the default call, or a put).
+    Greeks get_greeks() const
+    {
+        return find_greeks();
+    }
+
+    // European calls on this underlying (S0, sigma, r) with their own maturity
+    // and strike, all priced on one set of paths. The time grid puts about N
+    // steps on [0, max T] and hits every maturity; a single contract gets the
+    // same premium as get_premium() with that T and K.
+    std::vector<double> get_premiums(const std::vector<double> &maturities, const std::vector<double> &strikes) const;
+
+    void get_premiums(const double *maturities, const double *strikes, double *premiums, std::size_t n) const
+    {
+        find_premiums(maturities, strikes, premiums, n);
+    }
+
+    // Bermudan option on the payoff (the default call on K, or any payoff of
+    // S(t) only such as PutPayoff), exercisable at exercise_times in (0, T],
+    // each rounded to the nearest of the N time steps. Priced by
+    // Longstaff-Schwartz (lsm.hpp) on ExerciseBasis, with the standard error
+    // of the M pricing paths. The target error and the antithetic and
+    // moment-matching flags apply; sampling, caching and scenarios do not.
+    // Throws std::invalid_argument for an empty schedule, a time outside
+    // (0, T] or a path-dependent payoff.
+    MCEstimate get_bermudan_premium(const std::vector<double> &exercise_times) const;
+
+    // Exercisable after every time step
+    MCEstimate get_american_premium() const
+    {
+        std::vector<int> steps(N);
+        std::iota(steps.begin(), steps.end(), 1);
+        return find_bermudan_premium(steps);
+    }
+
+    void set_seed(std::uint64_t newSeed)
+    {
+        this->seed = newSeed;
+    }
+
+    // Paths fitting the exercise rule of Bermudan and American premiums,
+    // simulated apart from the M they are priced on; 0 uses M. The fit keeps
+    // every path's spot at every exercise date, 8 bytes each.
+    void set_regression_paths(int newRegressionPaths)
+    {
+        this->regression_paths = newRegressionPaths;
+    }
+
+    // 0 uses every hardware thread; the premium does not depend on the count.
+    void set_threads(int newThreads)
+    {
+        this->threads = newThreads;
+    }
+
+    // Stop once the premium's standard error is at most newTargetError, with M
+    // as the path budget. 0 always simulates M paths.
+    void set_target_error(double newTargetError)
+    {
+        this->target_error = newTargetError;
+    }
+
+    // VarianceReduction flags for get_premium; the control variate is the
+    // Black-Scholes call on K.
+    void set_variance_reduction(unsigned newVarianceReduction)
+    {
+        this->variance_reduction = newVarianceReduction;
+    }
+
+    // Sobol sampling with a Brownian bridge for get_premium. Its standard
+    // error comes from sobol_replications digital shifts, and variance
+    // reduction flags are ignored.
+    void set_sampling(SamplingMethod newSampling)
+    {
+        this->sampling = newSampling;
+    }
+
+    // Replaces the default European call on K; nullptr restores it.
+    void set_payoff(std::shared_ptr<const Payoff> newPayoff)
+    {
+        this->payoff = std::move(newPayoff);
+    }
+
+    // Closed form (Black-Scholes) for the call on K and for CallPayoff and
+    // PutPayoff, in get_premium and get_premiums.
+    void set_engine(PricingEngine newEngine)
+    {
+        this->engine = newEngine;
+    }
+
+    void set_spot(double newSpot)
+    {
+        this->S0 = newSpot;
+    }
+
+    void set_strike(double newStrike)
+    {
+        this->K = newStrike;
+    }
+
+    void set_volatility(double newVolatility)
+    {
+        this->sigma = newVolatility;
+    }
+
+    void set_rate(double newRate)
+    {
+        this->r = newRate;
+    }
+
+    // get_premium keeps the simulated path states (common random numbers):
+    // a new payoff, strike or target error is priced on the stored paths,
+    // simulating only chunks not seen before. The paths are keyed on T, S0,
+    // sigma, r, N, M, the seed, the sampling and the variance reduction, and
+    // take about 40 bytes each.
+    void set_caching(bool newCaching)
+    {
+        this->caching = newCaching;
+        path_cache.clear();
+    }
+
+    CacheStats get_cache_stats() const
+    {
+        return path_cache.counters();
+    }
+
+    // Simulates the M paths get_premium would and writes them to a scenario
+    // file. Per chunk, "state" holds each path's PathState (four values per
+    // path, path-major) with every statistic kept, "brownian" the sum of its
+    // step normals if the control variate is on, and, with full_paths, "path"
+    // S after every step, step-major.
+    void write_scenarios(const std::string &path, bool full_paths = false) const;
+
+    // get_premium prices off these scenarios instead of simulating. They must
+    // come from an EQ1 with the same T, S0, sigma, r, N, M, seed, sampling and
+    // variance reduction, or get_premium throws std::invalid_argument;
+    // nullptr simulates again. get_greeks and get_premiums always simulate.
+    void set_scenarios(std::shared_ptr<const ScenarioSet> newScenarios)
+    {
+        this->scenarios = std::move(newScenarios);
+    }
+
 private:
     double T{1}, K{100}, S0{100}, sigma{0.1}, r{0.05};
     int N{500}, M{10000};
-    double find_premium() const;
+    std::uint64_t seed{default_rng_seed};
+    int threads{1};
+    double target_error{};
+    unsigned variance_reduction{vr_none};
+    SamplingMethod sampling{SamplingMethod::pseudo_random};
+    std::shared_ptr<const Payoff> payoff;
+    int regression_paths{};
+    PricingEngine engine{PricingEngine::monte_carlo};
+    bool caching{false};
+
+    using path_key = std::tuple<double, double, double, double, int, int, std::uint64_t, SamplingMethod, unsigned>;
+    mutable CacheStage<path_key, PathStateStore> path_cache;
+    std::shared_ptr<const ScenarioSet> scenarios;
+
+    std::vector<double> find_scenario_key() const;
+    MCEstimate find_premium() const;
+    bool find_closed_form(MCEstimate &premium) const;
+    Greeks find_greeks() const;
+    void find_premiums(const double *maturities, const double *strikes, double *premiums, std::size_t n) const;
+    MCEstimate find_bermudan_premium(const std::vector<int> &exercise_steps) const;
 };
 
 class EQ2
@@ -24,13 +226,163 @@ public:
     EQ2(double T, double r, double S10, double S20, double sigma1, double sigma2, double rho, int N, int M) : T(T), r(r), S10(S10), S20(S20), sigma1(sigma1), sigma2(sigma2), rho(rho), N(N), M(M) {}
 
     double get_premium() const
+    {
+        return find_premium().value;
+    }
+
+    // Premium with its standard error and number of paths used
+    MCEstimate get_premium_estimate() const
     {
         return find_premium();
     }
 
+    // Throws std::invalid_argument for |rho| >= 1, where the
+    // likelihood-ratio gammas are undefined.
+    EQ2_greeks get_greeks() const
+    {
+        return find_greeks();
+    }
+
+    void set_seed(std::uint64_t newSeed)
+    {
+        this->seed = newSeed;
+    }
+
+    void set_threads(int newThreads)
+    {
+        this->threads = newThreads;
+    }
+
+    void set_target_error(double newTargetError)
+    {
+        this->target_error = newTargetError;
+    }
+
+    // VarianceReduction flags for get_premium; the control variate is the
+    // geometric average of the two assets.
+    void set_variance_reduction(unsigned newVarianceReduction)
+    {
+        this->variance_reduction = newVarianceReduction;
+    }
+
+    void set_sampling(SamplingMethod newSampling)
+    {
+        this->sampling = newSampling;
+    }
+
+    // Closed form: S2(0) plus Margrabe's exchange option on S1 for S2.
+    void set_engine(PricingEngine newEngine)
+    {
+        this->engine = newEngine;
+    }
+
+    // Simulates the M paths get_premium would and writes them to a scenario
+    // file: per chunk, "terminal" holds S1(T) and S2(T) asset-major (all S1,
+    // then all S2), "brownian" the sums of the step normals the same way if
+    // the control variate is on, and, with full_paths, "path" both assets
+    // after every step, path[(2 i + a) * paths + p].
+    void write_scenarios(const std::string &path, bool full_paths = false) const;
+
+    // get_premium prices off these scenarios instead of simulating. They must
+    // come from an EQ2 with the same inputs, seed, sampling and variance
+    // reduction, or get_premium throws std::invalid_argument. get_greeks
+    // always simulates.
+    void set_scenarios(std::shared_ptr<const ScenarioSet> newScenarios)
+    {
+        this->scenarios = std::move(newScenarios);
+    }
+
 private:
     double T{1}, r{0.05}, S10{120}, S20{100}, sigma1{0.1}, sigma2{0.15}, rho{0.5};
     int N{300}, M{1000};
+    std::uint64_t seed{default_rng_seed};
+    int threads{1};
+    double target_error{};
+    unsigned variance_reduction{vr_none};
+    SamplingMethod sampling{SamplingMethod::pseudo_random};
+    PricingEngine engine{PricingEngine::monte_carlo};
+    std::shared_ptr<const ScenarioSet> scenarios;
+
+    std::vector<double> find_scenario_key() const;
+    MCEstimate find_premium() const;
+    EQ2_greeks find_greeks() const;
+};
+
+// Basket and rainbow options on n assets under correlated GBM. Paths are
+// stored asset-major (S[a * n_paths + p]) and advanced in chunks; each step
+// draws one normal per factor and maps it to the assets with the
+// correlation factorized once at construction. With a PCA truncated to F
+// factors a step costs O(n F) per path, so work grows linearly in assets.
+class EQN
+{
+public:
+    EQN() = default;
+
+    // Throws std::invalid_argument unless S0, sigma and the correlation
+    // matrix all have one entry (row) per asset.
+    EQN(double T, double r, std::vector<double> S0, std::vector<double> sigma, const matrix<double> &correlation, int N, int M,
+        CorrelationFactorization method = CorrelationFactorization::cholesky, std::size_t factors = 0);
+
+    double get_premium() const
+    {
+        return find_premium().value;
+    }
+
+    // Premium with its standard error and number of paths used
+    MCEstimate get_premium_estimate() const
+    {
+        return find_premium();
+    }
+
+    std::size_t assets() const
+    {
+        return S0.size();
+    }
+
+    void set_seed(std::uint64_t newSeed)
+    {
+        this->seed = newSeed;
+    }
+
+    void set_threads(int newThreads)
+    {
+        this->threads = newThreads;
+    }
+
+    void set_target_error(double newTargetError)
+    {
+        this->target_error = newTargetError;
+    }
+
+    // Antithetic and moment-matching VarianceReduction flags; there is no
+    // control variate for a general basket payoff, so that flag is ignored.
+    void set_variance_reduction(unsigned newVarianceReduction)
+    {
+        this->variance_reduction = newVarianceReduction;
+    }
+
+    void set_sampling(SamplingMethod newSampling)
+    {
+        this->sampling = newSampling;
+    }
+
+    // Replaces the default max of the assets; nullptr restores it.
+    void set_payoff(std::shared_ptr<const BasketPayoff> newPayoff)
+    {
+        this->payoff = std::move(newPayoff);
+    }
+
+private:
+    double T{1}, r{0.05};
+    std::vector<double> S0, sigma;
+    int N{300}, M{1000};
+    CorrelatedNormals correlated;
+    std::uint64_t seed{default_rng_seed};
+    int threads{1};
+    double target_error{};
+    unsigned variance_reduction{vr_none};
+    SamplingMethod sampling{SamplingMethod::pseudo_random};
+    std::shared_ptr<const BasketPayoff> payoff;
 
-    double find_premium() const;
-};
\ No newline at end of file
+    MCEstimate find_premium() const;
+};
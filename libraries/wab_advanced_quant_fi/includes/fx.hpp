@@ -1,5 +1,12 @@
 #pragma once
+#include "cache.hpp"
+#include "grid_io.hpp"
 #include "linalg.hpp"
+#include <ostream>
+#include <functional>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 using vec = std::vector<double>;
 
@@ -9,7 +16,7 @@ struct result_data
 
     result_data(double alpha, double dtau, double k, vec x, vec S, vec t,
                 vec tau, matrix<double> u, matrix<double> v) : alpha(alpha),
-                                                               dtau(dtau), k(k), x(x), S(S), t(t), tau(tau), u(u), v(v)
+                                                               dtau(dtau), k(k), x(std::move(x)), S(std::move(S)), t(std::move(t)), tau(std::move(tau)), u(std::move(u)), v(std::move(v))
     {
     }
 
@@ -20,6 +27,29 @@ struct result_data
     friend std::ostream &operator<<(std::ostream &os, const result_data &rs);
 };
 
+// Binary form of a grid: scalars alpha, dtau and k, vectors x, S, t and tau,
+// then u and v with time slice j as slice j.
+void write_result_data(GridWriter &writer, const result_data &grid);
+
+result_data read_result_data(const GridReader &reader);
+
+// Final time slice only: premium, delta and gamma at S0 (quadratic
+// interpolation on the S grid), plus the slice itself.
+struct premium_data
+{
+    double premium{}, delta{}, gamma{}, alpha{};
+    vec S, v;
+};
+
+// Time stepping for the heat equation in (x, tau). The explicit scheme needs
+// alpha = dtau / dx^2 <= 0.5; implicit and Crank-Nicolson are stable for any dt.
+enum class FX_scheme
+{
+    explicit_fd,
+    implicit_fd,
+    crank_nicolson
+};
+
 class FX1
 {
 public:
@@ -32,15 +62,75 @@ public:
         return evaluate_data_and_premium();
     }
 
+    // Same scheme as get_data_and_premium, but with O(N) memory
+    premium_data get_premium() const
+    {
+        return evaluate_premium();
+    }
+
+    // get_data_and_premium streamed to writer (see write_result_data) one
+    // time slice at a time, so memory stays O(N) however large M is. Returns
+    // what get_premium would.
+    premium_data write_data_and_premium(GridWriter &writer) const;
+
     void set_barrier(bool newBarrier)
     {
         this->barrier = newBarrier;
     }
 
+    void set_scheme(FX_scheme newScheme)
+    {
+        this->scheme = newScheme;
+    }
+
+    void set_spot(double newSpot)
+    {
+        this->S0 = newSpot;
+    }
+
+    void set_strike(double newStrike)
+    {
+        this->K = newStrike;
+    }
+
+    void set_volatility(double newVolatility)
+    {
+        this->sigma = newVolatility;
+    }
+
+    void set_rate(double newRate)
+    {
+        this->r = newRate;
+    }
+
+    // get_premium keeps the last heat-equation slice, which depends only on
+    // sigma, r, the grid, the barrier and the scheme. A new spot or strike
+    // then costs one transform of the slice instead of M - 1 steps; the
+    // maturity is (M - 1) * dt, so moving it recomputes the slice.
+    void set_caching(bool newCaching)
+    {
+        this->caching = newCaching;
+        slice_cache.clear();
+    }
+
+    CacheStats get_cache_stats() const
+    {
+        return slice_cache.counters();
+    }
+
 private:
     double T{0.5}, K{75}, S0{75}, sigma{0.3}, r{0.05}, dt{0.1}, dx{0.5};
     int N{5}, M{6};
     bool barrier{false};
+    FX_scheme scheme{FX_scheme::explicit_fd};
+    bool caching{false};
+
+    using slice_key = std::tuple<double, double, double, double, int, int, bool, FX_scheme>;
+    mutable CacheStage<slice_key, vec> slice_cache;
+
+    // on_slice, if set, sees every time slice from tau_0 to the last
+    void solve_heat_slice(double alpha, double k, vec &u, const std::function<void(const vec &)> &on_slice = {}) const;
 
     result_data evaluate_data_and_premium() const;
+    premium_data evaluate_premium() const;
 };
@@ -0,0 +1,20 @@
+#pragma once
+#include "payoff.hpp"
+#include "qmc.hpp"
+#include <cstddef>
+
+// One Euler step for a batch of GBM paths stored contiguously:
+// S[p] = S[p] * (growth + vol * eps[p]) with growth = 1 + r dt, vol = sigma sqrt(dt).
+void gbm_step(double *S, const double *eps, std::size_t n, double growth, double vol);
+
+// n GBM paths from S0 over `steps` Euler steps on a chunk's normals. states
+// receives the PathState of each path, keeping the running statistics asked
+// for. W, if not null, receives the sum of each path's step normals, and
+// path, if not null, S after every step (path[i * n + p] after step i + 1).
+void simulate_gbm_paths(ChunkNormals &normals, std::size_t n, int steps, double S0, double growth, double vol,
+                        unsigned statistics, PathState *states, double *W = nullptr, double *path = nullptr);
+
+// The same paths as simulate_gbm_paths, keeping only S after the n_kept
+// steps in kept (increasing, in [1, steps]): spot[e * n + p] after step kept[e].
+void simulate_gbm_spots(ChunkNormals &normals, std::size_t n, int steps, double S0, double growth, double vol,
+                        const int *kept, std::size_t n_kept, double *spot);
@@ -0,0 +1,54 @@
+#pragma once
+#include "payoff.hpp"
+#include "statistics.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct Greeks
+{
+    MCEstimate premium, delta, gamma, vega, rho;
+};
+
+// Derivatives of a batch of Euler GBM paths S_{i+1} = S_i (growth + vol eps_i)
+// that the pathwise and likelihood-ratio Greeks need. Call update with the
+// normals of every step.
+class GbmPathDerivatives
+{
+public:
+    GbmPathDerivatives(std::size_t n_paths, double dt);
+
+    void update(const double *eps, double growth, double vol);
+
+    // d log S(T) / d sigma
+    double dlog_dsigma(std::size_t p) const
+    {
+        return dsigma[p];
+    }
+
+    // d log S(T) / d r
+    double dlog_dr(std::size_t p) const
+    {
+        return dr[p];
+    }
+
+    // Brownian motion W(T) driving the path
+    double brownian(std::size_t p) const
+    {
+        return W[p];
+    }
+
+private:
+    std::size_t n_paths{};
+    double dt{}, sqrt_dt{};
+    std::vector<double> dsigma, dr, W;
+};
+
+// Premium and Greeks of e^{-rT} f(S(T)) from one simulation of the paths
+// get_premium uses. Delta, vega and rho are pathwise derivatives of the Euler
+// scheme; gamma is the mixed pathwise / likelihood-ratio estimator with the
+// lognormal score W(T) / (sigma T), so it has the O(dt) bias of the scheme.
+// The payoff must depend on S(T) only. target_error > 0 stops early once the
+// premium's standard error reaches it (see merge_chunks_to_target).
+Greeks gbm_greeks(const Payoff &payoff, double S0, double sigma, double r, double T, int N, int M,
+                  std::uint64_t seed, int threads, double target_error = 0.);
@@ -0,0 +1,153 @@
+#pragma once
+#include "linalg.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Binary columnar files for PDE grids and simulated paths. A file holds named
+// arrays; each array is a sequence of slices of equal length (a time slice of
+// a grid, or the whole of a 1-D array), so a writer can emit slices while
+// they are computed and never hold the full grid. Slice j of an array is
+// column j of the matrix the reader returns.
+//
+// Layout, little-endian, every record 64-byte aligned:
+//
+//     file header   "WABGRID\0", u32 version, u32 byte-order mark
+//     declaration   u32 kind = 1, u32 id, u32 dtype, u32 codec, u64 slice size, char name[32]
+//     slice         u32 kind = 2, u32 id, u64 stored bytes, then the payload
+//     padding       u32 kind = 3, u32 0, u64 bytes to skip after the header
+//
+// Declarations and slices of different arrays may interleave. Uncompressed
+// float64 slices are stored as-is, so the reader can map the file and hand
+// out views without copying.
+
+enum class GridDtype : std::uint32_t
+{
+    float64 = 1,
+    float32 = 2
+};
+
+// zlib compresses each slice after a byte shuffle (all first bytes of the
+// values, then all second bytes, ...), which groups the slowly varying
+// exponent bytes together.
+enum class GridCodec : std::uint32_t
+{
+    none = 0,
+    zlib = 1
+};
+
+// Whether the library was built with zlib (CMake option WAB_USE_ZLIB)
+bool grid_compression_available();
+
+struct GridArrayInfo
+{
+    std::string name;
+    GridDtype dtype{GridDtype::float64};
+    GridCodec codec{GridCodec::none};
+    std::size_t rows{}, cols{};
+};
+
+// Append-only writer. Throws std::runtime_error on I/O failure and
+// std::invalid_argument for zlib when it was not built in.
+class GridWriter
+{
+public:
+    explicit GridWriter(const std::string &path, GridCodec codec = GridCodec::none);
+    ~GridWriter();
+
+    GridWriter(const GridWriter &) = delete;
+    GridWriter &operator=(const GridWriter &) = delete;
+
+    // New array of slice_size values per slice; returns the id to append to.
+    // Names are at most 31 characters and unique within a file.
+    std::size_t declare(const std::string &name, std::size_t slice_size, GridDtype dtype = GridDtype::float64);
+
+    // One slice of the array's slice_size values
+    void append(std::size_t id, const double *values);
+
+    // Declared array `id`, with rows its slice_size; throws
+    // std::invalid_argument if there is no such array
+    const GridArrayInfo &info(std::size_t id) const;
+
+    // Whole arrays: a vector is a single slice, a matrix one slice per column
+    void write(const std::string &name, const double *values, std::size_t n, GridDtype dtype = GridDtype::float64);
+    void write(const std::string &name, const std::vector<double> &values, GridDtype dtype = GridDtype::float64);
+    void write(const std::string &name, const matrix<double> &values, GridDtype dtype = GridDtype::float64);
+    void write(const std::string &name, double value);
+
+    // Slices appended from now on start at a multiple of `bytes` in the file,
+    // behind padding records: a power of two of at least 64, e.g. 4096 so
+    // every slice begins a page of the mapping.
+    void set_alignment(std::size_t bytes);
+
+    void flush();
+
+    // Flushes and closes; the destructor closes too but cannot report errors.
+    void close();
+
+private:
+    std::ofstream out;
+    GridCodec codec{GridCodec::none};
+    std::vector<GridArrayInfo> declared;
+    std::vector<unsigned char> buffer, packed;
+    std::size_t alignment{64}, position{};
+
+    void write_record(const void *header, std::size_t header_bytes, const void *payload, std::size_t payload_bytes);
+};
+
+// Read-only, memory-mapped view of a grid file. Views returned by view() and
+// slice() point into the mapping and live as long as the reader.
+class GridReader
+{
+public:
+    explicit GridReader(const std::string &path);
+    ~GridReader();
+
+    GridReader(GridReader &&other) noexcept;
+    GridReader &operator=(GridReader &&other) noexcept;
+
+    GridReader(const GridReader &) = delete;
+    GridReader &operator=(const GridReader &) = delete;
+
+    std::vector<GridArrayInfo> arrays() const;
+
+    bool contains(const std::string &name) const;
+
+    // Throw std::invalid_argument if there is no such array
+    const GridArrayInfo &info(const std::string &name) const;
+
+    // Zero-copy (rows x cols) view of an uncompressed float64 array; throws
+    // std::logic_error for other arrays, which need read().
+    matrix_view<const double> view(const std::string &name) const;
+
+    // Zero-copy slice j of an uncompressed float64 array
+    const double *slice(const std::string &name, std::size_t j) const;
+
+    // Decoded copy of any array, column-major with slice j as column j
+    matrix<double> read(const std::string &name) const;
+
+    // Every slice of the array, one after the other
+    std::vector<double> read_vector(const std::string &name) const;
+
+    double read_scalar(const std::string &name) const;
+
+private:
+    struct entry
+    {
+        GridArrayInfo info;
+        std::vector<std::size_t> offset, stored;
+    };
+
+    const unsigned char *data{};
+    std::size_t size{};
+    std::vector<unsigned char> fallback;
+    std::vector<entry> entries;
+
+    const entry &find_entry(const std::string &name) const;
+
+    void decode_slice(const entry &array, std::size_t j, double *out) const;
+
+    void release();
+};
@@ -0,0 +1,101 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Scoped timers and event counters for the hot paths. They are compiled in
+// only when the library is built with WAB_INSTRUMENTATION (CMake option of
+// the same name); otherwise the macros expand to nothing and the report is
+// empty. Names are dotted, engine first: "fx1.sweep", "ir.paths".
+//
+//     WAB_TIME_SCOPE("ir.evolve");    // time spent until the end of the scope
+//     WAB_COUNT("ir.paths", n_paths); // add n_paths to a counter
+//
+// Both are safe to use from worker threads (relaxed atomic adds).
+
+struct InstrumentationRecord
+{
+    std::string name;
+
+    // Timers: times entered and total nanoseconds; counters: count
+    std::uint64_t calls{}, total_ns{}, count{};
+};
+
+// Every timer and counter touched since the last reset, sorted by name
+std::vector<InstrumentationRecord> instrumentation_report();
+
+void print_instrumentation_report(std::ostream &os);
+
+void reset_instrumentation();
+
+// Whether the library was built with WAB_INSTRUMENTATION
+bool instrumentation_enabled();
+
+// Called with enter = true / false around every timed scope, e.g. to start
+// and stop perf_event counters or a profiler's ranges. nullptr removes it.
+using InstrumentationHook = void (*)(const char *name, bool enter);
+
+void set_instrumentation_hook(InstrumentationHook hook);
+
+struct InstrumentationSlot
+{
+    const char *name{};
+    std::atomic<std::uint64_t> calls{0}, total_ns{0}, count{0};
+};
+
+// The slot of name, registered on first use; its address never changes
+InstrumentationSlot &instrumentation_slot(const char *name);
+
+extern std::atomic<InstrumentationHook> instrumentation_hook;
+
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(InstrumentationSlot &slot) : slot(slot)
+    {
+        if (InstrumentationHook hook = instrumentation_hook.load(std::memory_order_relaxed))
+            hook(slot.name, true);
+
+        start = std::chrono::steady_clock::now();
+    }
+
+    ~ScopedTimer()
+    {
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+        slot.calls.fetch_add(1, std::memory_order_relaxed);
+        slot.total_ns.fetch_add(static_cast<std::uint64_t>(elapsed.count()), std::memory_order_relaxed);
+
+        if (InstrumentationHook hook = instrumentation_hook.load(std::memory_order_relaxed))
+            hook(slot.name, false);
+    }
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+    InstrumentationSlot &slot;
+    std::chrono::steady_clock::time_point start;
+};
+
+#define WAB_INSTRUMENTATION_CONCAT_(a, b) a##b
+#define WAB_INSTRUMENTATION_CONCAT(a, b) WAB_INSTRUMENTATION_CONCAT_(a, b)
+
+#if defined(WAB_INSTRUMENTATION)
+#define WAB_TIME_SCOPE(name)                                                                                            \
+    static InstrumentationSlot &WAB_INSTRUMENTATION_CONCAT(wab_timer_slot_, __LINE__) = instrumentation_slot(name); \
+    ScopedTimer WAB_INSTRUMENTATION_CONCAT(wab_timer_, __LINE__)(WAB_INSTRUMENTATION_CONCAT(wab_timer_slot_, __LINE__))
+
+#define WAB_COUNT(name, n)                                                                             \
+    do                                                                                                 \
+    {                                                                                                  \
+        static InstrumentationSlot &wab_counter_slot = instrumentation_slot(name);                     \
+        wab_counter_slot.count.fetch_add(static_cast<std::uint64_t>(n), std::memory_order_relaxed); \
+    } while (0)
+#else
+#define WAB_TIME_SCOPE(name) static_cast<void>(0)
+#define WAB_COUNT(name, n) static_cast<void>(0)
+#endif
@@ -1,15 +1,208 @@
 #pragma once
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <utility>
 #include <vector>
 
+constexpr std::size_t matrix_alignment = 64;
+
+template <class T, std::size_t Alignment = matrix_alignment>
+struct aligned_allocator
+{
+    using value_type = T;
+
+    template <class U>
+    struct rebind
+    {
+        using other = aligned_allocator<U, Alignment>;
+    };
+
+    aligned_allocator() = default;
+
+    template <class U>
+    aligned_allocator(const aligned_allocator<U, Alignment> &) {}
+
+    T *allocate(std::size_t n)
+    {
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T *p, std::size_t)
+    {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template <class U>
+    bool operator==(const aligned_allocator<U, Alignment> &) const { return true; }
+
+    template <class U>
+    bool operator!=(const aligned_allocator<U, Alignment> &) const { return false; }
+};
+
+template <class T>
+using aligned_vector = std::vector<T, aligned_allocator<T>>;
+
+enum class matrix_layout
+{
+    row_major,
+    column_major
+};
+
+// Non-owning 1-D strided sequence, e.g. a row of a column-major matrix.
 template <class T>
-using matrix = std::vector<std::vector<T>>;
+class strided_span
+{
+public:
+    strided_span(T *data, std::size_t size, std::ptrdiff_t stride) : data_(data), size_(size), stride_(stride) {}
+
+    T &operator[](std::size_t k) const { return data_[static_cast<std::ptrdiff_t>(k) * stride_]; }
+
+    T *data() const { return data_; }
+    std::size_t size() const { return size_; }
+    std::ptrdiff_t stride() const { return stride_; }
 
+private:
+    T *data_{};
+    std::size_t size_{};
+    std::ptrdiff_t stride_{};
+};
+
+// Non-owning strided 2-D view: element (i, j) is data[i * row_stride + j * col_stride].
 template <class T>
-inline void matrix_resize(T &u, size_t N, size_t M)
+class matrix_view
 {
-    u.resize(N);
-    for (auto &row : u)
-        row.resize(M);
+public:
+    matrix_view() = default;
+    matrix_view(T *data, std::size_t rows, std::size_t cols, std::ptrdiff_t row_stride, std::ptrdiff_t col_stride)
+        : data_(data), rows_(rows), cols_(cols), row_stride_(row_stride), col_stride_(col_stride) {}
+
+    T &operator()(std::size_t i, std::size_t j) const
+    {
+        return data_[static_cast<std::ptrdiff_t>(i) * row_stride_ + static_cast<std::ptrdiff_t>(j) * col_stride_];
+    }
+
+    strided_span<T> operator[](std::size_t i) const { return row(i); }
+
+    strided_span<T> row(std::size_t i) const { return strided_span<T>(&(*this)(i, 0), cols_, col_stride_); }
+    strided_span<T> col(std::size_t j) const { return strided_span<T>(&(*this)(0, j), rows_, row_stride_); }
+
+    matrix_view block(std::size_t i0, std::size_t j0, std::size_t n_rows, std::size_t n_cols) const
+    {
+        return matrix_view(&(*this)(i0, j0), n_rows, n_cols, row_stride_, col_stride_);
+    }
+
+    matrix_view transpose() const { return matrix_view(data_, cols_, rows_, col_stride_, row_stride_); }
+
+    T *data() const { return data_; }
+    std::size_t rows() const { return rows_; }
+    std::size_t cols() const { return cols_; }
+    std::ptrdiff_t row_stride() const { return row_stride_; }
+    std::ptrdiff_t col_stride() const { return col_stride_; }
+
+private:
+    T *data_{};
+    std::size_t rows_{}, cols_{};
+    std::ptrdiff_t row_stride_{}, col_stride_{};
+};
+
+// Dense matrix in one contiguous, 64-byte aligned allocation. The layout is
+// chosen per matrix: column-major keeps columns (e.g. PDE time slices)
+// contiguous, row-major keeps rows contiguous. m[i][j] and m(i, j) both work.
+template <class T>
+class matrix
+{
+public:
+    matrix() = default;
+
+    matrix(std::size_t rows, std::size_t cols, matrix_layout layout = matrix_layout::row_major, const T &value = T())
+        : storage(rows * cols, value), rows_(rows), cols_(cols), layout_(layout) {}
+
+    T &operator()(std::size_t i, std::size_t j) { return storage[offset(i, j)]; }
+    const T &operator()(std::size_t i, std::size_t j) const { return storage[offset(i, j)]; }
+
+    strided_span<T> operator[](std::size_t i) { return view().row(i); }
+    strided_span<const T> operator[](std::size_t i) const { return view().row(i); }
+
+    matrix_view<T> view() { return matrix_view<T>(storage.data(), rows_, cols_, row_stride(), col_stride()); }
+    matrix_view<const T> view() const { return matrix_view<const T>(storage.data(), rows_, cols_, row_stride(), col_stride()); }
+
+    // Keeps the elements that fit in the new shape, like resizing nested vectors.
+    void resize(std::size_t rows, std::size_t cols)
+    {
+        if (rows == rows_ && cols == cols_)
+            return;
+
+        matrix resized(rows, cols, layout_);
+        for (std::size_t i = 0; i < std::min(rows, rows_); ++i)
+            for (std::size_t j = 0; j < std::min(cols, cols_); ++j)
+                resized(i, j) = (*this)(i, j);
+
+        *this = std::move(resized);
+    }
+
+    void fill(const T &value) { std::fill(storage.begin(), storage.end(), value); }
+
+    T *data() { return storage.data(); }
+    const T *data() const { return storage.data(); }
+
+    std::size_t rows() const { return rows_; }
+    std::size_t cols() const { return cols_; }
+    std::size_t size() const { return storage.size(); }
+    bool empty() const { return storage.empty(); }
+    matrix_layout layout() const { return layout_; }
+
+    std::ptrdiff_t row_stride() const { return layout_ == matrix_layout::row_major ? static_cast<std::ptrdiff_t>(cols_) : 1; }
+    std::ptrdiff_t col_stride() const { return layout_ == matrix_layout::row_major ? 1 : static_cast<std::ptrdiff_t>(rows_); }
+
+private:
+    aligned_vector<T> storage;
+    std::size_t rows_{}, cols_{};
+    matrix_layout layout_{matrix_layout::row_major};
+
+    std::size_t offset(std::size_t i, std::size_t j) const
+    {
+        return layout_ == matrix_layout::row_major ? i * cols_ + j : j * rows_ + i;
+    }
+};
+
+template <class T>
+inline void matrix_resize(matrix<T> &u, std::size_t N, std::size_t M)
+{
+    u.resize(N, M);
 }
 
-matrix<double> matrix_creator();
\ No newline at end of file
+// Thomas algorithm with the elimination factors computed once, for systems
+// that are solved repeatedly with the same matrix (e.g. every PDE time step).
+class tridiagonal_solver
+{
+public:
+    tridiagonal_solver() = default;
+    tridiagonal_solver(const std::vector<double> &sub, const std::vector<double> &diag, const std::vector<double> &super);
+
+    // In place: rhs becomes the solution.
+    void solve(double *rhs) const;
+
+    std::size_t size() const
+    {
+        return inv_pivot.size();
+    }
+
+private:
+    std::vector<double> sub, upper, inv_pivot;
+};
+
+// Lower-triangular L with L L^T = a for a symmetric positive semi-definite
+// matrix. A zero pivot leaves its column zero, so singular correlation
+// matrices (e.g. rho = 1) factorize; throws std::invalid_argument if a is
+// not square or has a negative pivot.
+matrix<double> cholesky_decompose(const matrix<double> &a);
+
+// Eigenvalues of a symmetric matrix in decreasing order, by cyclic Jacobi
+// rotations. Column k of vectors is the unit eigenvector of values[k], with
+// its largest component positive. Throws std::invalid_argument if a is not
+// square and std::runtime_error if the off-diagonal norm is still above
+// tolerance after the sweep limit (e.g. for non-finite entries).
+void symmetric_eigen(const matrix<double> &a, std::vector<double> &values, matrix<double> &vectors);
+
+matrix<double> matrix_creator();
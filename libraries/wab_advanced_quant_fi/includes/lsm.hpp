@@ -0,0 +1,362 @@
+#pragma once
+#include "gbm.hpp"
+#include "instrumentation.hpp"
+#include "parallel.hpp"
+#include "qmc.hpp"
+#include "statistics.hpp"
+#include "variance_reduction.hpp"
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Regression bases for Longstaff-Schwartz, in x = S / S0. A basis has a
+// compile-time size and writes its functions at x to phi[k * stride], so the
+// regression kernels below unroll to fixed-size loops.
+template <int Degree>
+struct MonomialBasis
+{
+    static constexpr std::size_t size = Degree + 1;
+
+    static void evaluate(double x, double *phi, std::size_t stride)
+    {
+        double power = 1;
+        for (std::size_t k = 0; k < size; ++k, power *= x)
+            phi[k * stride] = power;
+    }
+};
+
+// Laguerre polynomials L_0 .. L_Degree, by their three-term recurrence
+template <int Degree>
+struct LaguerreBasis
+{
+    static constexpr std::size_t size = Degree + 1;
+
+    static void evaluate(double x, double *phi, std::size_t stride)
+    {
+        double previous = 0, current = 1;
+        for (std::size_t k = 0; k < size; ++k)
+        {
+            phi[k * stride] = current;
+            double next = ((2 * k + 1 - x) * current - k * previous) * (1. / (k + 1));
+            previous = current;
+            current = next;
+        }
+    }
+};
+
+// Basis of EQ1's Bermudan and American premiums
+using ExerciseBasis = LaguerreBasis<3>;
+
+// Least squares y ~ beta . phi(x) through its normal equations. Sums over
+// observations merge like RunningStats, so chunks reduced in order give the
+// same coefficients for any thread count.
+template <std::size_t Size>
+struct NormalEquations
+{
+    // Lower triangle of sum phi phi^T, and sum phi y
+    std::array<double, Size * Size> gram{};
+    std::array<double, Size> moment{};
+    std::size_t count{};
+
+    // m observations with basis values phi[k * stride + i]. One pass with
+    // a separate accumulator per entry, so the sums do not wait on each other.
+    void add(const double *phi, std::size_t stride, const double *y, std::size_t m)
+    {
+        std::array<double, Size * Size> g{};
+        std::array<double, Size> b{};
+
+        for (std::size_t i = 0; i < m; ++i)
+        {
+            double x[Size];
+            for (std::size_t j = 0; j < Size; ++j)
+                x[j] = phi[j * stride + i];
+
+            for (std::size_t j = 0; j < Size; ++j)
+            {
+                for (std::size_t k = 0; k <= j; ++k)
+                    g[j * Size + k] += x[j] * x[k];
+                b[j] += x[j] * y[i];
+            }
+        }
+
+        for (std::size_t i = 0; i < Size * Size; ++i)
+            gram[i] += g[i];
+        for (std::size_t j = 0; j < Size; ++j)
+            moment[j] += b[j];
+        count += m;
+    }
+
+    void merge(const NormalEquations &other)
+    {
+        for (std::size_t i = 0; i < Size * Size; ++i)
+            gram[i] += other.gram[i];
+        for (std::size_t j = 0; j < Size; ++j)
+            moment[j] += other.moment[j];
+        count += other.count;
+    }
+
+    // Coefficients by Cholesky. A basis function whose pivot is lost to
+    // rounding (numerically dependent on the earlier ones) gets coefficient
+    // zero, like a zero pivot in cholesky_decompose. False with fewer
+    // observations than basis functions.
+    bool solve(std::array<double, Size> &beta) const
+    {
+        if (count < Size)
+            return false;
+
+        std::array<double, Size * Size> L{};
+        for (std::size_t j = 0; j < Size; ++j)
+        {
+            for (std::size_t k = 0; k <= j; ++k)
+            {
+                double sum = gram[j * Size + k];
+                for (std::size_t i = 0; i < k; ++i)
+                    sum -= L[j * Size + i] * L[k * Size + i];
+
+                if (k < j)
+                    L[j * Size + k] = L[k * Size + k] > 0 ? sum / L[k * Size + k] : 0;
+                else if (sum > 1e-12 * gram[j * Size + j])
+                    L[j * Size + j] = std::sqrt(sum);
+            }
+        }
+
+        // L z = moment, then L^T beta = z
+        for (std::size_t j = 0; j < Size; ++j)
+        {
+            double sum = moment[j];
+            for (std::size_t i = 0; i < j; ++i)
+                sum -= L[j * Size + i] * beta[i];
+            beta[j] = L[j * Size + j] > 0 ? sum / L[j * Size + j] : 0;
+        }
+        for (std::size_t j = Size; j-- > 0;)
+        {
+            double sum = beta[j];
+            for (std::size_t i = j + 1; i < Size; ++i)
+                sum -= L[i * Size + j] * beta[i];
+            beta[j] = L[j * Size + j] > 0 ? sum / L[j * Size + j] : 0;
+        }
+        return true;
+    }
+};
+
+// A Bermudan option on EQ1's GBM paths: N Euler steps of T / N from S0,
+// exercisable after each of exercise_steps (increasing, in [1, N]).
+struct BermudanInputs
+{
+    double T{}, S0{}, sigma{}, r{};
+    int N{};
+    std::vector<int> exercise_steps;
+    std::size_t pricing_paths{}, regression_paths{};
+    std::uint64_t seed{};
+    int threads{1};
+    double target_error{};
+    unsigned variance_reduction{};
+};
+
+// Seed of the regression paths, so the exercise rule is fitted on paths
+// independent of those it prices
+constexpr std::uint64_t lsm_regression_seed(std::uint64_t seed)
+{
+    return seed ^ 0x9E3779B97F4A7C15ull;
+}
+
+// Longstaff-Schwartz for exercise values exercise_value(S). The backward
+// pass simulates regression_paths paths, stores their spots at the exercise
+// dates chunk by chunk (date-major within a chunk), and walks the dates
+// backwards: at each, the discounted cash flow of the in-the-money paths is
+// regressed on Basis, and paths whose exercise value beats the fitted
+// continuation value exercise there. A date with too few in-the-money paths
+// to fit is not exercised.
+//
+// The forward pass prices the fitted rule on pricing_paths fresh paths in
+// parallel chunks, drawn from the same streams as EQ1::get_premium's, so an
+// option exercisable only at T gets that European premium. Each path pays
+// at its first exercise. The estimate is low-biased by the suboptimality of
+// the fitted rule, and its standard error is that of the forward pass.
+template <class Basis, class Exercise>
+MCEstimate longstaff_schwartz(Exercise exercise_value, const BermudanInputs &inputs)
+{
+    constexpr std::size_t size = Basis::size;
+    using Coefficients = std::array<double, size>;
+
+    const std::vector<int> &steps = inputs.exercise_steps;
+    const std::size_t n_dates = steps.size();
+    const double S0 = inputs.S0;
+
+    double dt = inputs.T / inputs.N;
+    double growth = 1 + inputs.r * dt, vol = inputs.sigma * std::sqrt(dt);
+
+    // The control variate is the European call, which does not apply
+    unsigned reduction = inputs.variance_reduction & (vr_antithetic | vr_moment_matching);
+
+    auto continuation_value = [](const Coefficients &beta, double x)
+    {
+        double phi[size];
+        Basis::evaluate(x, phi, 1);
+
+        double sum = 0;
+        for (std::size_t k = 0; k < size; ++k)
+            sum += beta[k] * phi[k];
+        return sum;
+    };
+
+    auto simulate = [&](std::uint64_t seed, std::size_t chunk, std::size_t n, std::vector<double> &spot)
+    {
+        WAB_TIME_SCOPE("lsm.simulate");
+        WAB_COUNT("lsm.paths", n);
+
+        spot.resize(n_dates * n);
+        ChunkNormals normals(nullptr, seed, chunk, n, inputs.N, 1, reduction);
+        simulate_gbm_spots(normals, n, inputs.N, S0, growth, vol, steps.data(), n_dates, spot.data());
+    };
+
+    // Backward pass. A chunk keeps its paths' spots at every date, their
+    // cash flows discounted to the date being fitted, and at that date the
+    // exercise values, the in-the-money paths and their basis values
+    // (phi[k * n + i] for the i-th of them).
+    struct RegressionChunk
+    {
+        std::vector<double> spot, value, exercise, phi;
+        std::vector<std::size_t> in_the_money;
+        std::size_t n_in_the_money{};
+    };
+
+    std::vector<Coefficients> beta(n_dates);
+    std::vector<char> exercisable(n_dates, 0);
+    exercisable[n_dates - 1] = 1;
+
+    std::size_t n_chunks = (inputs.regression_paths + mc_chunk_paths - 1) / mc_chunk_paths;
+    std::vector<RegressionChunk> paths(n_chunks);
+    std::uint64_t regression_seed = lsm_regression_seed(inputs.seed);
+
+    parallel_chunks<char>(inputs.regression_paths, mc_chunk_paths, inputs.threads,
+                          [&](std::size_t chunk, std::size_t begin, std::size_t end)
+                          {
+                              std::size_t n = vr_chunk_paths(end - begin, reduction);
+                              RegressionChunk &part = paths[chunk];
+                              simulate(regression_seed, chunk, n, part.spot);
+
+                              part.value.resize(n);
+                              part.exercise.resize(n);
+                              part.phi.resize(size * n);
+                              part.in_the_money.resize(n);
+                              for (std::size_t p = 0; p < n; ++p)
+                                  part.value[p] = exercise_value(part.spot[(n_dates - 1) * n + p]);
+                              return 0;
+                          });
+
+    for (std::size_t e = n_dates - 1; e-- > 0;)
+    {
+        WAB_TIME_SCOPE("lsm.regression");
+
+        double step_discount = std::exp(-inputs.r * dt * (steps[e + 1] - steps[e]));
+
+        auto fit_chunk = [&](std::size_t chunk, std::size_t, std::size_t)
+        {
+            RegressionChunk &part = paths[chunk];
+            std::size_t n = part.value.size();
+            const double *S = &part.spot[e * n];
+
+            for (std::size_t p = 0; p < n; ++p)
+                part.value[p] *= step_discount;
+
+            for (std::size_t p = 0; p < n; ++p)
+                part.exercise[p] = exercise_value(S[p]);
+
+            // Branch-free compaction: about half the paths are in the money
+            std::size_t m = 0;
+            for (std::size_t p = 0; p < n; ++p)
+            {
+                part.in_the_money[m] = p;
+                m += part.exercise[p] > 0;
+            }
+
+            std::vector<double> y(m);
+            for (std::size_t i = 0; i < m; ++i)
+            {
+                std::size_t p = part.in_the_money[i];
+                Basis::evaluate(S[p] / S0, &part.phi[i], n);
+                y[i] = part.value[p];
+            }
+            part.n_in_the_money = m;
+
+            NormalEquations<size> equations;
+            equations.add(part.phi.data(), n, y.data(), m);
+            return equations;
+        };
+
+        NormalEquations<size> equations;
+        for (const auto &part : parallel_chunks<NormalEquations<size>>(inputs.regression_paths, mc_chunk_paths, inputs.threads, fit_chunk))
+            equations.merge(part);
+
+        exercisable[e] = equations.solve(beta[e]);
+        if (!exercisable[e])
+            continue;
+
+        auto exercise_chunk = [&](std::size_t chunk, std::size_t, std::size_t)
+        {
+            RegressionChunk &part = paths[chunk];
+            std::size_t n = part.value.size();
+
+            for (std::size_t i = 0; i < part.n_in_the_money; ++i)
+            {
+                double continuation = 0;
+                for (std::size_t k = 0; k < size; ++k)
+                    continuation += beta[e][k] * part.phi[k * n + i];
+
+                std::size_t p = part.in_the_money[i];
+                if (part.exercise[p] > continuation)
+                    part.value[p] = part.exercise[p];
+            }
+            return 0;
+        };
+
+        parallel_chunks<char>(inputs.regression_paths, mc_chunk_paths, inputs.threads, exercise_chunk);
+    }
+
+    paths = {};
+
+    // Forward pass
+    std::vector<double> discount(n_dates);
+    for (std::size_t e = 0; e < n_dates; ++e)
+        discount[e] = std::exp(-inputs.r * dt * steps[e]);
+
+    auto price_chunk = [&](std::size_t chunk, std::size_t begin, std::size_t end)
+    {
+        std::size_t n = vr_chunk_paths(end - begin, reduction);
+        std::vector<double> spots, cash(n);
+        simulate(inputs.seed, chunk, n, spots);
+
+        WAB_TIME_SCOPE("lsm.exercise");
+
+        for (std::size_t p = 0; p < n; ++p)
+        {
+            for (std::size_t e = 0; e < n_dates; ++e)
+            {
+                if (!exercisable[e])
+                    continue;
+
+                double S = spots[e * n + p];
+                double exercise = exercise_value(S);
+                if (exercise > 0 && (e == n_dates - 1 || exercise > continuation_value(beta[e], S / S0)))
+                {
+                    cash[p] = exercise * discount[e];
+                    break;
+                }
+            }
+        }
+
+        RunningStats samples;
+        add_path_samples(samples, cash.data(), n, reduction);
+        return samples;
+    };
+
+    auto error = [](const RunningStats &samples)
+    { return samples.estimate().standard_error; };
+
+    return merge_chunks_to_target<RunningStats>(inputs.pricing_paths, mc_chunk_paths, inputs.threads, inputs.target_error,
+                                                price_chunk, error)
+        .estimate();
+}
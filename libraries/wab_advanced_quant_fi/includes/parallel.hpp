@@ -0,0 +1,145 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Paths per Monte Carlo chunk. Each chunk owns one random stream, so this is
+// part of the definition of a seeded result and must not depend on threads.
+constexpr std::size_t mc_chunk_paths = 256;
+
+int hardware_thread_count();
+
+// threads <= 0 selects every hardware thread.
+int resolve_thread_count(int threads);
+
+// Split [0, count) into chunks of chunk_size and evaluate fn(chunk, begin, end)
+// for each of them on up to `threads` workers. Workers claim chunks dynamically,
+// but results are returned indexed by chunk, so reducing them in order gives the
+// same answer for any thread count.
+template <class Result, class Function>
+std::vector<Result> parallel_chunks(std::size_t count, std::size_t chunk_size, int threads, Function fn)
+{
+    std::size_t n_chunks = (count + chunk_size - 1) / chunk_size;
+    std::vector<Result> results(n_chunks);
+
+    std::atomic<std::size_t> next_chunk{0};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    auto worker = [&]()
+    {
+        try
+        {
+            for (std::size_t chunk = next_chunk++; chunk < n_chunks; chunk = next_chunk++)
+            {
+                std::size_t begin = chunk * chunk_size;
+                std::size_t end = std::min(count, begin + chunk_size);
+                results[chunk] = fn(chunk, begin, end);
+            }
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error)
+                error = std::current_exception();
+            next_chunk = n_chunks;
+        }
+    };
+
+    std::size_t n_workers = std::min<std::size_t>(resolve_thread_count(threads), n_chunks);
+
+    std::vector<std::thread> pool;
+    for (std::size_t w = 1; w < n_workers; ++w)
+        pool.emplace_back(worker);
+
+    worker();
+
+    for (auto &thread : pool)
+        thread.join();
+
+    if (error)
+        std::rethrow_exception(error);
+
+    return results;
+}
+
+// Evaluates chunks like parallel_chunks and merges their Stats (anything with
+// merge()) in chunk order. With target_error > 0 the chunks run in rounds,
+// and simulation stops once error(merged stats) <= target_error. Each round
+// is sized from the current error, at most doubling the paths simulated so
+// far. Round boundaries depend only on merged statistics, so the result is
+// the same for every thread count. count is the path budget either way.
+template <class Stats, class Function, class Error>
+Stats merge_chunks_to_target(std::size_t count, std::size_t chunk_size, int threads, double target_error,
+                             Function fn, Error error)
+{
+    std::size_t n_chunks = (count + chunk_size - 1) / chunk_size;
+    Stats total{};
+
+    // Enough paths for a usable first variance estimate
+    constexpr std::size_t first_round_chunks = 8;
+
+    std::size_t done = 0;
+    std::size_t round = target_error > 0 ? std::min(n_chunks, first_round_chunks) : n_chunks;
+
+    while (done < n_chunks)
+    {
+        std::size_t first = done;
+        auto round_chunk = [&](std::size_t k, std::size_t, std::size_t)
+        {
+            std::size_t chunk = first + k;
+            std::size_t begin = chunk * chunk_size;
+            return fn(chunk, begin, std::min(count, begin + chunk_size));
+        };
+
+        for (const auto &stats : parallel_chunks<Stats>(round, 1, threads, round_chunk))
+            total.merge(stats);
+
+        done += round;
+
+        if (done == n_chunks)
+            break;
+
+        double current = error(total);
+        if (current <= target_error)
+            break;
+
+        // Paths scale with (error / target)^2; aim 10% past the prediction,
+        // but at most double what has been simulated
+        double ratio = current / target_error;
+        double needed = std::fmin(1.1 * ratio * ratio, 2.) * done;
+        std::size_t more = std::max(static_cast<std::size_t>(std::ceil(needed)), done + 1) - done;
+        round = std::min(more, n_chunks - done);
+    }
+
+    return total;
+}
+
+// Evaluates chunks like parallel_chunks, a few per worker at a time, and
+// hands each result to consume(chunk, result) in chunk order. Only one round
+// of results is held, so a caller can stream them to a file.
+template <class Result, class Function, class Consume>
+void stream_chunks(std::size_t count, std::size_t chunk_size, int threads, Function fn, Consume consume)
+{
+    std::size_t n_chunks = (count + chunk_size - 1) / chunk_size;
+    std::size_t round = 4 * static_cast<std::size_t>(resolve_thread_count(threads));
+
+    for (std::size_t first = 0; first < n_chunks; first += round)
+    {
+        auto round_chunk = [&](std::size_t k, std::size_t, std::size_t)
+        {
+            std::size_t chunk = first + k;
+            std::size_t begin = chunk * chunk_size;
+            return fn(chunk, begin, std::min(count, begin + chunk_size));
+        };
+
+        std::vector<Result> results = parallel_chunks<Result>(std::min(round, n_chunks - first), 1, threads, round_chunk);
+        for (std::size_t k = 0; k < results.size(); ++k)
+            consume(first + k, results[k]);
+    }
+}
@@ -0,0 +1,208 @@
+#pragma once
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Running statistics a payoff can ask the path engine to keep. The terminal
+// value is always available; anything else costs one array per path batch.
+enum PathStatistic : unsigned
+{
+    path_terminal = 0,
+    path_maximum = 1u << 0,
+    path_minimum = 1u << 1,
+    path_average = 1u << 2
+};
+
+// Maximum and minimum are taken over S(t_0) .. S(t_N); the average over the
+// monitoring dates S(t_1) .. S(t_N).
+struct PathState
+{
+    double terminal{}, maximum{}, minimum{}, average{};
+};
+
+class Payoff
+{
+public:
+    virtual ~Payoff() = default;
+
+    virtual unsigned statistics() const
+    {
+        return path_terminal;
+    }
+
+    virtual double operator()(const PathState &state) const = 0;
+
+    // d payoff / d S(T), for pathwise Greeks. Only payoffs of the terminal
+    // value provide it; the default throws std::logic_error.
+    virtual double terminal_slope(double terminal) const;
+};
+
+class CallPayoff : public Payoff
+{
+public:
+    explicit CallPayoff(double K) : K(K) {}
+
+    double operator()(const PathState &state) const override;
+
+    double terminal_slope(double terminal) const override;
+
+    double strike() const
+    {
+        return K;
+    }
+
+private:
+    double K{};
+};
+
+class PutPayoff : public Payoff
+{
+public:
+    explicit PutPayoff(double K) : K(K) {}
+
+    double operator()(const PathState &state) const override;
+
+    double terminal_slope(double terminal) const override;
+
+    double strike() const
+    {
+        return K;
+    }
+
+private:
+    double K{};
+};
+
+class AsianCallPayoff : public Payoff
+{
+public:
+    explicit AsianCallPayoff(double K) : K(K) {}
+
+    unsigned statistics() const override
+    {
+        return path_average;
+    }
+
+    double operator()(const PathState &state) const override;
+
+private:
+    double K{};
+};
+
+// Floating-strike lookback call: S(T) - min S(t).
+class LookbackCallPayoff : public Payoff
+{
+public:
+    LookbackCallPayoff() = default;
+
+    unsigned statistics() const override
+    {
+        return path_minimum;
+    }
+
+    double operator()(const PathState &state) const override;
+};
+
+// Call knocked out if the path reaches the barrier on a monitoring date.
+class UpAndOutCallPayoff : public Payoff
+{
+public:
+    UpAndOutCallPayoff(double K, double barrier) : K(K), barrier(barrier) {}
+
+    unsigned statistics() const override
+    {
+        return path_maximum;
+    }
+
+    double operator()(const PathState &state) const override;
+
+private:
+    double K{}, barrier{};
+};
+
+// Per-path running statistics for a batch of paths advanced in lockstep.
+// Only the arrays requested by `statistics` are allocated and updated.
+class PathStatisticsBatch
+{
+public:
+    PathStatisticsBatch(unsigned statistics, std::size_t n_paths, double S0);
+
+    void update(const double *S);
+
+    PathState state(std::size_t p, double terminal) const;
+
+private:
+    unsigned statistics{};
+    std::size_t n_paths{}, n_updates{};
+    std::vector<double> maximum, minimum, sum;
+};
+
+// Payoff of several assets at maturity, evaluated for a batch of paths at
+// once: S holds the terminal values asset-major, S[a * n_paths + p], and
+// out[p] receives the payoff of path p.
+class BasketPayoff
+{
+public:
+    virtual ~BasketPayoff() = default;
+
+    virtual void operator()(const double *S, std::size_t n_assets, std::size_t n_paths, double *out) const = 0;
+};
+
+// max_a S_a(T), the payoff EQ2 prices.
+class MaxOfAssetsPayoff : public BasketPayoff
+{
+public:
+    MaxOfAssetsPayoff() = default;
+
+    void operator()(const double *S, std::size_t n_assets, std::size_t n_paths, double *out) const override;
+};
+
+// Rainbow call on the best asset: max(max_a S_a(T) - K, 0).
+class BestOfCallPayoff : public BasketPayoff
+{
+public:
+    explicit BestOfCallPayoff(double K) : K(K) {}
+
+    void operator()(const double *S, std::size_t n_assets, std::size_t n_paths, double *out) const override;
+
+private:
+    double K{};
+};
+
+// Rainbow put on the worst asset: max(K - min_a S_a(T), 0).
+class WorstOfPutPayoff : public BasketPayoff
+{
+public:
+    explicit WorstOfPutPayoff(double K) : K(K) {}
+
+    void operator()(const double *S, std::size_t n_assets, std::size_t n_paths, double *out) const override;
+
+private:
+    double K{};
+};
+
+// max(sum_a w_a S_a(T) - K, 0); needs one weight per asset.
+class BasketCallPayoff : public BasketPayoff
+{
+public:
+    BasketCallPayoff(std::vector<double> weights, double K) : weights(std::move(weights)), K(K) {}
+
+    void operator()(const double *S, std::size_t n_assets, std::size_t n_paths, double *out) const override;
+
+private:
+    std::vector<double> weights;
+    double K{};
+};
+
+// max(K - sum_a w_a S_a(T), 0); needs one weight per asset.
+class BasketPutPayoff : public BasketPayoff
+{
+public:
+    BasketPutPayoff(std::vector<double> weights, double K) : weights(std::move(weights)), K(K) {}
+
+    void operator()(const double *S, std::size_t n_assets, std::size_t n_paths, double *out) const override;
+
+private:
+    std::vector<double> weights;
+    double K{};
+};
@@ -0,0 +1,138 @@
+#pragma once
+#include "analytic.hpp"
+#include "cds.hpp"
+#include "linalg.hpp"
+#include "random.hpp"
+#include "statistics.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Horizon default probability 1 - exp(-h T) of CR2's flat hazard rate, or of a
+// bootstrapped hazard curve. CR1's Merton firm has merton_default_probability.
+double hazard_default_probability(double hazard_rate, double T);
+double hazard_default_probability(const PiecewiseFlatCurve &hazard, double T);
+
+// Discrete portfolio loss distribution: P(L = loss[k]) = probability[k], with
+// loss increasing. Levels are e.g. 0.99; tranches are in loss units.
+struct PortfolioLossResults
+{
+    std::vector<double> loss, probability;
+
+    // At the engine's confidence level
+    double expected_loss{}, value_at_risk{}, expected_shortfall{}, expected_defaults{};
+
+    // Monte Carlo only: the expected loss with its standard error
+    MCEstimate expected_loss_estimate;
+
+    // Smallest loss with P(L <= loss) >= level
+    double quantile(double level) const;
+
+    // Mean of the worst 1 - level of outcomes (Acerbi-Tasche), splitting the
+    // atom at the quantile
+    double shortfall(double level) const;
+
+    // E[min(max(L - attachment, 0), detachment - attachment)]
+    double tranche_loss(double attachment, double detachment) const;
+};
+
+// Default-mode loss of a portfolio under a Gaussian copula: obligor i
+// defaults by the horizon if a_i . Z + sqrt(1 - |a_i|^2) e_i < Phi^-1(p_i),
+// with common factors Z and idiosyncratic e_i all independent N(0, 1), and
+// then loses exposure_i (1 - recovery_i).
+//
+// The analytic engine (semi-analytic) integrates the conditionally independent
+// loss distribution over Z by quadrature; given Z it is built by recursion
+// over obligors on a grid of loss units, skipping grid points with negligible
+// probability. Losses that are not whole units are split between the two
+// nearest grid points, which keeps the expected loss exact. The Monte Carlo
+// engine draws scenarios in chunks and samples only the defaulters (see
+// portfolio.cpp). Automatic uses the recursion for one factor.
+class CreditPortfolio
+{
+public:
+    CreditPortfolio() = default;
+
+    // One-factor copula: every obligor loads sqrt(rho) on the common factor
+    CreditPortfolio(std::vector<double> default_probability, std::vector<double> exposure,
+                    std::vector<double> recovery, double rho);
+
+    // Multi-factor copula: loadings has one row per obligor and one column
+    // per factor. Throws std::invalid_argument if sizes differ, a
+    // probability or recovery is outside [0, 1], an exposure is negative or a
+    // row has |a_i| >= 1.
+    CreditPortfolio(std::vector<double> default_probability, std::vector<double> exposure,
+                    std::vector<double> recovery, matrix<double> loadings);
+
+    PortfolioLossResults get_loss_distribution() const
+    {
+        return find_loss_distribution();
+    }
+
+    void set_engine(PricingEngine newEngine)
+    {
+        this->engine = newEngine;
+    }
+
+    // VaR and ES level of the results, e.g. 0.999
+    void set_confidence(double newConfidence)
+    {
+        this->confidence = newConfidence;
+    }
+
+    void set_scenarios(int newScenarios)
+    {
+        this->M = newScenarios;
+    }
+
+    void set_seed(std::uint64_t newSeed)
+    {
+        this->seed = newSeed;
+    }
+
+    // 0 uses every hardware thread; the results do not depend on the count.
+    void set_threads(int newThreads)
+    {
+        this->threads = newThreads;
+    }
+
+    // Quadrature nodes per factor, evenly spaced over [-8.5, 8.5]; 0 picks 201
+    // for one factor and 41 otherwise. The recursion runs once per node, and
+    // there are nodes^factors of them.
+    void set_quadrature_nodes(int newNodes)
+    {
+        this->quadrature_nodes = newNodes;
+    }
+
+    // Grid spacing of the recursion; 0 uses the total possible loss / 2000
+    void set_loss_unit(double newLossUnit)
+    {
+        this->loss_unit = newLossUnit;
+    }
+
+    std::size_t obligors() const
+    {
+        return exposure.size();
+    }
+
+    std::size_t factors() const
+    {
+        return loadings.cols();
+    }
+
+private:
+    std::vector<double> default_probability, exposure, recovery;
+    matrix<double> loadings;
+
+    PricingEngine engine{PricingEngine::automatic};
+    double confidence{0.99};
+    int M{100000};
+    std::uint64_t seed{default_rng_seed};
+    int threads{1};
+    int quadrature_nodes{};
+    double loss_unit{};
+
+    PortfolioLossResults find_loss_distribution() const;
+    PortfolioLossResults find_recursive_distribution() const;
+    PortfolioLossResults find_simulated_distribution() const;
+};
@@ -0,0 +1,131 @@
+#pragma once
+#include "parallel.hpp"
+#include "random.hpp"
+#include "statistics.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class SamplingMethod
+{
+    pseudo_random,
+    sobol
+};
+
+// Independent digital shifts of the Sobol points; the spread of the
+// replication means gives the standard error of a quasi-Monte Carlo run.
+constexpr std::size_t sobol_replications = 8;
+
+// Sobol sequence in base 2 with 32-bit resolution. Dimension 0 is van der
+// Corput; dimension j > 0 uses the j-th primitive polynomial over GF(2) (by
+// degree, then value) with initial direction numbers drawn at random, odd and
+// below 2^k (Jaeckel's construction), so any number of dimensions works.
+// Points are produced in Gray-code order; the first 2^m points are the same
+// set as in natural order.
+class SobolSequence
+{
+public:
+    SobolSequence() = default;
+    explicit SobolSequence(std::size_t dimensions);
+
+    // Integer coordinates of point `index`
+    void point(std::uint64_t index, std::uint32_t *out) const;
+
+    // Turns point `index - 1` (given in x) into point `index`
+    void next(std::uint64_t index, std::uint32_t *x) const;
+
+    std::size_t dimensions() const
+    {
+        return n_dimensions;
+    }
+
+private:
+    static constexpr int bits = 32;
+
+    std::size_t n_dimensions{};
+    std::vector<std::uint32_t> directions; // directions[d * bits + k]
+};
+
+// Brownian bridge on `steps` unit time steps: turns standard normals z into
+// increments of W with unit variance. z[0] sets W at the last step, z[1] the
+// midpoint and so on, so the first (best distributed) Sobol dimensions carry
+// most of the variance of the path.
+class BrownianBridge
+{
+public:
+    BrownianBridge() = default;
+    explicit BrownianBridge(std::size_t steps);
+
+    void increments(const double *z, double *out) const;
+
+    std::size_t size() const
+    {
+        return steps;
+    }
+
+private:
+    std::size_t steps{};
+    std::vector<std::size_t> bridge_index, left_index, right_index;
+    std::vector<double> left_weight, right_weight, std_dev;
+};
+
+// Quasi-random Brownian increments for the chunked engines. Chunk c uses
+// digital shift c % sobol_replications and the next mc_chunk_paths points of
+// that shift's sequence, so each replication covers the leading points of
+// the Sobol sequence. Dimensions are ordered bridge rank first, then factor.
+class SobolPaths
+{
+public:
+    SobolPaths(std::size_t steps, std::size_t factors, std::uint64_t seed);
+
+    static std::size_t replication(std::size_t chunk)
+    {
+        return chunk % sobol_replications;
+    }
+
+    // out[(step * factors + factor) * n_paths + p], unit variance per step
+    void chunk_increments(std::size_t chunk, std::size_t n_paths, double *out) const;
+
+private:
+    std::size_t steps{}, factors{};
+    SobolSequence sobol;
+    BrownianBridge bridge;
+    std::vector<std::uint32_t> shifts; // shifts[r * dimensions + d]
+};
+
+// The normals of one chunk of paths, handed out one (step, factor) at a time
+// in the order the engine consumes them: from the chunk's Philox stream with
+// the requested variance reduction, or from SobolPaths when sobol is set.
+class ChunkNormals
+{
+public:
+    ChunkNormals(const SobolPaths *sobol, std::uint64_t seed, std::size_t chunk, std::size_t n_paths,
+                 std::size_t steps, std::size_t factors, unsigned variance_reduction);
+
+    void fill(double *eps);
+
+private:
+    NormalGenerator normal;
+    std::size_t n_paths{}, next_block{};
+    unsigned variance_reduction{};
+    std::vector<double> increments;
+};
+
+// merge_chunks_to_target for a Sobol run. chunk_stats(chunk, begin, end)
+// returns the RunningStats of one chunk's samples; chunks are grouped by
+// their digital shift and the estimate comes from ReplicationStats.
+template <class Function>
+MCEstimate sobol_estimate(std::size_t count, int threads, double target_error, double scale, Function chunk_stats)
+{
+    auto replicated_chunk = [&](std::size_t chunk, std::size_t begin, std::size_t end)
+    {
+        ReplicationStats stats(sobol_replications);
+        stats[SobolPaths::replication(chunk)] = chunk_stats(chunk, begin, end);
+        return stats;
+    };
+    auto error = [&](const ReplicationStats &stats)
+    { return stats.estimate(scale).standard_error; };
+
+    return merge_chunks_to_target<ReplicationStats>(count, mc_chunk_paths, threads, target_error, replicated_chunk, error)
+        .estimate(scale);
+}
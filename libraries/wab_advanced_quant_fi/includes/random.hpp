@@ -1,11 +1,92 @@
 #pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+constexpr std::uint64_t default_rng_seed = 20240601;
+
+// Counter-based Philox4x32-10 generator (Salmon et al., Random123). The output
+// is a pure function of (key, counter), so any position of any stream can be
+// reached in O(1) and independent streams never share state.
+class Philox4x32
+{
+public:
+    using result_type = std::uint32_t;
+    using counter_type = std::array<std::uint32_t, 4>;
+    using key_type = std::array<std::uint32_t, 2>;
+
+    Philox4x32() : Philox4x32(default_rng_seed) {}
+    explicit Philox4x32(std::uint64_t seed, std::uint64_t stream = 0);
+
+    static counter_type generate_block(counter_type counter, key_type key);
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT32_MAX; }
+
+    result_type operator()();
+
+    // Advance by n 32-bit outputs.
+    void skip_ahead(std::uint64_t n);
+
+    Philox4x32 split(std::uint64_t new_stream) const
+    {
+        return Philox4x32(seed, new_stream);
+    }
+
+private:
+    std::uint64_t seed{}, stream{}, position{};
+    counter_type buffer{};
+    bool buffer_valid{false};
+};
+
+// Standard normal draws indexed by (seed, stream, position). Normal number i of
+// a stream is always the same value, however the draws are batched, which is
+// what lets the engines split paths across threads and still reproduce results.
+class NormalGenerator
+{
+public:
+    NormalGenerator() = default;
+    explicit NormalGenerator(std::uint64_t seed, std::uint64_t stream = 0) : seed(seed), stream(stream) {}
+
+    double operator()();
+
+    // Write the next n normals into out.
+    void fill(double *out, std::size_t n);
+
+    void skip_ahead(std::uint64_t n)
+    {
+        position += n;
+        has_spare = false;
+    }
+
+    NormalGenerator split(std::uint64_t new_stream) const
+    {
+        return NormalGenerator(seed, new_stream);
+    }
+
+    std::uint64_t get_position() const
+    {
+        return position;
+    }
+
+private:
+    std::uint64_t seed{default_rng_seed}, stream{}, position{};
+    double spare{};
+    bool has_spare{false};
+
+    void normal_pair(std::uint64_t pair_index, double &z0, double &z1) const;
+};
 
 class SampleBoxMuller
 {
 
 public:
+    SampleBoxMuller() = default;
+    explicit SampleBoxMuller(std::uint64_t seed, std::uint64_t stream = 0) : engine(seed, stream) {}
+
     double operator()();
 
 private:
+    Philox4x32 engine;
     double result{}, x{}, y{}, norm2_sq{};
-};
\ No newline at end of file
+};
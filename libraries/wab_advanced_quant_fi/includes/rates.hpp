@@ -1,6 +1,27 @@
 #pragma once
+#include "analytic.hpp"
+#include "cache.hpp"
+#include "correlation.hpp"
+#include "grid_io.hpp"
+#include "linalg.hpp"
+#include "qmc.hpp"
+#include "random.hpp"
+#include "scenario.hpp"
+#include "statistics.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <tuple>
 #include <vector>
 
+// Forward-rate fixings of the chunks IR has simulated: for chunk c,
+// fixing[c][n * n_paths + p] is L_n on column n and deflator[c][...] the
+// matching D[N+1][n] / D[n+1][n]. Chunk c stays empty until it is simulated.
+struct RateFixingStore
+{
+    std::vector<std::vector<double>> fixing, deflator;
+};
+
 struct IR_results
 {
     IR_results() = default;
@@ -11,8 +32,17 @@ struct IR_results
 
     std::vector<double> datapoints;
     double value{};
+
+    // value with its standard error
+    MCEstimate estimate;
 };
 
+// Binary form of a simulation: the per-path datapoints as one array, plus
+// scalars value, estimate, standard_error and samples.
+void write_datapoints(GridWriter &writer, const IR_results &results);
+
+IR_results read_datapoints(const GridReader &reader);
+
 class IR
 {
 
@@ -34,10 +64,106 @@ public:
         return run_LIBOR_simulations();
     }
 
+    void set_seed(std::uint64_t newSeed)
+    {
+        this->seed = newSeed;
+    }
+
+    // 0 uses every hardware thread; the results do not depend on the count.
+    void set_threads(int newThreads)
+    {
+        this->threads = newThreads;
+    }
+
+    // Stop once the value's standard error is at most newTargetError, with M
+    // as the simulation budget. 0 always simulates M.
+    void set_target_error(double newTargetError)
+    {
+        this->target_error = newTargetError;
+    }
+
+    // Sobol increments with a Brownian bridge over the N steps; the standard
+    // error then comes from sobol_replications digital shifts.
+    void set_sampling(SamplingMethod newSampling)
+    {
+        this->sampling = newSampling;
+    }
+
+    // Multi-factor model: correlation has one row per forward rate L[0] .. L[N]
+    // and is factorized here, once. PCA with `factors` > 0 keeps that many
+    // factors. Without it every rate moves with one shared Brownian motion.
+    void set_correlation(const matrix<double> &correlation,
+                         CorrelationFactorization method = CorrelationFactorization::pca,
+                         std::size_t factors = 0);
+
+    // Closed form for caps: a sum of Black caplets, with no datapoints.
+    void set_engine(PricingEngine newEngine)
+    {
+        this->engine = newEngine;
+    }
+
+    void set_strike(double newStrike)
+    {
+        this->K = newStrike;
+    }
+
+    void set_notional(double newNotional)
+    {
+        this->notional = newNotional;
+    }
+
+    // get_simulation_data keeps every path's fixings (common random
+    // numbers), so a new strike or notional revalues the stored paths
+    // instead of simulating them again. The
+    // paths are keyed on alpha, sigma, dT, N, M, the seed, the sampling and
+    // the correlation, and take 16 (N + 1) bytes each.
+    void set_caching(bool newCaching)
+    {
+        this->caching = newCaching;
+        path_cache.clear();
+    }
+
+    CacheStats get_cache_stats() const
+    {
+        return path_cache.counters();
+    }
+
+    // Simulates the M paths get_simulation_data would and writes them to a
+    // scenario file: per chunk, "fixing" holds every path's fixings L_n and
+    // "deflator" the matching D[N+1][n] / D[n+1][n], both column-major
+    // (value [n * paths + p]), as in RateFixingStore.
+    void write_scenarios(const std::string &path) const;
+
+    // get_simulation_data values these scenarios instead of simulating. They
+    // must come from an IR with the same alpha, sigma, dT, N, M, seed,
+    // sampling and factor loadings, or it throws std::invalid_argument; the
+    // strike and notional are free.
+    void set_scenarios(std::shared_ptr<const ScenarioSet> newScenarios)
+    {
+        this->scenarios = std::move(newScenarios);
+    }
+
 private:
     double notional{}, K{0.05}, alpha{0.5}, sigma{0.15}, dT{0.5};
     int N{4}, M{10000};
     bool cap{false};
+    std::uint64_t seed{default_rng_seed};
+    int threads{1};
+    double target_error{};
+    SamplingMethod sampling{SamplingMethod::pseudo_random};
+    CorrelatedNormals rate_factors;
+    PricingEngine engine{PricingEngine::monte_carlo};
+    bool caching{false};
+
+    // correlation_version changes with every set_correlation
+    std::uint64_t correlation_version{};
+    using path_key = std::tuple<double, double, double, int, int, std::uint64_t, SamplingMethod, std::uint64_t>;
+    mutable CacheStage<path_key, RateFixingStore> path_cache;
+    std::shared_ptr<const ScenarioSet> scenarios;
 
+    CorrelatedNormals find_rate_factors() const;
+    std::vector<double> find_scenario_key(const CorrelatedNormals &correlated) const;
+    void simulate_fixings(const CorrelatedNormals &correlated, const SobolPaths *sobol, std::size_t chunk, std::size_t begin,
+                          std::size_t n_paths, double *fixing, double *deflator) const;
     IR_results run_LIBOR_simulations() const;
 };
@@ -0,0 +1,123 @@
+#pragma once
+#include "grid_io.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+// Scenario files: simulated paths generated once and priced many times. An
+// engine's write_scenarios simulates its M paths and streams them to a grid
+// file, one slice per chunk of mc_chunk_paths paths, each slice starting on
+// a page. After set_scenarios the engine prices from the mapped file instead
+// of simulating, reading the paths in place; processes pricing off the same
+// file share its pages.
+//
+// Besides the chunks, a file records the engine that wrote it and the
+// inputs its paths depend on (the key). An engine only prices off a file
+// whose key matches its own, so the contract inputs the paths do not depend
+// on (strikes, debt, notionals, payoffs) are free to change.
+enum class ScenarioEngine : std::uint32_t
+{
+    EQ1 = 1,
+    EQ2 = 2,
+    CR1 = 3,
+    IR = 4
+};
+
+constexpr std::size_t scenario_alignment = 4096;
+
+// Key of a simulation: its inputs, then the seed as two exact 32-bit halves
+std::vector<double> scenario_key(std::initializer_list<double> inputs, std::uint64_t seed);
+
+// Writes the chunks of a scenario file in order. Chunk c holds
+// chunk_paths(c) paths, which is the chunk's share of paths rounded up for
+// antithetic pairs; shorter last chunks are zero-padded to a full slice.
+class ScenarioWriter
+{
+public:
+    // Throws std::runtime_error if the file cannot be written
+    ScenarioWriter(const std::string &path, ScenarioEngine engine, const std::vector<double> &key,
+                   std::size_t paths, unsigned variance_reduction);
+
+    // An array of values_per_path values for every path of a chunk; returns
+    // the id to append to
+    std::size_t declare(const std::string &name, std::size_t values_per_path);
+
+    // values_per_path * chunk_paths(chunk) values of the next chunk
+    void append(std::size_t id, std::size_t chunk, const double *values);
+
+    std::size_t chunk_paths(std::size_t chunk) const
+    {
+        return paths_per_chunk[chunk];
+    }
+
+    void close();
+
+private:
+    GridWriter writer;
+    std::vector<std::size_t> paths_per_chunk, values_per_path;
+    std::size_t slice_paths{};
+    std::vector<double> padded;
+};
+
+// Read-only, memory-mapped scenario file
+class ScenarioSet
+{
+public:
+    // Throws std::runtime_error if the file is not a scenario file, or if
+    // its header or chunk arrays are inconsistent (e.g. truncated or edited)
+    explicit ScenarioSet(const std::string &path);
+
+    ScenarioEngine engine() const
+    {
+        return written_by;
+    }
+
+    const std::vector<double> &key() const
+    {
+        return inputs;
+    }
+
+    // Paths simulated, M
+    std::size_t paths() const
+    {
+        return n_paths;
+    }
+
+    std::size_t chunks() const
+    {
+        return paths_per_chunk.size();
+    }
+
+    std::size_t chunk_paths(std::size_t chunk) const
+    {
+        return paths_per_chunk[chunk];
+    }
+
+    bool contains(const std::string &name) const
+    {
+        return grid.contains(name);
+    }
+
+    // Zero-copy values of one chunk, laid out as the writing engine documents
+    const double *chunk(const std::string &name, std::size_t chunk) const;
+
+    // Number of values in that chunk: the values per path times chunk_paths
+    std::size_t chunk_values(const std::string &name, std::size_t chunk) const;
+
+    // Throws std::invalid_argument unless engine wrote the file with this key
+    void check(ScenarioEngine engine, const std::vector<double> &key, const std::string &caller) const;
+
+    const GridReader &reader() const
+    {
+        return grid;
+    }
+
+private:
+    GridReader grid;
+    ScenarioEngine written_by{};
+    std::vector<double> inputs;
+    std::size_t n_paths{};
+    std::vector<std::size_t> paths_per_chunk;
+};
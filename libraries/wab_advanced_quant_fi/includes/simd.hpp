@@ -0,0 +1,20 @@
+#pragma once
+
+// Instruction sets the Monte Carlo kernels can dispatch to. Every level
+// produces bit-identical results; only the speed differs.
+enum class SimdLevel
+{
+    scalar,
+    avx2,
+    avx512
+};
+
+// Best level supported by this CPU and build.
+SimdLevel detected_simd_level();
+
+SimdLevel active_simd_level();
+
+// Restrict the kernels to at most `level` (clamped to what the CPU supports).
+void set_simd_level(SimdLevel level);
+
+const char *simd_level_name(SimdLevel level);
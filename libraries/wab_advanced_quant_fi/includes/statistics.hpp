@@ -0,0 +1,207 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+// Inverse of the standard normal CDF (Acklam's rational approximation with
+// one Halley refinement step, accurate to about 1e-15). p must be in (0, 1).
+double normal_quantile(double p);
+
+struct ConfidenceInterval
+{
+    double lower{}, upper{};
+};
+
+// Monte Carlo estimate of a mean with its standard error.
+struct MCEstimate
+{
+    double value{}, standard_error{};
+    std::size_t samples{};
+
+    // Two-sided normal interval, e.g. level = 0.95 for value +/- 1.96 se
+    ConfidenceInterval confidence_interval(double level = 0.95) const
+    {
+        double half_width = normal_quantile(0.5 + 0.5 * level) * standard_error;
+        return ConfidenceInterval{value - half_width, value + half_width};
+    }
+};
+
+// Streaming mean and variance (Welford). Accumulators of disjoint samples can
+// be merged (Chan et al.), so each chunk of paths keeps its own and the chunks
+// are combined in order afterwards. The mean is also kept as a plain sum, so
+// it matches summing the samples in the same order.
+class RunningStats
+{
+public:
+    void add(double x)
+    {
+        ++n;
+        sum += x;
+        double delta = x - mean_;
+        mean_ += delta / n;
+        m2 += delta * (x - mean_);
+    }
+
+    void merge(const RunningStats &other)
+    {
+        if (other.n == 0)
+            return;
+
+        if (n == 0)
+        {
+            *this = other;
+            return;
+        }
+
+        double total = static_cast<double>(n + other.n);
+        double delta = other.mean_ - mean_;
+
+        mean_ += delta * other.n / total;
+        m2 += other.m2 + delta * delta * n * other.n / total;
+        sum += other.sum;
+        n += other.n;
+    }
+
+    std::size_t count() const
+    {
+        return n;
+    }
+
+    double mean() const
+    {
+        return n > 0 ? sum / n : 0.;
+    }
+
+    // Sample variance (n - 1 in the denominator)
+    double variance() const
+    {
+        return n > 1 ? m2 / (n - 1) : 0.;
+    }
+
+    double standard_error() const
+    {
+        return n > 0 ? std::sqrt(variance() / n) : 0.;
+    }
+
+    // Mean and standard error of scale * x
+    MCEstimate estimate(double scale = 1.) const
+    {
+        return MCEstimate{n > 0 ? scale * sum / n : 0., std::fabs(scale) * standard_error(), n};
+    }
+
+private:
+    std::size_t n{};
+    double sum{}, mean_{}, m2{};
+};
+
+// Running statistics of (x, y) pairs with their co-moment, mergeable like
+// RunningStats. Used for control variates: y is a control with known mean.
+class RunningCovariance
+{
+public:
+    void add(double x, double y)
+    {
+        double dx = x - xs.mean();
+        xs.add(x);
+        ys.add(y);
+        c += dx * (y - ys.mean());
+    }
+
+    void merge(const RunningCovariance &other)
+    {
+        std::size_t n = xs.count(), m = other.xs.count();
+        if (n > 0 && m > 0)
+            c += (other.xs.mean() - xs.mean()) * (other.ys.mean() - ys.mean()) * n * m / static_cast<double>(n + m);
+
+        c += other.c;
+        xs.merge(other.xs);
+        ys.merge(other.ys);
+    }
+
+    const RunningStats &x() const
+    {
+        return xs;
+    }
+
+    const RunningStats &y() const
+    {
+        return ys;
+    }
+
+    double covariance() const
+    {
+        return xs.count() > 1 ? c / (xs.count() - 1) : 0.;
+    }
+
+    // Estimate of E[x] from x - beta (y - E[y]) with the variance-minimising
+    // beta = Cov(x, y) / Var(y) taken from the same samples, scaled by scale.
+    MCEstimate control_variate_estimate(double y_expectation, double scale = 1.) const
+    {
+        std::size_t n = xs.count();
+        if (n == 0)
+            return MCEstimate{};
+
+        double var_y = ys.variance();
+        double beta = var_y > 0 ? covariance() / var_y : 0.;
+        double residual = xs.variance() - beta * covariance();
+        double value = xs.mean() - beta * (ys.mean() - y_expectation);
+
+        return MCEstimate{scale * value, std::fabs(scale) * std::sqrt(residual > 0 ? residual / n : 0.), n};
+    }
+
+private:
+    RunningStats xs, ys;
+    double c{};
+};
+
+// Randomised quasi-Monte Carlo: the samples of each independent
+// randomisation are kept apart. The estimate is the mean of the replication
+// means and its standard error their spread over sqrt(replications). With
+// fewer than two replications sampled the spread is unknown, and the
+// standard error is infinite rather than zero.
+class ReplicationStats
+{
+public:
+    ReplicationStats() = default;
+    explicit ReplicationStats(std::size_t replications) : stats(replications) {}
+
+    RunningStats &operator[](std::size_t r)
+    {
+        return stats[r];
+    }
+
+    void merge(const ReplicationStats &other)
+    {
+        if (stats.size() < other.stats.size())
+            stats.resize(other.stats.size());
+
+        for (std::size_t r = 0; r < other.stats.size(); ++r)
+            stats[r].merge(other.stats[r]);
+    }
+
+    MCEstimate estimate(double scale = 1.) const
+    {
+        RunningStats means;
+        std::size_t samples = 0;
+
+        for (const auto &replication : stats)
+        {
+            if (replication.count() == 0)
+                continue;
+
+            means.add(replication.mean());
+            samples += replication.count();
+        }
+
+        MCEstimate result = means.estimate(scale);
+        result.samples = samples;
+        if (means.count() < 2)
+            result.standard_error = std::numeric_limits<double>::infinity();
+
+        return result;
+    }
+
+private:
+    std::vector<RunningStats> stats;
+};
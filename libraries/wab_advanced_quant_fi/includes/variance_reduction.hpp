@@ -0,0 +1,29 @@
+#pragma once
+#include "random.hpp"
+#include "statistics.hpp"
+#include <cstddef>
+
+// Variance reduction options of the Monte Carlo engines; combine with |.
+enum VarianceReduction : unsigned
+{
+    vr_none = 0,
+    // Paths p and p + n / 2 of a chunk use opposite normals; each pair's
+    // average is one sample.
+    vr_antithetic = 1u << 0,
+    // Each time step's normals are shifted and scaled to sample mean 0 and
+    // variance 1 across the chunk. Adds an O(1/n) bias; the reported standard
+    // error treats the paths as independent.
+    vr_moment_matching = 1u << 1,
+    // Engine-specific control variate with a closed-form mean.
+    vr_control_variate = 1u << 2
+};
+
+// Paths simulated for a chunk of n: antithetic chunks are rounded up to pairs.
+std::size_t vr_chunk_paths(std::size_t n, unsigned variance_reduction);
+
+// Normals of one time step for the n paths of a chunk.
+void fill_step_normals(NormalGenerator &normal, double *eps, std::size_t n, unsigned variance_reduction);
+
+// Adds the per-path values of a chunk as samples (antithetic pairs averaged).
+void add_path_samples(RunningStats &stats, const double *x, std::size_t n, unsigned variance_reduction);
+void add_path_samples(RunningCovariance &stats, const double *x, const double *y, std::size_t n, unsigned variance_reduction);
@@ -0,0 +1,87 @@
+#include "analytic.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // d1 and d2 of a lognormal forward F with total volatility vol
+    void black_d(double F, double K, double vol, double &d1, double &d2)
+    {
+        d1 = std::log(F / K) / vol + 0.5 * vol;
+        d2 = d1 - vol;
+    }
+}
+
+double normal_cdf(double x)
+{
+    return 0.5 * std::erfc(-x / std::sqrt(2.));
+}
+
+double black_scholes_call(double S0, double K, double r, double sigma, double T)
+{
+    if (T <= 0 || sigma <= 0)
+        return std::max(S0 - K * std::exp(-r * T), 0.);
+
+    double vol = sigma * std::sqrt(T);
+    double d1 = (std::log(S0 / K) + (r + 0.5 * sigma * sigma) * T) / vol;
+    double d2 = d1 - vol;
+
+    return S0 * normal_cdf(d1) - K * std::exp(-r * T) * normal_cdf(d2);
+}
+
+double black_scholes_put(double S0, double K, double r, double sigma, double T)
+{
+    if (T <= 0 || sigma <= 0)
+        return std::max(K * std::exp(-r * T) - S0, 0.);
+
+    double vol = sigma * std::sqrt(T);
+    double d1 = (std::log(S0 / K) + (r + 0.5 * sigma * sigma) * T) / vol;
+    double d2 = d1 - vol;
+
+    return K * std::exp(-r * T) * normal_cdf(-d2) - S0 * normal_cdf(-d1);
+}
+
+double margrabe_exchange(double S1, double S2, double sigma1, double sigma2, double rho, double T)
+{
+    double variance = std::max(sigma1 * sigma1 + sigma2 * sigma2 - 2 * rho * sigma1 * sigma2, 0.) * T;
+
+    if (variance <= 0)
+        return std::max(S1 - S2, 0.);
+
+    double d1{}, d2{};
+    black_d(S1, S2, std::sqrt(variance), d1, d2);
+
+    return S1 * normal_cdf(d1) - S2 * normal_cdf(d2);
+}
+
+double merton_equity(double V0, double D, double r, double sigma, double T)
+{
+    return black_scholes_call(V0, D, r, sigma, T);
+}
+
+double merton_debt(double V0, double D, double r, double sigma, double T)
+{
+    return V0 - merton_equity(V0, D, r, sigma, T);
+}
+
+double merton_default_probability(double V0, double D, double r, double sigma, double T)
+{
+    if (T <= 0 || sigma <= 0)
+        return V0 * std::exp(r * std::max(T, 0.)) < D ? 1. : 0.;
+
+    double vol = sigma * std::sqrt(T);
+    double d2 = (std::log(V0 / D) + (r - 0.5 * sigma * sigma) * T) / vol;
+
+    return normal_cdf(-d2);
+}
+
+double black_caplet(double F, double K, double sigma, double T, double discount)
+{
+    if (T <= 0 || sigma <= 0)
+        return discount * std::max(F - K, 0.);
+
+    double d1{}, d2{};
+    black_d(F, K, sigma * std::sqrt(T), d1, d2);
+
+    return discount * (F * normal_cdf(d1) - K * normal_cdf(d2));
+}
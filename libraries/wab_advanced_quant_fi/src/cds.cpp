@@ -0,0 +1,286 @@
+#include "cds.hpp"
+#include "simd.hpp"
+#include "simd_kernels.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    void cds_legs(const double *discount, const double *discount_accrual, const std::size_t *pattern, std::size_t n_periods,
+                  const double *step, std::size_t n_trades, double *premium, double *protection)
+    {
+        switch (active_simd_level())
+        {
+#if defined(WAB_SIMD_X86)
+        case SimdLevel::avx512:
+            cds_legs_avx512(discount, discount_accrual, pattern, n_periods, step, n_trades, premium, protection);
+            break;
+        case SimdLevel::avx2:
+            cds_legs_avx2(discount, discount_accrual, pattern, n_periods, step, n_trades, premium, protection);
+            break;
+#endif
+        default:
+            cds_legs_lanes<ScalarLanes>(discount, discount_accrual, pattern, n_periods, step, n_trades, premium, protection);
+        }
+    }
+
+    bool increasing(const std::vector<double> &times)
+    {
+        for (std::size_t k = 0; k < times.size(); k++)
+            if (!(times[k] > (k ? times[k - 1] : 0.)))
+                return false;
+
+        return true;
+    }
+}
+
+PiecewiseFlatCurve::PiecewiseFlatCurve(std::vector<double> times, std::vector<double> rates) : times(std::move(times)), rates(std::move(rates))
+{
+    if (this->rates.empty() || this->times.size() != this->rates.size() || !increasing(this->times))
+        throw std::invalid_argument("PiecewiseFlatCurve: need increasing positive times, one per rate");
+}
+
+double PiecewiseFlatCurve::integral(double t) const
+{
+    double sum = 0., start = 0.;
+
+    for (std::size_t k = 0; k < times.size() && start < t; k++)
+    {
+        double end = k + 1 < times.size() ? std::min(t, times[k]) : t;
+        sum += rates[k] * (end - start);
+        start = end;
+    }
+
+    return sum;
+}
+
+std::vector<double> cds_payment_times(double maturity, int payments_per_year)
+{
+    if (!(maturity > 0) || payments_per_year <= 0)
+        throw std::invalid_argument("cds_payment_times: maturity and payment frequency must be positive");
+
+    // Dates within a small tolerance of maturity are merged into it
+    std::vector<double> times;
+    double tolerance = 1e-9 * maturity;
+
+    for (int j = 1;; j++)
+    {
+        double t = static_cast<double>(j) / payments_per_year;
+        if (t >= maturity - tolerance)
+            break;
+
+        times.push_back(t);
+    }
+    times.push_back(maturity);
+
+    return times;
+}
+
+CdsBatchPricer::CdsBatchPricer(const PiecewiseFlatCurve &discount_curve, std::vector<double> payment_times, std::vector<double> hazard_times)
+    : hazard_times(std::move(hazard_times))
+{
+    if (!increasing(payment_times))
+        throw std::invalid_argument("CdsBatchPricer: payment times must be positive and increasing");
+
+    if (this->hazard_times.empty() || !increasing(this->hazard_times))
+        throw std::invalid_argument("CdsBatchPricer: hazard knots must be positive and increasing");
+
+    std::size_t n_periods = payment_times.size(), n_knots = this->hazard_times.size();
+    discount.resize(n_periods);
+    discount_accrual.resize(n_periods);
+    pattern.resize(n_periods);
+
+    std::vector<double> shape(n_knots);
+
+    for (std::size_t j = 0; j < n_periods; j++)
+    {
+        double start = j ? payment_times[j - 1] : 0., end = payment_times[j];
+
+        discount[j] = discount_curve.factor(end);
+        discount_accrual[j] = discount[j] * (end - start);
+
+        // Overlap of (start, end] with each knot interval; the last is open-ended
+        for (std::size_t k = 0; k < n_knots; k++)
+        {
+            double lower = k ? this->hazard_times[k - 1] : 0.;
+            double upper = k + 1 < n_knots ? this->hazard_times[k] : std::max(end, lower);
+            shape[k] = std::max(0., std::min(end, upper) - std::max(start, lower));
+        }
+
+        std::size_t q = 0;
+        while (q < n_patterns && !std::equal(shape.begin(), shape.end(), overlap.begin() + q * n_knots))
+            q++;
+
+        if (q == n_patterns)
+        {
+            overlap.insert(overlap.end(), shape.begin(), shape.end());
+            n_patterns++;
+        }
+
+        pattern[j] = q;
+    }
+}
+
+CdsBatchResults CdsBatchPricer::price(const matrix<double> &hazards, const std::vector<double> &recovery, const std::vector<double> &notional) const
+{
+    std::size_t n_trades = hazards.rows();
+
+    if (hazards.cols() != hazard_times.size() || recovery.size() != n_trades || notional.size() != n_trades)
+        throw std::invalid_argument("CdsBatchPricer::price: need one hazard row, recovery and notional per trade");
+
+    CdsBatchResults results;
+    results.pv_premium_leg.resize(n_trades);
+    results.pv_default_leg.resize(n_trades);
+    results.cds_spread_in_bps.resize(n_trades);
+
+    find_legs(hazards.view(), recovery.data(), notional.data(), results.pv_premium_leg.data(), results.pv_default_leg.data(),
+              results.cds_spread_in_bps.data());
+
+    return results;
+}
+
+void CdsBatchPricer::find_legs(matrix_view<const double> hazards, const double *recovery, const double *notional,
+                               double *pv_premium_leg, double *pv_default_leg, double *cds_spread_in_bps) const
+{
+    std::size_t n_trades = hazards.rows(), n_knots = hazard_times.size();
+
+    // step[q * n_trades + i]: survival factor of trade i over a period of shape q
+    std::vector<double> step(n_patterns * n_trades);
+    for (std::size_t q = 0; q < n_patterns; q++)
+        for (std::size_t i = 0; i < n_trades; i++)
+        {
+            double exponent = 0.;
+            for (std::size_t k = 0; k < n_knots; k++)
+                exponent += overlap[q * n_knots + k] * hazards(i, k);
+
+            step[q * n_trades + i] = std::exp(-exponent);
+        }
+
+    std::vector<double> premium(n_trades), protection(n_trades);
+    cds_legs(discount.data(), discount_accrual.data(), pattern.data(), pattern.size(), step.data(), n_trades,
+             premium.data(), protection.data());
+
+    for (std::size_t i = 0; i < n_trades; i++)
+    {
+        pv_premium_leg[i] = notional[i] * premium[i];
+        pv_default_leg[i] = (1. - recovery[i]) * notional[i] * protection[i];
+        cds_spread_in_bps[i] = pv_default_leg[i] / pv_premium_leg[i] * 10000;
+    }
+}
+
+PiecewiseFlatCurve bootstrap_hazard_curve(const PiecewiseFlatCurve &discount_curve, const std::vector<double> &tenors,
+                                          const std::vector<double> &spreads_in_bps, double recovery, int payments_per_year)
+{
+    if (tenors.empty() || tenors.size() != spreads_in_bps.size() || !increasing(tenors))
+        throw std::invalid_argument("bootstrap_hazard_curve: need increasing tenors, one per spread");
+
+    std::vector<double> hazards;
+    hazards.reserve(tenors.size());
+
+    for (std::size_t k = 0; k < tenors.size(); k++)
+    {
+        std::vector<double> times = cds_payment_times(tenors[k], payments_per_year);
+        std::size_t n = times.size();
+        double start = k ? tenors[k - 1] : 0.;
+        double spread = spreads_in_bps[k] / 10000;
+
+        // log Q(t_j) = -(base_j + h exposure_j), with h the unknown hazard of (start, tenor]
+        std::vector<double> df(n), accrual(n), base(n), exposure(n);
+        for (std::size_t j = 0; j < n; j++)
+        {
+            df[j] = discount_curve.factor(times[j]);
+            accrual[j] = times[j] - (j ? times[j - 1] : 0.);
+
+            double fixed = 0., t = std::min(times[j], start);
+            for (std::size_t m = 0; m < k && t > 0; m++)
+            {
+                double lower = m ? tenors[m - 1] : 0.;
+                fixed += hazards[m] * std::max(0., std::min(t, tenors[m]) - lower);
+            }
+
+            base[j] = fixed;
+            exposure[j] = std::max(0., times[j] - start);
+        }
+
+        // Default leg - spread x premium leg per unit notional, and its slope in h
+        auto residual_at = [&](double h, double &slope)
+        {
+            double f = 0., q_prev = 1., dq_prev = 0.;
+            slope = 0.;
+
+            for (std::size_t j = 0; j < n; j++)
+            {
+                double q = std::exp(-(base[j] + h * exposure[j]));
+                double dq = -exposure[j] * q;
+
+                f += df[j] * ((1 - recovery) * (q_prev - q) - spread * accrual[j] * q);
+                slope += df[j] * ((1 - recovery) * (dq_prev - dq) - spread * accrual[j] * dq);
+
+                q_prev = q;
+                dq_prev = dq;
+            }
+
+            return f;
+        };
+
+        // The residual rises with h (for falling discount factors), so its
+        // signs at 0 and as h -> infinity decide whether there is a root. In
+        // the limit survival past the pillar start vanishes: the default leg
+        // keeps (1 - R) D Q at the start and the later premiums drop out.
+        double slope = 0.;
+        if (residual_at(0., slope) > 0)
+            throw std::invalid_argument("bootstrap_hazard_curve: quotes need a negative hazard rate");
+
+        double limit = 0., q_start = 1.;
+        for (std::size_t j = 0; j < n; j++)
+        {
+            double q = exposure[j] > 0 ? 0. : std::exp(-base[j]);
+            limit += df[j] * ((1 - recovery) * (q_start - q) - spread * accrual[j] * q);
+            q_start = q;
+        }
+
+        if (!(limit > 0))
+            throw std::invalid_argument("bootstrap_hazard_curve: quote at pillar " + std::to_string(k) + " is not attainable");
+
+        // Newton from the credit-triangle guess, kept inside the bracket
+        // [lower, upper] of the root: steps that leave it bisect, or double h
+        // while no upper bound is known
+        double h = std::max(spread / (1 - recovery), 1e-8);
+        double lower = 0., upper = std::numeric_limits<double>::infinity();
+        constexpr int max_iterations = 100;
+        int iteration = 0;
+        double residual = 0.;
+
+        for (; iteration < max_iterations; iteration++)
+        {
+            residual = residual_at(h, slope);
+            (residual < 0 ? lower : upper) = h;
+
+            double next = h - residual / slope;
+            if (!(next >= lower && next <= upper))
+                next = std::isfinite(upper) ? 0.5 * (lower + upper) : 2 * h;
+
+            double change = next - h;
+            h = next;
+
+            if (std::fabs(change) <= 1e-15 * (1 + std::fabs(h)))
+                break;
+        }
+
+        if (iteration == max_iterations || !std::isfinite(h))
+        {
+            std::ostringstream message;
+            message << "bootstrap_hazard_curve: Newton did not converge at pillar " << k << " (tenor " << tenors[k]
+                    << "), last residual " << residual;
+            throw std::runtime_error(message.str());
+        }
+
+        hazards.push_back(h);
+    }
+
+    return PiecewiseFlatCurve(tenors, hazards);
+}
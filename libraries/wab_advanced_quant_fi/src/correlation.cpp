@@ -0,0 +1,127 @@
+#include "correlation.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+    // Paths per block of CorrelatedNormals::apply
+    constexpr std::size_t apply_block_paths = 64;
+}
+
+CorrelatedNormals::CorrelatedNormals(const matrix<double> &correlation, CorrelationFactorization method, std::size_t factors)
+{
+    std::size_t n = correlation.rows();
+
+    if (correlation.cols() != n)
+        throw std::invalid_argument("CorrelatedNormals: correlation matrix must be square");
+
+    for (std::size_t i = 0; i < n; i++)
+        if (std::fabs(correlation(i, i) - 1) > 1e-12)
+            throw std::invalid_argument("CorrelatedNormals: correlation matrix must have a unit diagonal");
+
+    if (factors == 0 || factors > n)
+        factors = n;
+
+    if (method == CorrelationFactorization::cholesky)
+    {
+        if (factors != n)
+            throw std::invalid_argument("CorrelatedNormals: Cholesky keeps every factor");
+
+        loadings_ = cholesky_decompose(correlation);
+    }
+
+    else
+    {
+        std::vector<double> values;
+        matrix<double> vectors;
+        symmetric_eigen(correlation, values, vectors);
+
+        loadings_ = matrix<double>(n, factors);
+
+        for (std::size_t i = 0; i < n; i++)
+        {
+            double norm = 0.;
+            for (std::size_t f = 0; f < factors; f++)
+            {
+                loadings_(i, f) = vectors(i, f) * std::sqrt(std::max(values[f], 0.));
+                norm += loadings_(i, f) * loadings_(i, f);
+            }
+
+            if (norm == 0.)
+                throw std::invalid_argument("CorrelatedNormals: a variable has no weight on the kept factors");
+
+            norm = std::sqrt(norm);
+            for (std::size_t f = 0; f < factors; f++)
+                loadings_(i, f) /= norm;
+        }
+    }
+
+    find_row_factors();
+}
+
+CorrelatedNormals CorrelatedNormals::from_loadings(const matrix<double> &loadings)
+{
+    CorrelatedNormals result;
+    result.loadings_ = loadings;
+    result.find_row_factors();
+
+    return result;
+}
+
+void CorrelatedNormals::find_row_factors()
+{
+    row_factors.assign(dimensions(), 0);
+
+    for (std::size_t i = 0; i < dimensions(); i++)
+        for (std::size_t f = factors(); f-- > 0;)
+            if (loadings_(i, f) != 0.)
+            {
+                row_factors[i] = f + 1;
+                break;
+            }
+}
+
+void CorrelatedNormals::apply(const double *z, double *out, std::size_t n_paths) const
+{
+    for (std::size_t first = 0; first < n_paths; first += apply_block_paths)
+    {
+        std::size_t block = std::min(apply_block_paths, n_paths - first);
+
+        for (std::size_t i = 0; i < dimensions(); i++)
+        {
+            double *x = out + i * n_paths + first;
+
+            if (row_factors[i] == 0)
+            {
+                std::fill(x, x + block, 0.);
+                continue;
+            }
+
+            double a = loadings_(i, 0);
+            const double *z_f = z + first;
+            for (std::size_t p = 0; p < block; p++)
+                x[p] = z_f[p] * a;
+
+            for (std::size_t f = 1; f < row_factors[i]; f++)
+            {
+                a = loadings_(i, f);
+                z_f = z + f * n_paths + first;
+
+                for (std::size_t p = 0; p < block; p++)
+                    x[p] += a * z_f[p];
+            }
+        }
+    }
+}
+
+matrix<double> exponential_correlation(std::size_t dimensions, double beta, double spacing)
+{
+    matrix<double> correlation(dimensions, dimensions);
+
+    for (std::size_t i = 0; i < dimensions; i++)
+        for (std::size_t j = 0; j < dimensions; j++)
+            correlation(i, j) = std::exp(-beta * spacing * std::fabs(static_cast<double>(i) - static_cast<double>(j)));
+
+    return correlation;
+}
@@ -1,65 +1,226 @@
 #include "credit.hpp"
+#include "analytic.hpp"
+#include "gbm.hpp"
+#include "instrumentation.hpp"
+#include "parallel.hpp"
+#include "qmc.hpp"
 #include "random.hpp"
+#include "variance_reduction.hpp"
 #include <algorithm>
+#include <cmath>
 #include <vector>
 
 CR1_results CR1::find_payoff_and_defaults() const
 {
-    std::vector<double> V(N + 1);
-    double sumpayoff = 0;
+    // percentage_defaults counts the paths that end with V(T) > D
+    if (engine != PricingEngine::monte_carlo)
+    {
+        CR1_results results;
+        results.equity_payoff = results.equity_payoff_estimate.value = merton_equity(V0, D, r, sigma, T);
+        results.percentage_defaults = results.percentage_defaults_estimate.value =
+            100. * (1 - merton_default_probability(V0, D, r, sigma, T));
+
+        return results;
+    }
+
+    struct chunk_totals
+    {
+        RunningCovariance payoff;
+        RunningStats defaults;
+
+        void merge(const chunk_totals &other)
+        {
+            payoff.merge(other.payoff);
+            defaults.merge(other.defaults);
+        }
+    };
+
     double dt = T / N;
-    double default_count = 0.;
+    double growth = 1 + r * dt, vol = sigma * sqrt(dt);
+
+    // Control for the equity payoff: max(V(T) - D, 0) under exact GBM driven
+    // by the same W(T), whose mean is the Black-Scholes price
+    bool control = variance_reduction & vr_control_variate;
+    double control_drift = (r - 0.5 * sigma * sigma) * T;
+    double control_mean = exp(r * T) * black_scholes_call(V0, D, r, sigma, T);
 
-    SampleBoxMuller normal;
+    if (scenarios)
+        scenarios->check(ScenarioEngine::CR1, find_scenario_key(), "CR1::get_payoff_and_defaults");
 
-    for (int i = 0; i < M; i++)
+    auto simulate_chunk = [&](std::size_t chunk, std::size_t begin, std::size_t end)
     {
-        V[0] = V0;
+        std::size_t n_paths = vr_chunk_paths(end - begin, variance_reduction);
+        std::vector<PathState> states;
+        std::vector<double> simulated_V, simulated_W;
+        const double *V = nullptr, *W = nullptr;
 
-        for (int j = 0; j < N; j++)
+        WAB_COUNT("cr1.paths", n_paths);
+
+        if (scenarios)
         {
-            double epsilon = normal();
-            V[j + 1] = V[j] * (1 + r * dt + sigma * sqrt(dt) * epsilon);
+            WAB_COUNT("cr1.scenario_paths", n_paths);
+
+            V = scenarios->chunk("terminal", chunk);
+            if (control)
+                W = scenarios->chunk("brownian", chunk);
         }
 
-        sumpayoff += std::max(V[N] - D, 0.);
+        else
+        {
+            WAB_TIME_SCOPE("cr1.simulate");
+            WAB_COUNT("cr1.steps", static_cast<std::uint64_t>(N) * n_paths);
 
-        if (V[N] > D)
+            states.resize(n_paths);
+            simulated_W.resize(control ? n_paths : 0);
+
+            ChunkNormals normals(nullptr, seed, chunk, n_paths, N, 1, variance_reduction);
+            simulate_gbm_paths(normals, n_paths, N, V0, growth, vol, path_terminal, states.data(),
+                               control ? simulated_W.data() : nullptr);
+
+            simulated_V.resize(n_paths);
+            for (std::size_t p = 0; p < n_paths; ++p)
+                simulated_V[p] = states[p].terminal;
+
+            V = simulated_V.data();
+            W = simulated_W.data();
+        }
+
+        std::vector<double> payoffs(n_paths), controls(n_paths), defaults(n_paths);
+        for (std::size_t p = 0; p < n_paths; ++p)
         {
-            default_count++;
+            payoffs[p] = std::max(V[p] - D, 0.);
+            defaults[p] = V[p] > D ? 100. : 0.;
+
+            if (control)
+                controls[p] = std::max(V0 * exp(control_drift + vol * W[p]) - D, 0.);
         }
-    }
+
+        chunk_totals totals;
+        add_path_samples(totals.payoff, payoffs.data(), controls.data(), n_paths, variance_reduction);
+        add_path_samples(totals.defaults, defaults.data(), n_paths, variance_reduction);
+
+        return totals;
+    };
+
+    double discount = exp(-r * T);
+    auto estimate = [&](const RunningCovariance &payoff)
+    { return control ? payoff.control_variate_estimate(control_mean, discount) : payoff.x().estimate(discount); };
+    auto error = [&](const chunk_totals &totals)
+    { return estimate(totals.payoff).standard_error; };
+
+    chunk_totals totals = merge_chunks_to_target<chunk_totals>(M, mc_chunk_paths, threads, target_error, simulate_chunk, error);
 
     CR1_results results;
-    results.equity_payoff = exp(-r * T) * (sumpayoff / M);
-    results.percentage_defaults = 100 * default_count / M;
+    results.equity_payoff_estimate = estimate(totals.payoff);
+    results.percentage_defaults_estimate = totals.defaults.estimate();
+    results.equity_payoff = results.equity_payoff_estimate.value;
+    results.percentage_defaults = results.percentage_defaults_estimate.value;
 
     return results;
 }
 
+std::vector<double> CR1::find_scenario_key() const
+{
+    return scenario_key({T, V0, sigma, r, static_cast<double>(N), static_cast<double>(M),
+                         static_cast<double>(variance_reduction)},
+                        seed);
+}
+
+void CR1::write_scenarios(const std::string &path, bool full_paths) const
+{
+    double dt = T / N;
+    double growth = 1 + r * dt, vol = sigma * sqrt(dt);
+    bool control = variance_reduction & vr_control_variate;
+
+    ScenarioWriter writer(path, ScenarioEngine::CR1, find_scenario_key(), M, variance_reduction);
+    std::size_t terminal_id = writer.declare("terminal", 1);
+    std::size_t brownian_id = control ? writer.declare("brownian", 1) : 0;
+    std::size_t path_id = full_paths ? writer.declare("path", N) : 0;
+
+    struct chunk_paths
+    {
+        std::vector<double> V, W, path;
+    };
+
+    auto simulate_chunk = [&](std::size_t chunk, std::size_t begin, std::size_t end)
+    {
+        std::size_t n_paths = vr_chunk_paths(end - begin, variance_reduction);
+        WAB_TIME_SCOPE("cr1.simulate");
+        WAB_COUNT("cr1.paths", n_paths);
+        WAB_COUNT("cr1.steps", static_cast<std::uint64_t>(N) * n_paths);
+
+        std::vector<PathState> states(n_paths);
+        chunk_paths result;
+        result.W.resize(control ? n_paths : 0);
+        result.path.resize(full_paths ? N * n_paths : 0);
+
+        ChunkNormals normals(nullptr, seed, chunk, n_paths, N, 1, variance_reduction);
+        simulate_gbm_paths(normals, n_paths, N, V0, growth, vol, path_terminal, states.data(),
+                           control ? result.W.data() : nullptr, full_paths ? result.path.data() : nullptr);
+
+        for (const auto &state : states)
+            result.V.push_back(state.terminal);
+
+        return result;
+    };
+
+    stream_chunks<chunk_paths>(M, mc_chunk_paths, threads, simulate_chunk, [&](std::size_t chunk, const chunk_paths &result)
+                               {
+                                   writer.append(terminal_id, chunk, result.V.data());
+                                   if (control)
+                                       writer.append(brownian_id, chunk, result.W.data());
+                                   if (full_paths)
+                                       writer.append(path_id, chunk, result.path.data()); });
+
+    writer.close();
+}
+
+Greeks CR1::find_greeks() const
+{
+    return gbm_greeks(CallPayoff(D), V0, sigma, r, T, N, M, seed, threads, target_error);
+}
+
 CR2_results CR2::find_pv_premium_and_default_legs_and_cds_spread() const
 {
     double pv_premium_leg = 0;
     double pv_default_leg = 0;
-    double t = 0;
     double cds_spread = 0;
 
     int array_size = static_cast<int>(N * T + 1);
+    double dt = T / N;
 
-    std::vector<double> DF(array_size);
-    std::vector<double> P(array_size);
+    // DF[j] = exp(-r t_j) and P[j] = exp(-h t_j), with P[0] = 1
+    auto curve = [&](double rate, std::vector<double> &factors)
+    {
+        factors.assign(array_size, 1.);
+        for (int j = 1; j < array_size; j++)
+            factors[j] = exp(-rate * (j * dt));
+    };
 
-    P[0] = 1.;
-    double dt = T / N;
+    std::vector<double> DF, P;
+    const std::vector<double> *discount = &DF, *survival = &P;
 
-    for (int j = 1; j < array_size; j++)
+    std::unique_lock<std::mutex> discount_lock, survival_lock;
+    if (caching)
+    {
+        discount_lock = discount_cache.lock();
+        survival_lock = survival_cache.lock();
+
+        discount = &discount_cache.fetch(curve_key(T, N, r), [&](std::vector<double> &factors)
+                                         { curve(r, factors); });
+        survival = &survival_cache.fetch(curve_key(T, N, h), [&](std::vector<double> &factors)
+                                         { curve(h, factors); });
+    }
+    else
     {
-        t = j * dt;
-        DF[j] = exp(-r * t);
-        P[j] = exp(-h * t);
+        curve(r, DF);
+        curve(h, P);
+    }
 
-        pv_premium_leg += DF[j] * notional * dt * P[j];
-        pv_default_leg += DF[j] * (1. - rr) * notional * (P[j - 1] - P[j]);
+    for (int j = 1; j < array_size; j++)
+    {
+        pv_premium_leg += (*discount)[j] * notional * dt * (*survival)[j];
+        pv_default_leg += (*discount)[j] * (1. - rr) * notional * ((*survival)[j - 1] - (*survival)[j]);
     }
 
     cds_spread = pv_default_leg / pv_premium_leg;
@@ -71,4 +232,4 @@ CR2_results CR2::find_pv_premium_and_default_legs_and_cds_spread() const
     results.cds_spread_in_bps = cds_spread * 10000;
 
     return results;
-}
\ No newline at end of file
+}
@@ -1,57 +1,797 @@
 #include "equity.hpp"
+#include "analytic.hpp"
+#include "correlation.hpp"
+#include "instrumentation.hpp"
+#include "gbm.hpp"
+#include "lsm.hpp"
+#include "parallel.hpp"
+#include "qmc.hpp"
 #include "random.hpp"
+#include "variance_reduction.hpp"
 #include <algorithm>
+#include <numeric>
+#include <stdexcept>
 #include <vector>
 #include <cmath>
+#include <type_traits>
 
-double EQ1::find_premium() const
+namespace
 {
+    matrix<double> two_asset_correlation(double rho)
+    {
+        matrix<double> correlation(2, 2);
+        correlation(0, 0) = correlation(1, 1) = 1.;
+        correlation(0, 1) = correlation(1, 0) = rho;
+
+        return correlation;
+    }
+
+    // EQ2's two correlated GBM assets for the n paths of a chunk. S receives
+    // the terminal values asset-major (S[a * n + p]); W, if not null, the sum
+    // of each asset's step normals the same way; path, if not null, S after
+    // every step, path[(2 i + a) * n + p] after step i + 1.
+    void simulate_two_assets(ChunkNormals &normals, const CorrelatedNormals &correlated, std::size_t n, int steps,
+                             double S10, double S20, double growth, double vol1, double vol2, double *S, double *W, double *path)
+    {
+        double *S1 = S, *S2 = S + n;
+        std::fill_n(S1, n, S10);
+        std::fill_n(S2, n, S20);
+
+        std::vector<double> z(2 * n), eps(2 * n);
+        double *eps1 = eps.data(), *eps2 = eps.data() + n;
+
+        if (W)
+            std::fill_n(W, 2 * n, 0.);
+
+        for (int i = 0; i < steps; ++i)
+        {
+            normals.fill(z.data());
+            normals.fill(z.data() + n);
+            correlated.apply(z.data(), eps.data(), n);
+
+            gbm_step(S1, eps1, n, growth, vol1);
+            gbm_step(S2, eps2, n, growth, vol2);
+
+            if (W)
+                for (std::size_t p = 0; p < 2 * n; ++p)
+                    W[p] += eps[p];
+
+            if (path)
+                std::copy_n(S, 2 * n, path + 2 * i * n);
+        }
+    }
+}
+
+MCEstimate EQ1::find_premium() const
+{
+    if (engine != PricingEngine::monte_carlo)
+    {
+        MCEstimate exact;
+        if (find_closed_form(exact))
+            return exact;
+
+        if (engine == PricingEngine::analytic)
+            throw std::logic_error("EQ1::get_premium: payoff has no closed form");
+    }
 
-    double sum_payoff{}, premium{};
     double dt = T / N;
-    std::vector<double> S(N + 1);
+    double growth = 1 + r * dt, vol = sigma * std::sqrt(dt);
 
-    SampleBoxMuller normal;
+    std::shared_ptr<const Payoff> option = payoff ? payoff : std::make_shared<CallPayoff>(K);
+    unsigned statistics = option->statistics();
 
-    for (int j = 0; j < M; ++j)
+    // Sobol runs estimate their error from the digital shifts and take no
+    // variance reduction
+    std::unique_ptr<SobolPaths> sobol;
+    if (sampling == SamplingMethod::sobol)
+        sobol = std::make_unique<SobolPaths>(N, 1, seed);
+    unsigned reduction = sobol ? vr_none : variance_reduction;
+
+    // Control: the call on K under exact GBM driven by the same W(T), whose
+    // mean is the Black-Scholes price
+    bool control = reduction & vr_control_variate;
+    double control_drift = (r - 0.5 * sigma * sigma) * T;
+    double control_mean = std::exp(r * T) * black_scholes_call(S0, K, r, sigma, T);
+
+    if (scenarios)
+        scenarios->check(ScenarioEngine::EQ1, find_scenario_key(), "EQ1::get_premium");
+
+    // Cached path states cover every statistic asked for so far
+    PathStateStore *store = nullptr;
+    std::unique_lock<std::mutex> lock;
+    if (caching && !scenarios)
     {
-        S[0] = S0;
-        for (int i = 0; i < N; ++i)
+        std::size_t n_chunks = (static_cast<std::size_t>(M) + mc_chunk_paths - 1) / mc_chunk_paths;
+        auto reset = [&](PathStateStore &fresh, unsigned wanted)
         {
-            double epsilon = normal();
-            S[i + 1] = S[i] * (1 + r * dt + sigma * std::sqrt(dt) * epsilon);
+            fresh = PathStateStore{};
+            fresh.statistics = wanted;
+            fresh.states.resize(n_chunks);
+            fresh.brownian.resize(n_chunks);
+        };
+
+        lock = path_cache.lock();
+        store = &path_cache.fetch(path_key(T, S0, sigma, r, N, M, seed, sampling, reduction), [&](PathStateStore &fresh)
+                                  { reset(fresh, statistics); });
+
+        if ((store->statistics & statistics) != statistics)
+            reset(*store, store->statistics | statistics);
+
+        statistics = store->statistics;
+    }
+
+    // Paths of a chunk advance together, one time step at a time, keeping
+    // only the running statistics the payoff asked for. Stored paths, from a
+    // scenario file or the cache, are read in place.
+    auto simulate_chunk = [&](std::size_t chunk, std::size_t begin, std::size_t end)
+    {
+        std::size_t n_paths = vr_chunk_paths(end - begin, reduction);
+        std::vector<PathState> simulated;
+        std::vector<double> simulated_W;
+        const PathState *states = nullptr;
+        const double *W = nullptr;
+
+        WAB_COUNT("eq1.paths", n_paths);
+
+        if (scenarios)
+        {
+            WAB_COUNT("eq1.scenario_paths", n_paths);
+
+            // Scenario files store each PathState as four packed doubles
+            static_assert(std::is_standard_layout_v<PathState> && sizeof(PathState) == 4 * sizeof(double),
+                          "PathState must be four doubles with no padding");
+            states = reinterpret_cast<const PathState *>(scenarios->chunk("state", chunk));
+            if (control)
+                W = scenarios->chunk("brownian", chunk);
+        }
+
+        else if (store && !store->states[chunk].empty())
+        {
+            WAB_COUNT("eq1.cached_paths", n_paths);
+
+            states = store->states[chunk].data();
+            W = store->brownian[chunk].data();
+        }
+
+        else
+        {
+            WAB_TIME_SCOPE("eq1.simulate");
+            WAB_COUNT("eq1.steps", static_cast<std::uint64_t>(N) * n_paths);
+
+            simulated.resize(n_paths);
+            simulated_W.resize(control ? n_paths : 0);
+
+            ChunkNormals normals(sobol.get(), seed, chunk, n_paths, N, 1, reduction);
+            simulate_gbm_paths(normals, n_paths, N, S0, growth, vol, statistics, simulated.data(),
+                               control ? simulated_W.data() : nullptr);
+
+            // Each chunk is written by the one thread simulating it
+            if (store)
+            {
+                store->states[chunk] = simulated;
+                store->brownian[chunk] = simulated_W;
+            }
+
+            states = simulated.data();
+            W = simulated_W.data();
+        }
+
+        WAB_TIME_SCOPE("eq1.payoff");
+
+        std::vector<double> payoffs(n_paths), controls(n_paths);
+        for (std::size_t p = 0; p < n_paths; ++p)
+        {
+            payoffs[p] = (*option)(states[p]);
+
+            if (control)
+                controls[p] = std::max(S0 * std::exp(control_drift + vol * W[p]) - K, 0.);
+        }
+
+        RunningCovariance samples;
+        add_path_samples(samples, payoffs.data(), controls.data(), n_paths, reduction);
+
+        return samples;
+    };
+
+    double discount = std::exp(-r * T);
+
+    if (sobol)
+        return sobol_estimate(M, threads, target_error, discount, [&](std::size_t chunk, std::size_t begin, std::size_t end)
+                              { return simulate_chunk(chunk, begin, end).x(); });
+
+    auto estimate = [&](const RunningCovariance &samples)
+    { return control ? samples.control_variate_estimate(control_mean, discount) : samples.x().estimate(discount); };
+    auto error = [&](const RunningCovariance &samples)
+    { return estimate(samples).standard_error; };
+
+    return estimate(merge_chunks_to_target<RunningCovariance>(M, mc_chunk_paths, threads, target_error, simulate_chunk, error));
+}
+
+std::vector<double> EQ1::find_scenario_key() const
+{
+    unsigned reduction = sampling == SamplingMethod::sobol ? vr_none : variance_reduction;
+
+    return scenario_key({T, S0, sigma, r, static_cast<double>(N), static_cast<double>(M),
+                         static_cast<double>(sampling), static_cast<double>(reduction)},
+                        seed);
+}
+
+void EQ1::write_scenarios(const std::string &path, bool full_paths) const
+{
+    double dt = T / N;
+    double growth = 1 + r * dt, vol = sigma * std::sqrt(dt);
+
+    std::unique_ptr<SobolPaths> sobol;
+    if (sampling == SamplingMethod::sobol)
+        sobol = std::make_unique<SobolPaths>(N, 1, seed);
+    unsigned reduction = sobol ? vr_none : variance_reduction;
+    bool control = reduction & vr_control_variate;
+
+    // Every statistic, so that any payoff can be priced off the file
+    unsigned statistics = path_maximum | path_minimum | path_average;
+
+    ScenarioWriter writer(path, ScenarioEngine::EQ1, find_scenario_key(), M, reduction);
+    std::size_t state_id = writer.declare("state", sizeof(PathState) / sizeof(double));
+    std::size_t brownian_id = control ? writer.declare("brownian", 1) : 0;
+    std::size_t path_id = full_paths ? writer.declare("path", N) : 0;
+
+    struct chunk_paths
+    {
+        std::vector<PathState> states;
+        std::vector<double> W, S;
+    };
+
+    auto simulate_chunk = [&](std::size_t chunk, std::size_t begin, std::size_t end)
+    {
+        std::size_t n_paths = vr_chunk_paths(end - begin, reduction);
+        WAB_TIME_SCOPE("eq1.simulate");
+        WAB_COUNT("eq1.paths", n_paths);
+        WAB_COUNT("eq1.steps", static_cast<std::uint64_t>(N) * n_paths);
+
+        chunk_paths result;
+        result.states.resize(n_paths);
+        result.W.resize(control ? n_paths : 0);
+        result.S.resize(full_paths ? N * n_paths : 0);
+
+        ChunkNormals normals(sobol.get(), seed, chunk, n_paths, N, 1, reduction);
+        simulate_gbm_paths(normals, n_paths, N, S0, growth, vol, statistics, result.states.data(),
+                           control ? result.W.data() : nullptr, full_paths ? result.S.data() : nullptr);
+
+        return result;
+    };
+
+    stream_chunks<chunk_paths>(M, mc_chunk_paths, threads, simulate_chunk, [&](std::size_t chunk, const chunk_paths &result)
+                               {
+                                   writer.append(state_id, chunk, reinterpret_cast<const double *>(result.states.data()));
+                                   if (control)
+                                       writer.append(brownian_id, chunk, result.W.data());
+                                   if (full_paths)
+                                       writer.append(path_id, chunk, result.S.data()); });
+
+    writer.close();
+}
+
+bool EQ1::find_closed_form(MCEstimate &premium) const
+{
+    if (!payoff)
+        premium.value = black_scholes_call(S0, K, r, sigma, T);
+
+    else if (auto call = dynamic_cast<const CallPayoff *>(payoff.get()))
+        premium.value = black_scholes_call(S0, call->strike(), r, sigma, T);
+
+    else if (auto put = dynamic_cast<const PutPayoff *>(payoff.get()))
+        premium.value = black_scholes_put(S0, put->strike(), r, sigma, T);
+
+    else
+        return false;
+
+    return true;
+}
+
+Greeks EQ1::find_greeks() const
+{
+    std::shared_ptr<const Payoff> option = payoff ? payoff : std::make_shared<CallPayoff>(K);
+
+    return gbm_greeks(*option, S0, sigma, r, T, N, M, seed, threads, target_error);
+}
+
+std::vector<double> EQ1::get_premiums(const std::vector<double> &maturities, const std::vector<double> &strikes) const
+{
+    if (maturities.size() != strikes.size())
+        throw std::invalid_argument("EQ1::get_premiums: maturities and strikes differ in length");
+
+    std::vector<double> premiums(maturities.size());
+    find_premiums(maturities.data(), strikes.data(), premiums.data(), premiums.size());
+
+    return premiums;
+}
+
+void EQ1::find_premiums(const double *maturities, const double *strikes, double *premiums, std::size_t n) const
+{
+    if (n == 0)
+        return;
+
+    for (std::size_t c = 0; c < n; ++c)
+        if (!(maturities[c] > 0))
+            throw std::invalid_argument("EQ1::get_premiums: maturities must be positive");
+
+    if (engine != PricingEngine::monte_carlo)
+    {
+        for (std::size_t c = 0; c < n; ++c)
+            premiums[c] = black_scholes_call(S0, strikes[c], r, sigma, maturities[c]);
+
+        return;
+    }
+
+    // Contracts sorted by maturity; date d settles contracts [first[d], first[d + 1])
+    std::vector<std::size_t> order(n);
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b)
+                     { return maturities[a] < maturities[b]; });
+
+    std::vector<double> dates, strike(n);
+    std::vector<std::size_t> first;
+    for (std::size_t c = 0; c < n; ++c)
+    {
+        strike[c] = strikes[order[c]];
+
+        if (dates.empty() || maturities[order[c]] != dates.back())
+        {
+            dates.push_back(maturities[order[c]]);
+            first.push_back(c);
+        }
+    }
+    first.push_back(n);
+
+    // Split N steps over [0, max T] in proportion to each interval, at least one each
+    std::size_t n_dates = dates.size();
+    std::vector<int> steps(n_dates);
+    std::vector<double> growth(n_dates), vol(n_dates);
+
+    double previous{};
+    for (std::size_t d = 0; d < n_dates; ++d)
+    {
+        double span = dates[d] - previous;
+        steps[d] = std::max(1, static_cast<int>(std::lround(N * span / dates.back())));
+
+        double dt = span / steps[d];
+        growth[d] = 1 + r * dt;
+        vol[d] = sigma * std::sqrt(dt);
+        previous = dates[d];
+    }
+
+    // Each chunk sweeps its terminal values once per contract while they are in L1
+    auto simulate_chunk = [&](std::size_t chunk, std::size_t begin, std::size_t end)
+    {
+        std::size_t n_paths = end - begin;
+        WAB_TIME_SCOPE("eq1_batch.simulate");
+        WAB_COUNT("eq1_batch.paths", n_paths);
+        WAB_COUNT("eq1_batch.steps", static_cast<std::uint64_t>(std::accumulate(steps.begin(), steps.end(), 0)) * n_paths);
+
+        std::vector<double> S(n_paths, S0);
+        std::vector<double> eps(n_paths);
+        std::vector<double> sum_payoff(n);
+
+        NormalGenerator normal(seed, chunk);
+
+        for (std::size_t d = 0; d < n_dates; ++d)
+        {
+            for (int i = 0; i < steps[d]; ++i)
+            {
+                normal.fill(eps.data(), n_paths);
+                gbm_step(S.data(), eps.data(), n_paths, growth[d], vol[d]);
+            }
+
+            for (std::size_t c = first[d]; c < first[d + 1]; ++c)
+            {
+                double sum{};
+                for (std::size_t p = 0; p < n_paths; ++p)
+                    sum += std::max(S[p] - strike[c], 0.);
+
+                sum_payoff[c] = sum;
+            }
         }
 
-        double diff = S[N] - K;
-        sum_payoff += std::max(diff, 0.);
+        return sum_payoff;
+    };
+
+    std::vector<double> sum_payoff(n);
+    for (const auto &chunk_payoff : parallel_chunks<std::vector<double>>(M, mc_chunk_paths, threads, simulate_chunk))
+        for (std::size_t c = 0; c < n; ++c)
+            sum_payoff[c] += chunk_payoff[c];
+
+    for (std::size_t c = 0; c < n; ++c)
+        premiums[order[c]] = std::exp(-r * maturities[order[c]]) * sum_payoff[c] / M;
+}
+
+MCEstimate EQ1::get_bermudan_premium(const std::vector<double> &exercise_times) const
+{
+    if (exercise_times.empty())
+        throw std::invalid_argument("EQ1::get_bermudan_premium: no exercise times");
+
+    std::vector<int> steps;
+    for (double t : exercise_times)
+    {
+        if (!(t > 0 && t <= T))
+            throw std::invalid_argument("EQ1::get_bermudan_premium: exercise times must be in (0, T]");
+
+        steps.push_back(std::max(1, static_cast<int>(std::lround(t / T * N))));
     }
 
-    return std::exp(-r * T) * sum_payoff / M;
+    std::sort(steps.begin(), steps.end());
+    steps.erase(std::unique(steps.begin(), steps.end()), steps.end());
+
+    return find_bermudan_premium(steps);
 }
 
-double EQ2::find_premium() const
+MCEstimate EQ1::find_bermudan_premium(const std::vector<int> &exercise_steps) const
 {
+    std::shared_ptr<const Payoff> option = payoff ? payoff : std::make_shared<CallPayoff>(K);
+    if (option->statistics() != path_terminal)
+        throw std::invalid_argument("EQ1::get_bermudan_premium: payoff must depend on S(t) only");
+
+    BermudanInputs inputs;
+    inputs.T = T;
+    inputs.S0 = S0;
+    inputs.sigma = sigma;
+    inputs.r = r;
+    inputs.N = N;
+    inputs.exercise_steps = exercise_steps;
+    inputs.pricing_paths = M;
+    inputs.regression_paths = regression_paths > 0 ? regression_paths : M;
+    inputs.seed = seed;
+    inputs.threads = threads;
+    inputs.target_error = target_error;
+    inputs.variance_reduction = variance_reduction;
+
+    // Calls and puts are inlined into the regression and exercise loops
+    if (auto call = dynamic_cast<const CallPayoff *>(option.get()))
+    {
+        double strike = call->strike();
+        return longstaff_schwartz<ExerciseBasis>([strike](double S)
+                                                 { return std::max(S - strike, 0.); }, inputs);
+    }
+
+    if (auto put = dynamic_cast<const PutPayoff *>(option.get()))
+    {
+        double strike = put->strike();
+        return longstaff_schwartz<ExerciseBasis>([strike](double S)
+                                                 { return std::max(strike - S, 0.); }, inputs);
+    }
+
+    return longstaff_schwartz<ExerciseBasis>([&](double S)
+                                             { return (*option)(PathState{S, S, S, S}); }, inputs);
+}
+
+MCEstimate EQ2::find_premium() const
+{
+    // max(S1, S2) = S2 + max(S1 - S2, 0), and S2 discounts to S2(0)
+    if (engine != PricingEngine::monte_carlo)
+    {
+        MCEstimate exact;
+        exact.value = S20 + margrabe_exchange(S10, S20, sigma1, sigma2, rho, T);
+
+        return exact;
+    }
 
-    double sum_payoff{}, premium{};
     double dt = T / N;
-    std::vector<double> S1(N + 1);
-    std::vector<double> S2(N + 1);
+    double growth = 1 + r * dt, vol1 = sigma1 * std::sqrt(dt), vol2 = sigma2 * std::sqrt(dt);
+    CorrelatedNormals correlated(two_asset_correlation(rho));
+
+    std::unique_ptr<SobolPaths> sobol;
+    if (sampling == SamplingMethod::sobol)
+        sobol = std::make_unique<SobolPaths>(N, 2, seed);
+    unsigned reduction = sobol ? vr_none : variance_reduction;
 
-    SampleBoxMuller normal;
+    // Control: the geometric average sqrt(S1 S2) under exact GBM driven by the
+    // same W1(T), W2(T)
+    bool control = reduction & vr_control_variate;
+    double sigma_a = sigma1, sigma_b = sigma2;
+    double control_drift = 0.5 * (2 * r - 0.5 * (sigma_a * sigma_a + sigma_b * sigma_b)) * T;
+    double control_variance = 0.25 * (sigma_a * sigma_a + sigma_b * sigma_b + 2 * rho * sigma_a * sigma_b) * T;
+    double control_mean = std::sqrt(S10 * S20) * std::exp(control_drift + 0.5 * control_variance);
+    double sqrt_dt = std::sqrt(dt);
 
-    for (int j = 0; j < M; ++j)
+    if (scenarios)
+        scenarios->check(ScenarioEngine::EQ2, find_scenario_key(), "EQ2::get_premium");
+
+    auto simulate_chunk = [&](std::size_t chunk, std::size_t begin, std::size_t end)
     {
-        S1[0] = S10;
-        S2[0] = S20;
+        std::size_t n_paths = vr_chunk_paths(end - begin, reduction);
+        std::vector<double> simulated_S, simulated_W;
+        const double *S = nullptr, *W = nullptr;
+
+        WAB_COUNT("eq2.paths", n_paths);
+
+        if (scenarios)
+        {
+            WAB_COUNT("eq2.scenario_paths", n_paths);
+
+            S = scenarios->chunk("terminal", chunk);
+            if (control)
+                W = scenarios->chunk("brownian", chunk);
+        }
+
+        else
+        {
+            WAB_TIME_SCOPE("eq2.simulate");
+            WAB_COUNT("eq2.steps", static_cast<std::uint64_t>(N) * n_paths);
+
+            simulated_S.resize(2 * n_paths);
+            simulated_W.resize(control ? 2 * n_paths : 0);
+
+            ChunkNormals normals(sobol.get(), seed, chunk, n_paths, N, 2, reduction);
+            simulate_two_assets(normals, correlated, n_paths, N, S10, S20, growth, vol1, vol2, simulated_S.data(),
+                                control ? simulated_W.data() : nullptr, nullptr);
+
+            S = simulated_S.data();
+            W = simulated_W.data();
+        }
+
+        const double *S1 = S, *S2 = S + n_paths;
+        std::vector<double> payoffs(n_paths), controls(n_paths);
+        for (std::size_t p = 0; p < n_paths; ++p)
+        {
+            payoffs[p] = std::max(S1[p], S2[p]);
+
+            if (control)
+                controls[p] = std::sqrt(S10 * S20) * std::exp(control_drift + 0.5 * sqrt_dt * (sigma_a * W[p] + sigma_b * W[n_paths + p]));
+        }
+
+        RunningCovariance samples;
+        add_path_samples(samples, payoffs.data(), controls.data(), n_paths, reduction);
+
+        return samples;
+    };
+
+    double discount = std::exp(-r * T);
+
+    if (sobol)
+        return sobol_estimate(M, threads, target_error, discount, [&](std::size_t chunk, std::size_t begin, std::size_t end)
+                              { return simulate_chunk(chunk, begin, end).x(); });
+
+    auto estimate = [&](const RunningCovariance &samples)
+    { return control ? samples.control_variate_estimate(control_mean, discount) : samples.x().estimate(discount); };
+    auto error = [&](const RunningCovariance &samples)
+    { return estimate(samples).standard_error; };
+
+    return estimate(merge_chunks_to_target<RunningCovariance>(M, mc_chunk_paths, threads, target_error, simulate_chunk, error));
+}
+
+std::vector<double> EQ2::find_scenario_key() const
+{
+    unsigned reduction = sampling == SamplingMethod::sobol ? vr_none : variance_reduction;
+
+    return scenario_key({T, r, S10, S20, sigma1, sigma2, rho, static_cast<double>(N), static_cast<double>(M),
+                         static_cast<double>(sampling), static_cast<double>(reduction)},
+                        seed);
+}
+
+void EQ2::write_scenarios(const std::string &path, bool full_paths) const
+{
+    double dt = T / N;
+    double growth = 1 + r * dt, vol1 = sigma1 * std::sqrt(dt), vol2 = sigma2 * std::sqrt(dt);
+    CorrelatedNormals correlated(two_asset_correlation(rho));
+
+    std::unique_ptr<SobolPaths> sobol;
+    if (sampling == SamplingMethod::sobol)
+        sobol = std::make_unique<SobolPaths>(N, 2, seed);
+    unsigned reduction = sobol ? vr_none : variance_reduction;
+    bool control = reduction & vr_control_variate;
+
+    ScenarioWriter writer(path, ScenarioEngine::EQ2, find_scenario_key(), M, reduction);
+    std::size_t terminal_id = writer.declare("terminal", 2);
+    std::size_t brownian_id = control ? writer.declare("brownian", 2) : 0;
+    std::size_t path_id = full_paths ? writer.declare("path", 2 * N) : 0;
+
+    struct chunk_paths
+    {
+        std::vector<double> S, W, path;
+    };
+
+    auto simulate_chunk = [&](std::size_t chunk, std::size_t begin, std::size_t end)
+    {
+        std::size_t n_paths = vr_chunk_paths(end - begin, reduction);
+        WAB_TIME_SCOPE("eq2.simulate");
+        WAB_COUNT("eq2.paths", n_paths);
+        WAB_COUNT("eq2.steps", static_cast<std::uint64_t>(N) * n_paths);
+
+        chunk_paths result;
+        result.S.resize(2 * n_paths);
+        result.W.resize(control ? 2 * n_paths : 0);
+        result.path.resize(full_paths ? 2 * N * n_paths : 0);
+
+        ChunkNormals normals(sobol.get(), seed, chunk, n_paths, N, 2, reduction);
+        simulate_two_assets(normals, correlated, n_paths, N, S10, S20, growth, vol1, vol2, result.S.data(),
+                            control ? result.W.data() : nullptr, full_paths ? result.path.data() : nullptr);
+
+        return result;
+    };
+
+    stream_chunks<chunk_paths>(M, mc_chunk_paths, threads, simulate_chunk, [&](std::size_t chunk, const chunk_paths &result)
+                               {
+                                   writer.append(terminal_id, chunk, result.S.data());
+                                   if (control)
+                                       writer.append(brownian_id, chunk, result.W.data());
+                                   if (full_paths)
+                                       writer.append(path_id, chunk, result.path.data()); });
+
+    writer.close();
+}
+
+EQ2_greeks EQ2::find_greeks() const
+{
+    // The likelihood-ratio gammas divide by 1 - rho^2
+    if (!(std::fabs(rho) < 1))
+        throw std::invalid_argument("EQ2::get_greeks: likelihood-ratio gammas need |rho| < 1");
+
+    struct chunk_stats
+    {
+        RunningStats premium, delta1, delta2, gamma1, gamma2, vega1, vega2, rho;
+
+        void merge(const chunk_stats &other)
+        {
+            premium.merge(other.premium);
+            delta1.merge(other.delta1);
+            delta2.merge(other.delta2);
+            gamma1.merge(other.gamma1);
+            gamma2.merge(other.gamma2);
+            vega1.merge(other.vega1);
+            vega2.merge(other.vega2);
+            rho.merge(other.rho);
+        }
+    };
+
+    double dt = T / N;
+    double growth = 1 + r * dt, vol1 = sigma1 * std::sqrt(dt), vol2 = sigma2 * std::sqrt(dt);
+    CorrelatedNormals correlated(two_asset_correlation(rho));
+    double discount = std::exp(-r * T);
+
+    // Likelihood-ratio score of log S_k(0) is row k of C^{-1} W(T) / sigma_k,
+    // with C the correlation matrix times T
+    double score_scale = 1 / ((1 - rho * rho) * T);
+
+    auto simulate_chunk = [&](std::size_t chunk, std::size_t begin, std::size_t end)
+    {
+        std::size_t n_paths = end - begin;
+        WAB_TIME_SCOPE("eq2_greeks.simulate");
+        WAB_COUNT("eq2_greeks.paths", n_paths);
+        WAB_COUNT("eq2_greeks.steps", static_cast<std::uint64_t>(N) * n_paths);
+
+        std::vector<double> S1(n_paths, S10);
+        std::vector<double> S2(n_paths, S20);
+        std::vector<double> z(2 * n_paths), eps(2 * n_paths);
+        double *eps1 = eps.data(), *eps2 = eps.data() + n_paths;
+        GbmPathDerivatives derivatives1(n_paths, dt), derivatives2(n_paths, dt);
+
+        NormalGenerator normal(seed, chunk);
+
         for (int i = 0; i < N; ++i)
         {
-            double epsilon1 = normal(), epsilon2 = normal();
-            S1[i + 1] = S1[i] * (1 + r * dt + sigma1 * std::sqrt(dt) * epsilon1);
-            S2[i + 1] = S2[i] * (1 + r * dt + sigma1 * std::sqrt(dt) * (epsilon1 * rho + std::sqrt(1 - rho * rho) * epsilon2));
+            normal.fill(z.data(), 2 * n_paths);
+            correlated.apply(z.data(), eps.data(), n_paths);
+
+            gbm_step(S1.data(), eps1, n_paths, growth, vol1);
+            gbm_step(S2.data(), eps2, n_paths, growth, vol2);
+            derivatives1.update(eps1, growth, vol1);
+            derivatives2.update(eps2, growth, vol2);
         }
 
-        sum_payoff += std::max(S1[N], S2[N]);
-    }
+        chunk_stats stats;
+        for (std::size_t p = 0; p < n_paths; ++p)
+        {
+            // The payoff follows whichever asset ends higher
+            bool first = S1[p] >= S2[p];
+            double value = first ? S1[p] : S2[p];
+            double W1 = derivatives1.brownian(p), W2 = derivatives2.brownian(p);
+
+            double slope1 = first ? S1[p] : 0.;
+            double slope2 = first ? 0. : S2[p];
+            double dsigma1 = slope1 * derivatives1.dlog_dsigma(p);
+            double dsigma2 = slope2 * derivatives2.dlog_dsigma(p);
+
+            stats.premium.add(value);
+            stats.delta1.add(slope1 / S10);
+            stats.delta2.add(slope2 / S20);
+            stats.gamma1.add(slope1 / (S10 * S10) * ((W1 - rho * W2) * score_scale / sigma1 - 1));
+            stats.gamma2.add(slope2 / (S20 * S20) * ((W2 - rho * W1) * score_scale / sigma2 - 1));
+            stats.vega1.add(dsigma1);
+            stats.vega2.add(dsigma2);
+            stats.rho.add(slope1 * derivatives1.dlog_dr(p) + slope2 * derivatives2.dlog_dr(p) - T * value);
+        }
+
+        return stats;
+    };
+
+    auto error = [&](const chunk_stats &stats)
+    { return discount * stats.premium.standard_error(); };
+
+    chunk_stats total = merge_chunks_to_target<chunk_stats>(M, mc_chunk_paths, threads, target_error, simulate_chunk, error);
+
+    EQ2_greeks greeks;
+    greeks.premium = total.premium.estimate(discount);
+    greeks.delta1 = total.delta1.estimate(discount);
+    greeks.delta2 = total.delta2.estimate(discount);
+    greeks.gamma1 = total.gamma1.estimate(discount);
+    greeks.gamma2 = total.gamma2.estimate(discount);
+    greeks.vega1 = total.vega1.estimate(discount);
+    greeks.vega2 = total.vega2.estimate(discount);
+    greeks.rho = total.rho.estimate(discount);
 
-    return std::exp(-r * T) * sum_payoff / M;
-}
\ No newline at end of file
+    return greeks;
+}
+
+EQN::EQN(double T, double r, std::vector<double> S0, std::vector<double> sigma, const matrix<double> &correlation, int N, int M,
+         CorrelationFactorization method, std::size_t factors)
+    : T(T), r(r), S0(std::move(S0)), sigma(std::move(sigma)), N(N), M(M), correlated(correlation, method, factors)
+{
+    if (this->sigma.size() != this->S0.size() || correlated.dimensions() != this->S0.size())
+        throw std::invalid_argument("EQN: S0, sigma and the correlation matrix must have one entry per asset");
+}
+
+MCEstimate EQN::find_premium() const
+{
+    std::size_t n_assets = S0.size(), n_factors = correlated.factors();
+
+    if (n_assets == 0)
+        throw std::invalid_argument("EQN::get_premium: no assets");
+
+    double dt = T / N;
+    double growth = 1 + r * dt;
+    std::vector<double> vol(n_assets);
+    for (std::size_t a = 0; a < n_assets; ++a)
+        vol[a] = sigma[a] * std::sqrt(dt);
+
+    std::shared_ptr<const BasketPayoff> option = payoff ? payoff : std::make_shared<MaxOfAssetsPayoff>();
+
+    std::unique_ptr<SobolPaths> sobol;
+    if (sampling == SamplingMethod::sobol)
+        sobol = std::make_unique<SobolPaths>(N, n_factors, seed);
+    unsigned reduction = sobol ? vr_none : variance_reduction & ~vr_control_variate;
+
+    // All buffers are per chunk; nothing is allocated per step
+    auto simulate_chunk = [&](std::size_t chunk, std::size_t begin, std::size_t end)
+    {
+        std::size_t n_paths = vr_chunk_paths(end - begin, reduction);
+        WAB_TIME_SCOPE("eqn.simulate");
+        WAB_COUNT("eqn.paths", n_paths);
+        WAB_COUNT("eqn.steps", static_cast<std::uint64_t>(N) * n_paths);
+
+        std::vector<double> S(n_assets * n_paths);
+        std::vector<double> z(n_factors * n_paths), eps(n_assets * n_paths);
+        std::vector<double> payoffs(n_paths);
+
+        for (std::size_t a = 0; a < n_assets; ++a)
+            std::fill_n(&S[a * n_paths], n_paths, S0[a]);
+
+        ChunkNormals normals(sobol.get(), seed, chunk, n_paths, N, n_factors, reduction);
+
+        for (int i = 0; i < N; ++i)
+        {
+            for (std::size_t f = 0; f < n_factors; ++f)
+                normals.fill(&z[f * n_paths]);
+
+            correlated.apply(z.data(), eps.data(), n_paths);
+
+            for (std::size_t a = 0; a < n_assets; ++a)
+                gbm_step(&S[a * n_paths], &eps[a * n_paths], n_paths, growth, vol[a]);
+        }
+
+        (*option)(S.data(), n_assets, n_paths, payoffs.data());
+
+        RunningStats samples;
+        add_path_samples(samples, payoffs.data(), n_paths, reduction);
+
+        return samples;
+    };
+
+    double discount = std::exp(-r * T);
+
+    if (sobol)
+        return sobol_estimate(M, threads, target_error, discount, simulate_chunk);
+
+    auto error = [&](const RunningStats &samples)
+    { return samples.standard_error() * discount; };
+
+    return merge_chunks_to_target<RunningStats>(M, mc_chunk_paths, threads, target_error, simulate_chunk, error).estimate(discount);
+}
@@ -1,7 +1,117 @@
 #include "fx.hpp"
+#include "instrumentation.hpp"
 #include <cmath>
 #include <algorithm>
 #include <iomanip>
+#include <utility>
+
+namespace
+{
+    // Advances one time slice of the grid (a contiguous column of u) by dtau.
+    // Boundary values of the new slice must be set before calling step.
+    class heat_stepper
+    {
+    public:
+        heat_stepper(FX_scheme scheme, double alpha, int N) : scheme(scheme), alpha(alpha), N(N)
+        {
+            if (scheme == FX_scheme::explicit_fd || N < 3)
+                return;
+
+            // Left-hand side on the N - 2 interior nodes
+            double off = scheme == FX_scheme::implicit_fd ? -alpha : -0.5 * alpha;
+            double diag = scheme == FX_scheme::implicit_fd ? 1 + 2 * alpha : 1 + alpha;
+
+            std::vector<double> sub(N - 2, off), main(N - 2, diag), super(N - 2, off);
+            solver = tridiagonal_solver(sub, main, super);
+            rhs.resize(N - 2);
+        }
+
+        void step(const double *u_old, double *u_new)
+        {
+            if (scheme == FX_scheme::explicit_fd)
+            {
+                for (int i = 1; i < N - 1; i++)
+                    u_new[i] = alpha * u_old[i + 1] + (1 - 2 * alpha) * u_old[i] + alpha * u_old[i - 1];
+
+                return;
+            }
+
+            if (N < 3)
+                return;
+
+            double w = scheme == FX_scheme::implicit_fd ? alpha : 0.5 * alpha;
+
+            for (int i = 1; i < N - 1; i++)
+            {
+                if (scheme == FX_scheme::implicit_fd)
+                    rhs[i - 1] = u_old[i];
+                else
+                    rhs[i - 1] = w * u_old[i - 1] + (1 - alpha) * u_old[i] + w * u_old[i + 1];
+            }
+
+            rhs[0] += w * u_new[0];
+            rhs[N - 3] += w * u_new[N - 1];
+
+            solver.solve(rhs.data());
+
+            std::copy(rhs.begin(), rhs.end(), u_new + 1);
+        }
+
+    private:
+        FX_scheme scheme;
+        double alpha;
+        int N;
+        tridiagonal_solver solver;
+        std::vector<double> rhs;
+    };
+
+    // S-dependent part of the x-to-S transform, K^((1+k)/2) S^((1-k)/2), per node.
+    vec transform_node_factors(const vec &S, double K, double k)
+    {
+        vec factors(S.size());
+        for (std::size_t i = 0; i < S.size(); i++)
+            factors[i] = std::pow(K, (0.5 * (1 + k))) * std::pow(S[i], (0.5 * (1 - k)));
+
+        return factors;
+    }
+
+    // Time-dependent part, exp(-(k + 1)^2 tau / 4), of a slice stepped
+    // time_to_maturity from the payoff (slice j is j * dt from it).
+    double transform_time_factor(double k, double sigma_square, double time_to_maturity)
+    {
+        return std::exp(-(k + 1) * (k + 1) * sigma_square * time_to_maturity / 8.);
+    }
+
+    // Value, delta and gamma at s from the quadratic through the three nodes
+    // nearest to s (the grid in S is not uniform).
+    void quadratic_greeks(const vec &S, const vec &v, double s, premium_data &result)
+    {
+        std::size_t n = S.size();
+        if (n < 3)
+        {
+            result.premium = n ? v[n / 2] : 0.;
+            return;
+        }
+
+        // S[above - 1] <= s < S[above]; centre on whichever node is nearer
+        std::size_t above = std::upper_bound(S.begin(), S.end(), s) - S.begin();
+        std::size_t i = above;
+        if (above == 0 || (above < n && s - S[above - 1] <= S[above] - s))
+            i = above == 0 ? 0 : above - 1;
+        i = std::min(std::max<std::size_t>(i, 1), n - 2);
+
+        double x0 = S[i - 1], x1 = S[i], x2 = S[i + 1];
+        double y0 = v[i - 1], y1 = v[i], y2 = v[i + 1];
+
+        double d01 = (y1 - y0) / (x1 - x0);
+        double d12 = (y2 - y1) / (x2 - x1);
+        double d012 = (d12 - d01) / (x2 - x0);
+
+        result.premium = y1 + d01 * (s - x1) + d012 * (s - x1) * (s - x0);
+        result.delta = d01 + d012 * ((s - x0) + (s - x1));
+        result.gamma = 2 * d012;
+    }
+}
 
 result_data FX1::evaluate_data_and_premium() const
 {
@@ -9,9 +119,9 @@ result_data FX1::evaluate_data_and_premium() const
 
     vec t(M), tau(M), S(N), x(N);
 
-    matrix<double> u, v;
-    matrix_resize(u, N, M);
-    matrix_resize(v, N, M);
+    // Column j is the time slice tau_j, so column-major keeps each sweep contiguous
+    matrix<double> u(N, M, matrix_layout::column_major);
+    matrix<double> v(N, M, matrix_layout::column_major);
 
     double sigma_square = sigma * sigma;
     double dx_square = dx * dx;
@@ -22,70 +132,258 @@ result_data FX1::evaluate_data_and_premium() const
 
     double xmin = -1, xmax = 1;
 
-    // MESH:
-    for (int i = 0; i < N; i++)
+    WAB_COUNT("fx1.grid_nodes", static_cast<std::uint64_t>(N) * M);
+
     {
-        x[i] = xmin + i * dx;
-        S[i] = K * std::exp(x[i]);
+        WAB_TIME_SCOPE("fx1.mesh");
+
+        // MESH:
+        for (int i = 0; i < N; i++)
+        {
+            x[i] = xmin + i * dx;
+            S[i] = K * std::exp(x[i]);
+        }
+
+        for (int j = 0; j < M; j++)
+        {
+            t[j] = j * dt;
+            tau[j] = (T - t[j]) / (0.5 * sigma_square);
+        }
+
+        // INITIAL CONDITION
+        for (int i = 0; i < N; i++)
+        {
+            u[i][0] = std::max(std::exp(0.5 * (k + 1) * x[i]) - std::exp(0.5 * (k - 1) * x[i]), 0.);
+        }
+
+        // BOUNDARY CONDITION
+
+        for (int j = 1; j < M; j++)
+        {
+            u[0][j] = 0.;
+
+            if (barrier)
+                u[N - 1][j] = 0.;
+            else
+                u[N - 1][j] = u[N - 1][0];
+        }
     }
 
-    for (int j = 0; j < M; j++)
+    // TIME STEPPING (explicit forward difference, implicit or Crank-Nicolson)
+
     {
-        t[j] = j * dt;
-        tau[j] = (T - t[j]) / (0.5 * sigma_square);
+        WAB_TIME_SCOPE("fx1.sweep");
+
+        heat_stepper stepper(scheme, alpha, N);
+
+        for (int j = 0; j < M - 1; j++)
+        {
+            stepper.step(&u(0, j), &u(0, j + 1));
+        }
     }
 
-    // INITIAL CONDITION
+    // TRANSFORM SOLUTION FROM X TO S COORDINATES
+
+    {
+        WAB_TIME_SCOPE("fx1.transform");
+
+        vec node_factor = transform_node_factors(S, K, k);
+
+        for (int j = 0; j < M; j++)
+        {
+            double time_factor = transform_time_factor(k, sigma_square, j * dt);
+
+            for (int i = 1; i < N; i++)
+            {
+                v[i][j] = node_factor[i] * time_factor * u[i][j];
+            }
+        }
+    }
+
+    result_data result(alpha, dtau, k, std::move(x), std::move(S), std::move(t), std::move(tau), std::move(u), std::move(v));
+
+    return result;
+}
+
+void FX1::solve_heat_slice(double alpha, double k, vec &u, const std::function<void(const vec &)> &on_slice) const
+{
+    WAB_TIME_SCOPE("fx1.premium_sweep");
+    WAB_COUNT("fx1.grid_nodes", static_cast<std::uint64_t>(N) * M);
+
+    double xmin = -1;
+
+    // Only the current and the next time slice are kept
+    vec u_old(N), u_new(N);
+
     for (int i = 0; i < N; i++)
     {
-        u[i][0] = std::max(std::exp(0.5 * (k + 1) * x[i]) - std::exp(0.5 * (k - 1) * x[i]), 0.);
+        double x = xmin + i * dx;
+        u_old[i] = std::max(std::exp(0.5 * (k + 1) * x) - std::exp(0.5 * (k - 1) * x), 0.);
     }
 
-    // BOUNDARY CONDITION
+    double u_upper = barrier ? 0. : u_old[N - 1];
 
-    for (int j = 1; j < M; j++)
+    heat_stepper stepper(scheme, alpha, N);
+
+    if (on_slice)
+        on_slice(u_old);
+
+    for (int j = 0; j < M - 1; j++)
     {
-        u[0][j] = 0.;
+        u_new[0] = 0.;
+        u_new[N - 1] = u_upper;
+
+        stepper.step(u_old.data(), u_new.data());
+        std::swap(u_old, u_new);
 
-        if (barrier)
-            u[N - 1][j] = 0.;
-        else
-            u[N - 1][j] = u[N - 1][0];
+        if (on_slice)
+            on_slice(u_old);
     }
 
-    // COMPUTE FORWARD DIFFERENCE
+    u = std::move(u_old);
+}
 
-    for (int j = 0; j < M - 1; j++)
+premium_data FX1::evaluate_premium() const
+{
+    premium_data result;
+
+    double sigma_square = sigma * sigma;
+    double dtau = dt * 0.5 * sigma_square;
+    double k = r / (0.5 * sigma_square);
+
+    result.alpha = dtau / (dx * dx);
+
+    result.S.resize(N);
+    result.v.resize(N);
+
+    double xmin = -1;
+
+    for (int i = 0; i < N; i++)
     {
-        for (int i = 1; i < N - 1; i++)
-        {
-            u[i][j + 1] = alpha * u[i + 1][j] + (1 - 2 * alpha) * u[i][j] + alpha * u[i - 1][j];
-        }
+        result.S[i] = K * std::exp(xmin + i * dx);
     }
 
-    // TRANSFORM SOLUTION FROM X TO S COORDINATES
+    // The heat equation in (x, tau) does not involve K, T or S0
+    vec u;
+    const vec *slice = &u;
+
+    std::unique_lock<std::mutex> lock;
+    if (caching)
+    {
+        lock = slice_cache.lock();
+        slice = &slice_cache.fetch(slice_key(sigma, r, dt, dx, N, M, barrier, scheme), [&](vec &fresh)
+                                   { solve_heat_slice(result.alpha, k, fresh); });
+    }
+    else
+        solve_heat_slice(result.alpha, k, u);
+
+    // Transform the final slice only
+    WAB_TIME_SCOPE("fx1.premium_transform");
+
+    vec node_factor = transform_node_factors(result.S, K, k);
+    double time_factor = transform_time_factor(k, sigma_square, (M - 1) * dt);
+
+    for (int i = 1; i < N; i++)
+    {
+        result.v[i] = node_factor[i] * time_factor * (*slice)[i];
+    }
+
+    quadratic_greeks(result.S, result.v, S0, result);
+
+    return result;
+}
+
+premium_data FX1::write_data_and_premium(GridWriter &writer) const
+{
+    premium_data result;
+
+    double sigma_square = sigma * sigma;
+    double dtau = dt * 0.5 * sigma_square;
+    double k = r / (0.5 * sigma_square);
+
+    result.alpha = dtau / (dx * dx);
+
+    vec x(N), t(M), tau(M);
+    result.S.resize(N);
+    result.v.resize(N);
+
+    double xmin = -1;
+
+    for (int i = 0; i < N; i++)
+    {
+        x[i] = xmin + i * dx;
+        result.S[i] = K * std::exp(x[i]);
+    }
 
     for (int j = 0; j < M; j++)
     {
+        t[j] = j * dt;
+        tau[j] = (T - t[j]) / (0.5 * sigma_square);
+    }
+
+    writer.write("alpha", result.alpha);
+    writer.write("dtau", dtau);
+    writer.write("k", k);
+    writer.write("x", x);
+    writer.write("S", result.S);
+    writer.write("t", t);
+    writer.write("tau", tau);
+
+    std::size_t u_id = writer.declare("u", N), v_id = writer.declare("v", N);
+
+    // Each slice is transformed and written as soon as it is stepped to; the
+    // last one stays in result.v
+    vec node_factor = transform_node_factors(result.S, K, k);
+    int j = 0;
+
+    auto write_slice = [&](const vec &u)
+    {
+        double time_factor = transform_time_factor(k, sigma_square, j * dt);
+
         for (int i = 1; i < N; i++)
         {
-            v[i][j] = std::pow(K, (0.5 * (1 + k))) * std::pow(S[i], (0.5 * (1 - k))) * std::exp((k + 1) * (k + 1) * sigma_square * (T - t[i]) / 8.) * u[i][j];
+            result.v[i] = node_factor[i] * time_factor * u[i];
         }
-    }
 
-    result_data result(alpha, dtau, k, x, S, t, tau, u, v);
+        writer.append(u_id, u.data());
+        writer.append(v_id, result.v.data());
+        ++j;
+    };
+
+    vec u;
+    solve_heat_slice(result.alpha, k, u, write_slice);
+
+    quadratic_greeks(result.S, result.v, S0, result);
 
     return result;
 }
 
+void write_result_data(GridWriter &writer, const result_data &grid)
+{
+    writer.write("alpha", grid.alpha);
+    writer.write("dtau", grid.dtau);
+    writer.write("k", grid.k);
+    writer.write("x", grid.x);
+    writer.write("S", grid.S);
+    writer.write("t", grid.t);
+    writer.write("tau", grid.tau);
+    writer.write("u", grid.u);
+    writer.write("v", grid.v);
+}
+
+result_data read_result_data(const GridReader &reader)
+{
+    return result_data(reader.read_scalar("alpha"), reader.read_scalar("dtau"), reader.read_scalar("k"),
+                       reader.read_vector("x"), reader.read_vector("S"), reader.read_vector("t"), reader.read_vector("tau"),
+                       reader.read("u"), reader.read("v"));
+}
+
 std::ostream &operator<<(std::ostream &os, const result_data &rs)
 {
     int M{}, N{};
 
-    N = rs.u.size();
-
-    if (N)
-        M = rs.u[0].size();
+    N = rs.u.rows();
+    M = rs.u.cols();
 
     os << std::setw(10) << " dtau = " << rs.dtau << "\n";
     os << std::setw(10) << " alpha = " << rs.alpha << "\n";
@@ -0,0 +1,67 @@
+#include "gbm.hpp"
+#include "simd.hpp"
+#include "simd_kernels.hpp"
+#include <algorithm>
+#include <vector>
+
+void gbm_step(double *S, const double *eps, std::size_t n, double growth, double vol)
+{
+    switch (active_simd_level())
+    {
+#if defined(WAB_SIMD_X86)
+    case SimdLevel::avx512:
+        gbm_step_avx512(S, eps, n, growth, vol);
+        break;
+    case SimdLevel::avx2:
+        gbm_step_avx2(S, eps, n, growth, vol);
+        break;
+#endif
+    default:
+        gbm_step_lanes<ScalarLanes>(S, eps, n, growth, vol);
+    }
+}
+
+void simulate_gbm_paths(ChunkNormals &normals, std::size_t n, int steps, double S0, double growth, double vol,
+                        unsigned statistics, PathState *states, double *W, double *path)
+{
+    std::vector<double> S(n, S0), eps(n);
+    PathStatisticsBatch path_stats(statistics, n, S0);
+
+    if (W)
+        std::fill_n(W, n, 0.);
+
+    for (int i = 0; i < steps; ++i)
+    {
+        normals.fill(eps.data());
+        gbm_step(S.data(), eps.data(), n, growth, vol);
+
+        if (statistics != path_terminal)
+            path_stats.update(S.data());
+
+        if (W)
+            for (std::size_t p = 0; p < n; ++p)
+                W[p] += eps[p];
+
+        if (path)
+            std::copy_n(S.data(), n, path + i * n);
+    }
+
+    for (std::size_t p = 0; p < n; ++p)
+        states[p] = path_stats.state(p, S[p]);
+}
+
+void simulate_gbm_spots(ChunkNormals &normals, std::size_t n, int steps, double S0, double growth, double vol,
+                        const int *kept, std::size_t n_kept, double *spot)
+{
+    std::vector<double> S(n, S0), eps(n);
+
+    std::size_t e = 0;
+    for (int i = 1; i <= steps && e < n_kept; ++i)
+    {
+        normals.fill(eps.data());
+        gbm_step(S.data(), eps.data(), n, growth, vol);
+
+        if (kept[e] == i)
+            std::copy_n(S.data(), n, spot + n * e++);
+    }
+}
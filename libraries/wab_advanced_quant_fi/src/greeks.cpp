@@ -0,0 +1,103 @@
+#include "greeks.hpp"
+#include "gbm.hpp"
+#include "instrumentation.hpp"
+#include "parallel.hpp"
+#include "random.hpp"
+#include <cmath>
+#include <stdexcept>
+
+GbmPathDerivatives::GbmPathDerivatives(std::size_t n_paths, double dt)
+    : n_paths(n_paths), dt(dt), sqrt_dt(std::sqrt(dt)), dsigma(n_paths), dr(n_paths), W(n_paths)
+{
+}
+
+void GbmPathDerivatives::update(const double *eps, double growth, double vol)
+{
+    for (std::size_t p = 0; p < n_paths; ++p)
+    {
+        double inverse_step = 1 / (growth + vol * eps[p]);
+        double dW = sqrt_dt * eps[p];
+
+        dsigma[p] += dW * inverse_step;
+        dr[p] += dt * inverse_step;
+        W[p] += dW;
+    }
+}
+
+Greeks gbm_greeks(const Payoff &payoff, double S0, double sigma, double r, double T, int N, int M,
+                  std::uint64_t seed, int threads, double target_error)
+{
+    if (payoff.statistics() != path_terminal)
+        throw std::invalid_argument("gbm_greeks: the payoff must depend on the terminal value only");
+
+    struct chunk_stats
+    {
+        RunningStats premium, delta, gamma, vega, rho;
+
+        void merge(const chunk_stats &other)
+        {
+            premium.merge(other.premium);
+            delta.merge(other.delta);
+            gamma.merge(other.gamma);
+            vega.merge(other.vega);
+            rho.merge(other.rho);
+        }
+    };
+
+    double dt = T / N;
+    double growth = 1 + r * dt, vol = sigma * std::sqrt(dt);
+    double discount = std::exp(-r * T);
+
+    auto simulate_chunk = [&](std::size_t chunk, std::size_t begin, std::size_t end)
+    {
+        std::size_t n_paths = end - begin;
+        WAB_TIME_SCOPE("greeks.simulate");
+        WAB_COUNT("greeks.paths", n_paths);
+        WAB_COUNT("greeks.steps", static_cast<std::uint64_t>(N) * n_paths);
+
+        std::vector<double> S(n_paths, S0);
+        std::vector<double> eps(n_paths);
+        GbmPathDerivatives derivatives(n_paths, dt);
+
+        NormalGenerator normal(seed, chunk);
+
+        for (int i = 0; i < N; ++i)
+        {
+            normal.fill(eps.data(), n_paths);
+            gbm_step(S.data(), eps.data(), n_paths, growth, vol);
+            derivatives.update(eps.data(), growth, vol);
+        }
+
+        chunk_stats stats;
+        PathState state;
+        for (std::size_t p = 0; p < n_paths; ++p)
+        {
+            state.terminal = state.maximum = state.minimum = state.average = S[p];
+
+            double value = payoff(state);
+            double slope = payoff.terminal_slope(S[p]) * S[p];
+
+            stats.premium.add(value);
+            stats.delta.add(slope / S0);
+            stats.gamma.add(slope / (S0 * S0) * (derivatives.brownian(p) / (sigma * T) - 1));
+            stats.vega.add(slope * derivatives.dlog_dsigma(p));
+            stats.rho.add(slope * derivatives.dlog_dr(p) - T * value);
+        }
+
+        return stats;
+    };
+
+    auto error = [&](const chunk_stats &stats)
+    { return discount * stats.premium.standard_error(); };
+
+    chunk_stats total = merge_chunks_to_target<chunk_stats>(M, mc_chunk_paths, threads, target_error, simulate_chunk, error);
+
+    Greeks greeks;
+    greeks.premium = total.premium.estimate(discount);
+    greeks.delta = total.delta.estimate(discount);
+    greeks.gamma = total.gamma.estimate(discount);
+    greeks.vega = total.vega.estimate(discount);
+    greeks.rho = total.rho.estimate(discount);
+
+    return greeks;
+}
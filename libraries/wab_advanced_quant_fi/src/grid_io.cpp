@@ -0,0 +1,609 @@
+#include "grid_io.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#if defined(WAB_HAVE_ZLIB)
+#include <zlib.h>
+#endif
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    constexpr char grid_magic[8] = {'W', 'A', 'B', 'G', 'R', 'I', 'D', '\0'};
+    constexpr std::uint32_t grid_version = 1;
+    constexpr std::uint32_t grid_byte_order = 0x01020304;
+
+    // Every record header takes one block and every payload is padded to
+    // whole blocks, so float64 payloads stay 64-byte aligned in the mapping.
+    constexpr std::size_t grid_block = 64;
+    constexpr std::size_t grid_name_size = 32;
+
+    enum : std::uint32_t
+    {
+        record_declaration = 1,
+        record_slice = 2,
+        record_padding = 3
+    };
+
+    struct file_header
+    {
+        char magic[8];
+        std::uint32_t version, byte_order;
+    };
+
+    struct declaration_header
+    {
+        std::uint32_t kind, id, dtype, codec;
+        std::uint64_t slice_size;
+        char name[grid_name_size];
+    };
+
+    struct slice_header
+    {
+        std::uint32_t kind, id;
+        std::uint64_t stored;
+    };
+
+    using padding_header = slice_header;
+
+    static_assert(sizeof(declaration_header) <= grid_block, "record headers fit in one block");
+
+    std::size_t padded(std::size_t bytes)
+    {
+        return (bytes + grid_block - 1) / grid_block * grid_block;
+    }
+
+    std::size_t value_bytes(GridDtype dtype)
+    {
+        switch (dtype)
+        {
+        case GridDtype::float64:
+            return sizeof(double);
+        case GridDtype::float32:
+            return sizeof(float);
+        }
+
+        throw std::invalid_argument("grid file: unknown dtype");
+    }
+
+#if defined(WAB_HAVE_ZLIB)
+    // Byte b of value i goes to shuffled[b * n + i]
+    void shuffle_bytes(const unsigned char *raw, std::size_t n, std::size_t width, unsigned char *shuffled)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+            for (std::size_t b = 0; b < width; ++b)
+                shuffled[b * n + i] = raw[i * width + b];
+    }
+
+    void unshuffle_bytes(const unsigned char *shuffled, std::size_t n, std::size_t width, unsigned char *raw)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+            for (std::size_t b = 0; b < width; ++b)
+                raw[i * width + b] = shuffled[b * n + i];
+    }
+#endif
+
+    template <class T>
+    T load(const unsigned char *p)
+    {
+        T value;
+        std::memcpy(&value, p, sizeof(T));
+        return value;
+    }
+}
+
+bool grid_compression_available()
+{
+#if defined(WAB_HAVE_ZLIB)
+    return true;
+#else
+    return false;
+#endif
+}
+
+GridWriter::GridWriter(const std::string &path, GridCodec codec) : codec(codec)
+{
+    if (codec == GridCodec::zlib && !grid_compression_available())
+        throw std::invalid_argument("GridWriter: the library was built without zlib");
+
+    out.open(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+        throw std::runtime_error("GridWriter: cannot open " + path);
+
+    file_header header{};
+    std::memcpy(header.magic, grid_magic, sizeof(grid_magic));
+    header.version = grid_version;
+    header.byte_order = grid_byte_order;
+
+    write_record(&header, sizeof(header), nullptr, 0);
+}
+
+GridWriter::~GridWriter()
+{
+    try
+    {
+        close();
+    }
+    catch (...)
+    {
+    }
+}
+
+std::size_t GridWriter::declare(const std::string &name, std::size_t slice_size, GridDtype dtype)
+{
+    if (name.empty() || name.size() >= grid_name_size)
+        throw std::invalid_argument("GridWriter::declare: names are 1 to 31 characters");
+
+    for (const auto &array : declared)
+        if (array.name == name)
+            throw std::invalid_argument("GridWriter::declare: array " + name + " already exists");
+
+    value_bytes(dtype);
+
+    declaration_header header{};
+    header.kind = record_declaration;
+    header.id = static_cast<std::uint32_t>(declared.size());
+    header.dtype = static_cast<std::uint32_t>(dtype);
+    header.codec = static_cast<std::uint32_t>(codec);
+    header.slice_size = slice_size;
+    std::memcpy(header.name, name.data(), name.size());
+
+    write_record(&header, sizeof(header), nullptr, 0);
+
+    GridArrayInfo info;
+    info.name = name;
+    info.dtype = dtype;
+    info.codec = codec;
+    info.rows = slice_size;
+    declared.push_back(info);
+
+    return header.id;
+}
+
+const GridArrayInfo &GridWriter::info(std::size_t id) const
+{
+    if (id >= declared.size())
+        throw std::invalid_argument("GridWriter: no array with id " + std::to_string(id));
+
+    return declared[id];
+}
+
+void GridWriter::append(std::size_t id, const double *values)
+{
+    if (id >= declared.size())
+        throw std::invalid_argument("GridWriter::append: no array with this id");
+
+    GridArrayInfo &array = declared[id];
+    std::size_t n = array.rows, width = value_bytes(array.dtype);
+
+    const unsigned char *raw = reinterpret_cast<const unsigned char *>(values);
+    if (array.dtype == GridDtype::float32)
+    {
+        buffer.resize(n * width);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            float value = static_cast<float>(values[i]);
+            std::memcpy(&buffer[i * width], &value, width);
+        }
+
+        raw = buffer.data();
+    }
+
+    const unsigned char *payload = raw;
+    std::size_t stored = n * width;
+
+#if defined(WAB_HAVE_ZLIB)
+    if (array.codec == GridCodec::zlib)
+    {
+        std::vector<unsigned char> shuffled(n * width);
+        shuffle_bytes(raw, n, width, shuffled.data());
+
+        uLongf compressed = compressBound(static_cast<uLong>(shuffled.size()));
+        packed.resize(compressed);
+
+        if (compress2(packed.data(), &compressed, shuffled.data(), static_cast<uLong>(shuffled.size()), Z_BEST_SPEED) != Z_OK)
+            throw std::runtime_error("GridWriter::append: zlib compression failed");
+
+        payload = packed.data();
+        stored = compressed;
+    }
+#endif
+
+    // The payload follows the slice header; pad so that it lands aligned
+    if ((position + grid_block) % alignment != 0)
+    {
+        std::size_t gap = (alignment - (position + 2 * grid_block) % alignment) % alignment;
+        std::vector<unsigned char> zeros(gap);
+
+        padding_header padding{};
+        padding.kind = record_padding;
+        padding.stored = gap;
+        write_record(&padding, sizeof(padding), zeros.data(), gap);
+    }
+
+    slice_header header{};
+    header.kind = record_slice;
+    header.id = static_cast<std::uint32_t>(id);
+    header.stored = stored;
+
+    write_record(&header, sizeof(header), payload, stored);
+    ++array.cols;
+}
+
+void GridWriter::write(const std::string &name, const double *values, std::size_t n, GridDtype dtype)
+{
+    append(declare(name, n, dtype), values);
+}
+
+void GridWriter::write(const std::string &name, const std::vector<double> &values, GridDtype dtype)
+{
+    write(name, values.data(), values.size(), dtype);
+}
+
+void GridWriter::write(const std::string &name, const matrix<double> &values, GridDtype dtype)
+{
+    std::size_t id = declare(name, values.rows(), dtype);
+
+    std::vector<double> column(values.rows());
+    for (std::size_t j = 0; j < values.cols(); ++j)
+    {
+        if (values.layout() == matrix_layout::column_major)
+        {
+            append(id, values.data() + j * values.rows());
+            continue;
+        }
+
+        for (std::size_t i = 0; i < values.rows(); ++i)
+            column[i] = values(i, j);
+
+        append(id, column.data());
+    }
+}
+
+void GridWriter::write(const std::string &name, double value)
+{
+    write(name, &value, 1);
+}
+
+void GridWriter::set_alignment(std::size_t bytes)
+{
+    if (bytes < grid_block || (bytes & (bytes - 1)) != 0)
+        throw std::invalid_argument("GridWriter::set_alignment: need a power of two of at least 64");
+
+    alignment = bytes;
+}
+
+void GridWriter::flush()
+{
+    out.flush();
+    if (!out)
+        throw std::runtime_error("GridWriter: write failed");
+}
+
+void GridWriter::close()
+{
+    if (!out.is_open())
+        return;
+
+    out.flush();
+    bool ok = static_cast<bool>(out);
+    out.close();
+
+    if (!ok)
+        throw std::runtime_error("GridWriter: write failed");
+}
+
+void GridWriter::write_record(const void *header, std::size_t header_bytes, const void *payload, std::size_t payload_bytes)
+{
+    if (!out.is_open())
+        throw std::logic_error("GridWriter: the file is closed");
+
+    static const char zeros[grid_block] = {};
+
+    out.write(static_cast<const char *>(header), header_bytes);
+    out.write(zeros, grid_block - header_bytes);
+
+    if (payload_bytes)
+    {
+        out.write(static_cast<const char *>(payload), payload_bytes);
+        out.write(zeros, padded(payload_bytes) - payload_bytes);
+    }
+
+    position += grid_block + padded(payload_bytes);
+
+    if (!out)
+        throw std::runtime_error("GridWriter: write failed");
+}
+
+GridReader::GridReader(const std::string &path)
+{
+#if defined(_WIN32)
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        throw std::runtime_error("GridReader: cannot open " + path);
+
+    fallback.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    data = fallback.data();
+    size = fallback.size();
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("GridReader: cannot open " + path);
+
+    struct stat status;
+    if (::fstat(fd, &status) != 0 || status.st_size == 0)
+    {
+        ::close(fd);
+        throw std::runtime_error("GridReader: " + path + " is empty or unreadable");
+    }
+
+    size = static_cast<std::size_t>(status.st_size);
+    // A shared read-only mapping: processes reading the same file use the
+    // same page cache pages
+    void *mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (mapping == MAP_FAILED)
+        throw std::runtime_error("GridReader: cannot map " + path);
+
+    data = static_cast<const unsigned char *>(mapping);
+#endif
+
+    try
+    {
+        if (size < grid_block)
+            throw std::runtime_error("GridReader: " + path + " is not a grid file");
+
+        file_header header = load<file_header>(data);
+        if (std::memcmp(header.magic, grid_magic, sizeof(grid_magic)) != 0 || header.version != grid_version)
+            throw std::runtime_error("GridReader: " + path + " is not a version 1 grid file");
+
+        if (header.byte_order != grid_byte_order)
+            throw std::runtime_error("GridReader: " + path + " was written with another byte order");
+
+        // One pass over the record headers; payloads are not touched
+        std::size_t pos = grid_block;
+        while (pos < size)
+        {
+            if (size - pos < grid_block)
+                throw std::runtime_error("GridReader: " + path + " is truncated");
+
+            std::uint32_t kind = load<std::uint32_t>(data + pos);
+
+            if (kind == record_declaration)
+            {
+                declaration_header declaration = load<declaration_header>(data + pos);
+                if (declaration.id != entries.size())
+                    throw std::runtime_error("GridReader: " + path + " has arrays out of order");
+
+                entry array;
+                array.info.name.assign(declaration.name, std::find(declaration.name, declaration.name + grid_name_size, '\0'));
+                array.info.dtype = static_cast<GridDtype>(declaration.dtype);
+                array.info.codec = static_cast<GridCodec>(declaration.codec);
+                array.info.rows = declaration.slice_size;
+                value_bytes(array.info.dtype);
+
+                entries.push_back(std::move(array));
+                pos += grid_block;
+            }
+
+            else if (kind == record_slice)
+            {
+                slice_header slice = load<slice_header>(data + pos);
+                if (slice.id >= entries.size())
+                    throw std::runtime_error("GridReader: " + path + " has a slice of an undeclared array");
+
+                entry &array = entries[slice.id];
+                std::size_t payload = pos + grid_block;
+
+                if (slice.stored > size - payload)
+                    throw std::runtime_error("GridReader: " + path + " is truncated");
+
+                if (array.info.codec == GridCodec::none && slice.stored != array.info.rows * value_bytes(array.info.dtype))
+                    throw std::runtime_error("GridReader: " + path + " has a slice of the wrong size");
+
+                array.offset.push_back(payload);
+                array.stored.push_back(slice.stored);
+                ++array.info.cols;
+
+                pos = payload + padded(slice.stored);
+            }
+
+            else if (kind == record_padding)
+            {
+                padding_header padding = load<padding_header>(data + pos);
+                if (padding.stored > size - pos - grid_block)
+                    throw std::runtime_error("GridReader: " + path + " is truncated");
+
+                pos += grid_block + padded(padding.stored);
+            }
+
+            else
+                throw std::runtime_error("GridReader: " + path + " has an unknown record");
+        }
+    }
+    catch (...)
+    {
+        release();
+        throw;
+    }
+}
+
+GridReader::~GridReader()
+{
+    release();
+}
+
+GridReader::GridReader(GridReader &&other) noexcept
+{
+    *this = std::move(other);
+}
+
+GridReader &GridReader::operator=(GridReader &&other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+
+        data = std::exchange(other.data, nullptr);
+        size = std::exchange(other.size, 0);
+        fallback = std::move(other.fallback);
+        entries = std::move(other.entries);
+    }
+
+    return *this;
+}
+
+void GridReader::release()
+{
+#if !defined(_WIN32)
+    if (data && fallback.empty())
+        ::munmap(const_cast<unsigned char *>(data), size);
+#endif
+
+    data = nullptr;
+    size = 0;
+    fallback.clear();
+}
+
+std::vector<GridArrayInfo> GridReader::arrays() const
+{
+    std::vector<GridArrayInfo> result;
+    for (const auto &array : entries)
+        result.push_back(array.info);
+
+    return result;
+}
+
+bool GridReader::contains(const std::string &name) const
+{
+    return std::any_of(entries.begin(), entries.end(), [&](const entry &array)
+                       { return array.info.name == name; });
+}
+
+const GridArrayInfo &GridReader::info(const std::string &name) const
+{
+    return find_entry(name).info;
+}
+
+const GridReader::entry &GridReader::find_entry(const std::string &name) const
+{
+    for (const auto &array : entries)
+        if (array.info.name == name)
+            return array;
+
+    throw std::invalid_argument("GridReader: no array named " + name);
+}
+
+matrix_view<const double> GridReader::view(const std::string &name) const
+{
+    const entry &array = find_entry(name);
+    const GridArrayInfo &info = array.info;
+
+    if (info.codec != GridCodec::none || info.dtype != GridDtype::float64)
+        throw std::logic_error("GridReader::view: " + name + " is compressed or not float64, use read");
+
+    if (info.cols == 0)
+        return matrix_view<const double>(nullptr, info.rows, 0, 1, static_cast<std::ptrdiff_t>(info.rows));
+
+    // Slices written in a regular pattern (one array at a time, or several in
+    // lockstep) are evenly spaced, which a strided view can describe
+    std::size_t stride = info.cols > 1 ? array.offset[1] - array.offset[0] : info.rows * sizeof(double);
+    for (std::size_t j = 1; j < info.cols; ++j)
+        if (array.offset[j] - array.offset[j - 1] != stride)
+            throw std::logic_error("GridReader::view: the slices of " + name + " are not evenly spaced, use read");
+
+    const double *first = reinterpret_cast<const double *>(data + array.offset[0]);
+    return matrix_view<const double>(first, info.rows, info.cols, 1, static_cast<std::ptrdiff_t>(stride / sizeof(double)));
+}
+
+const double *GridReader::slice(const std::string &name, std::size_t j) const
+{
+    const entry &array = find_entry(name);
+
+    if (array.info.codec != GridCodec::none || array.info.dtype != GridDtype::float64)
+        throw std::logic_error("GridReader::slice: " + name + " is compressed or not float64, use read");
+
+    if (j >= array.info.cols)
+        throw std::invalid_argument("GridReader::slice: " + name + " has no such slice");
+
+    return reinterpret_cast<const double *>(data + array.offset[j]);
+}
+
+matrix<double> GridReader::read(const std::string &name) const
+{
+    const entry &array = find_entry(name);
+
+    matrix<double> result(array.info.rows, array.info.cols, matrix_layout::column_major);
+    for (std::size_t j = 0; j < array.info.cols; ++j)
+        decode_slice(array, j, &result(0, j));
+
+    return result;
+}
+
+std::vector<double> GridReader::read_vector(const std::string &name) const
+{
+    const entry &array = find_entry(name);
+
+    std::vector<double> result(array.info.rows * array.info.cols);
+    for (std::size_t j = 0; j < array.info.cols; ++j)
+        decode_slice(array, j, &result[j * array.info.rows]);
+
+    return result;
+}
+
+double GridReader::read_scalar(const std::string &name) const
+{
+    const entry &array = find_entry(name);
+    if (array.info.rows * array.info.cols != 1)
+        throw std::invalid_argument("GridReader::read_scalar: " + name + " is not a single value");
+
+    double value{};
+    decode_slice(array, 0, &value);
+
+    return value;
+}
+
+void GridReader::decode_slice(const entry &array, std::size_t j, double *out) const
+{
+    std::size_t n = array.info.rows, width = value_bytes(array.info.dtype);
+    const unsigned char *raw = data + array.offset[j];
+
+    std::vector<unsigned char> decoded;
+    if (array.info.codec == GridCodec::zlib)
+    {
+#if defined(WAB_HAVE_ZLIB)
+        std::vector<unsigned char> shuffled(n * width);
+        uLongf length = static_cast<uLongf>(shuffled.size());
+
+        if (uncompress(shuffled.data(), &length, raw, static_cast<uLong>(array.stored[j])) != Z_OK || length != shuffled.size())
+            throw std::runtime_error("GridReader: corrupt compressed slice in " + array.info.name);
+
+        decoded.resize(n * width);
+        unshuffle_bytes(shuffled.data(), n, width, decoded.data());
+        raw = decoded.data();
+#else
+        throw std::logic_error("GridReader: " + array.info.name + " is compressed and the library was built without zlib");
+#endif
+    }
+
+    else if (array.info.codec != GridCodec::none)
+        throw std::runtime_error("GridReader: unknown codec for " + array.info.name);
+
+    if (array.info.dtype == GridDtype::float64)
+        std::memcpy(out, raw, n * width);
+
+    else
+        for (std::size_t i = 0; i < n; ++i)
+            out[i] = load<float>(raw + i * width);
+}
@@ -0,0 +1,103 @@
+#include "instrumentation.hpp"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <mutex>
+
+std::atomic<InstrumentationHook> instrumentation_hook{nullptr};
+
+namespace
+{
+    // A deque keeps slot addresses stable as slots are added
+    std::mutex registry_mutex;
+    std::deque<InstrumentationSlot> registry;
+}
+
+InstrumentationSlot &instrumentation_slot(const char *name)
+{
+    std::lock_guard<std::mutex> lock(registry_mutex);
+
+    for (auto &slot : registry)
+        if (std::strcmp(slot.name, name) == 0)
+            return slot;
+
+    registry.emplace_back();
+    registry.back().name = name;
+
+    return registry.back();
+}
+
+std::vector<InstrumentationRecord> instrumentation_report()
+{
+    std::vector<InstrumentationRecord> report;
+
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+
+        for (const auto &slot : registry)
+        {
+            InstrumentationRecord record;
+            record.name = slot.name;
+            record.calls = slot.calls.load(std::memory_order_relaxed);
+            record.total_ns = slot.total_ns.load(std::memory_order_relaxed);
+            record.count = slot.count.load(std::memory_order_relaxed);
+
+            if (record.calls || record.count)
+                report.push_back(std::move(record));
+        }
+    }
+
+    std::sort(report.begin(), report.end(), [](const InstrumentationRecord &a, const InstrumentationRecord &b)
+              { return a.name < b.name; });
+
+    return report;
+}
+
+void print_instrumentation_report(std::ostream &os)
+{
+    std::ios_base::fmtflags flags = os.flags();
+    std::streamsize precision = os.precision();
+
+    for (const auto &record : instrumentation_report())
+    {
+        os << std::left << std::setw(28) << record.name << std::right;
+
+        if (record.calls)
+            os << std::setw(12) << record.calls << " calls" << std::setw(14) << std::fixed << std::setprecision(3)
+               << record.total_ns * 1e-6 << " ms";
+        else
+            os << std::setw(18) << record.count;
+
+        os << "\n";
+    }
+
+    os.flags(flags);
+    os.precision(precision);
+}
+
+void reset_instrumentation()
+{
+    std::lock_guard<std::mutex> lock(registry_mutex);
+
+    for (auto &slot : registry)
+    {
+        slot.calls.store(0, std::memory_order_relaxed);
+        slot.total_ns.store(0, std::memory_order_relaxed);
+        slot.count.store(0, std::memory_order_relaxed);
+    }
+}
+
+bool instrumentation_enabled()
+{
+#if defined(WAB_INSTRUMENTATION)
+    return true;
+#else
+    return false;
+#endif
+}
+
+void set_instrumentation_hook(InstrumentationHook hook)
+{
+    instrumentation_hook.store(hook, std::memory_order_relaxed);
+}
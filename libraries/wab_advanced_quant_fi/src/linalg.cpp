@@ -1,4 +1,167 @@
 #include "linalg.hpp"
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+tridiagonal_solver::tridiagonal_solver(const std::vector<double> &sub, const std::vector<double> &diag, const std::vector<double> &super)
+    : sub(sub), upper(diag.size()), inv_pivot(diag.size())
+{
+    std::size_t n = diag.size();
+
+    if (sub.size() != n || super.size() != n)
+        throw std::invalid_argument("tridiagonal_solver: bands must have the same length");
+
+    for (std::size_t i = 0; i < n; i++)
+    {
+        double pivot = diag[i] - (i ? sub[i] * upper[i - 1] : 0.);
+        inv_pivot[i] = 1. / pivot;
+        upper[i] = i + 1 < n ? super[i] * inv_pivot[i] : 0.;
+    }
+}
+
+void tridiagonal_solver::solve(double *rhs) const
+{
+    std::size_t n = inv_pivot.size();
+
+    if (n == 0)
+        return;
+
+    rhs[0] *= inv_pivot[0];
+    for (std::size_t i = 1; i < n; i++)
+        rhs[i] = (rhs[i] - sub[i] * rhs[i - 1]) * inv_pivot[i];
+
+    for (std::size_t i = n - 1; i-- > 0;)
+        rhs[i] -= upper[i] * rhs[i + 1];
+}
+
+matrix<double> cholesky_decompose(const matrix<double> &a)
+{
+    std::size_t n = a.rows();
+
+    if (a.cols() != n)
+        throw std::invalid_argument("cholesky_decompose: matrix must be square");
+
+    matrix<double> L(n, n);
+
+    for (std::size_t j = 0; j < n; j++)
+    {
+        double pivot = a(j, j);
+        for (std::size_t k = 0; k < j; k++)
+            pivot -= L(j, k) * L(j, k);
+
+        // Round-off tolerance relative to the diagonal
+        double tolerance = 1e-12 * std::fabs(a(j, j));
+        if (pivot < -tolerance)
+            throw std::invalid_argument("cholesky_decompose: matrix is not positive semi-definite");
+
+        if (pivot <= tolerance)
+            continue;
+
+        L(j, j) = std::sqrt(pivot);
+
+        for (std::size_t i = j + 1; i < n; i++)
+        {
+            double sum = a(i, j);
+            for (std::size_t k = 0; k < j; k++)
+                sum -= L(i, k) * L(j, k);
+
+            L(i, j) = sum / L(j, j);
+        }
+    }
+
+    return L;
+}
+
+void symmetric_eigen(const matrix<double> &a, std::vector<double> &values, matrix<double> &vectors)
+{
+    std::size_t n = a.rows();
+
+    if (a.cols() != n)
+        throw std::invalid_argument("symmetric_eigen: matrix must be square");
+
+    matrix<double> b = a;
+    matrix<double> v(n, n);
+    for (std::size_t i = 0; i < n; i++)
+        v(i, i) = 1.;
+
+    auto off_diagonal = [&]()
+    {
+        double sum = 0.;
+        for (std::size_t i = 0; i < n; i++)
+            for (std::size_t j = i + 1; j < n; j++)
+                sum += b(i, j) * b(i, j);
+        return sum;
+    };
+
+    double scale = 0.;
+    for (std::size_t i = 0; i < n; i++)
+        for (std::size_t j = 0; j < n; j++)
+            scale += a(i, j) * a(i, j);
+
+    constexpr int max_sweeps = 100;
+    double tolerance = 1e-30 * scale;
+
+    for (int sweep = 0; sweep < max_sweeps && off_diagonal() > tolerance; sweep++)
+        for (std::size_t p = 0; p < n; p++)
+            for (std::size_t q = p + 1; q < n; q++)
+            {
+                if (b(p, q) == 0.)
+                    continue;
+
+                // Rotation that zeroes b(p, q)
+                double theta = (b(q, q) - b(p, p)) / (2 * b(p, q));
+                double t = (theta >= 0 ? 1. : -1.) / (std::fabs(theta) + std::sqrt(theta * theta + 1));
+                double c = 1 / std::sqrt(t * t + 1), s = t * c;
+
+                for (std::size_t k = 0; k < n; k++)
+                {
+                    double bkp = b(k, p), bkq = b(k, q);
+                    b(k, p) = c * bkp - s * bkq;
+                    b(k, q) = s * bkp + c * bkq;
+                }
+
+                for (std::size_t k = 0; k < n; k++)
+                {
+                    double bpk = b(p, k), bqk = b(q, k);
+                    b(p, k) = c * bpk - s * bqk;
+                    b(q, k) = s * bpk + c * bqk;
+                }
+
+                for (std::size_t k = 0; k < n; k++)
+                {
+                    double vkp = v(k, p), vkq = v(k, q);
+                    v(k, p) = c * vkp - s * vkq;
+                    v(k, q) = s * vkp + c * vkq;
+                }
+            }
+
+    // Also catches NaN entries, which never converge
+    if (!(off_diagonal() <= tolerance))
+        throw std::runtime_error("symmetric_eigen: Jacobi sweeps did not converge");
+
+    std::vector<std::size_t> order(n);
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t i, std::size_t j)
+                     { return b(i, i) > b(j, j); });
+
+    values.resize(n);
+    vectors = matrix<double>(n, n);
+
+    for (std::size_t k = 0; k < n; k++)
+    {
+        std::size_t column = order[k];
+        values[k] = b(column, column);
+
+        std::size_t largest = 0;
+        for (std::size_t i = 1; i < n; i++)
+            if (std::fabs(v(i, column)) > std::fabs(v(largest, column)))
+                largest = i;
+
+        double sign = v(largest, column) < 0 ? -1. : 1.;
+        for (std::size_t i = 0; i < n; i++)
+            vectors(i, k) = sign * v(i, column);
+    }
+}
 
 matrix<double> matrix_creator()
 {
@@ -0,0 +1,12 @@
+#include "parallel.hpp"
+
+int hardware_thread_count()
+{
+    unsigned n = std::thread::hardware_concurrency();
+    return n ? static_cast<int>(n) : 1;
+}
+
+int resolve_thread_count(int threads)
+{
+    return threads > 0 ? threads : hardware_thread_count();
+}
@@ -0,0 +1,165 @@
+#include "payoff.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+double Payoff::terminal_slope(double) const
+{
+    throw std::logic_error("Payoff::terminal_slope: payoff has no pathwise derivative");
+}
+
+double CallPayoff::operator()(const PathState &state) const
+{
+    return std::max(state.terminal - K, 0.);
+}
+
+double CallPayoff::terminal_slope(double terminal) const
+{
+    return terminal > K ? 1. : 0.;
+}
+
+double PutPayoff::operator()(const PathState &state) const
+{
+    return std::max(K - state.terminal, 0.);
+}
+
+double PutPayoff::terminal_slope(double terminal) const
+{
+    return terminal < K ? -1. : 0.;
+}
+
+double AsianCallPayoff::operator()(const PathState &state) const
+{
+    return std::max(state.average - K, 0.);
+}
+
+double LookbackCallPayoff::operator()(const PathState &state) const
+{
+    return state.terminal - state.minimum;
+}
+
+double UpAndOutCallPayoff::operator()(const PathState &state) const
+{
+    if (state.maximum >= barrier)
+        return 0.;
+
+    return std::max(state.terminal - K, 0.);
+}
+
+namespace
+{
+    // out[p] = max_a S_a or min_a S_a over the asset rows of S
+    template <class Select>
+    void reduce_assets(const double *S, std::size_t n_assets, std::size_t n_paths, double *out, Select select)
+    {
+        std::copy_n(S, n_paths, out);
+
+        for (std::size_t a = 1; a < n_assets; ++a)
+        {
+            const double *S_a = S + a * n_paths;
+            for (std::size_t p = 0; p < n_paths; ++p)
+                out[p] = select(out[p], S_a[p]);
+        }
+    }
+
+    void weighted_sum(const std::vector<double> &weights, const double *S, std::size_t n_assets, std::size_t n_paths, double *out)
+    {
+        if (weights.size() != n_assets)
+            throw std::invalid_argument("BasketPayoff: need one weight per asset");
+
+        std::fill(out, out + n_paths, 0.);
+
+        for (std::size_t a = 0; a < n_assets; ++a)
+        {
+            const double *S_a = S + a * n_paths;
+            for (std::size_t p = 0; p < n_paths; ++p)
+                out[p] += weights[a] * S_a[p];
+        }
+    }
+
+    double larger(double x, double y)
+    {
+        return std::max(x, y);
+    }
+
+    double smaller(double x, double y)
+    {
+        return std::min(x, y);
+    }
+}
+
+void MaxOfAssetsPayoff::operator()(const double *S, std::size_t n_assets, std::size_t n_paths, double *out) const
+{
+    reduce_assets(S, n_assets, n_paths, out, larger);
+}
+
+void BestOfCallPayoff::operator()(const double *S, std::size_t n_assets, std::size_t n_paths, double *out) const
+{
+    reduce_assets(S, n_assets, n_paths, out, larger);
+
+    for (std::size_t p = 0; p < n_paths; ++p)
+        out[p] = std::max(out[p] - K, 0.);
+}
+
+void WorstOfPutPayoff::operator()(const double *S, std::size_t n_assets, std::size_t n_paths, double *out) const
+{
+    reduce_assets(S, n_assets, n_paths, out, smaller);
+
+    for (std::size_t p = 0; p < n_paths; ++p)
+        out[p] = std::max(K - out[p], 0.);
+}
+
+void BasketCallPayoff::operator()(const double *S, std::size_t n_assets, std::size_t n_paths, double *out) const
+{
+    weighted_sum(weights, S, n_assets, n_paths, out);
+
+    for (std::size_t p = 0; p < n_paths; ++p)
+        out[p] = std::max(out[p] - K, 0.);
+}
+
+void BasketPutPayoff::operator()(const double *S, std::size_t n_assets, std::size_t n_paths, double *out) const
+{
+    weighted_sum(weights, S, n_assets, n_paths, out);
+
+    for (std::size_t p = 0; p < n_paths; ++p)
+        out[p] = std::max(K - out[p], 0.);
+}
+
+PathStatisticsBatch::PathStatisticsBatch(unsigned statistics, std::size_t n_paths, double S0) : statistics(statistics), n_paths(n_paths)
+{
+    if (statistics & path_maximum)
+        maximum.assign(n_paths, S0);
+
+    if (statistics & path_minimum)
+        minimum.assign(n_paths, S0);
+
+    if (statistics & path_average)
+        sum.assign(n_paths, 0.);
+}
+
+void PathStatisticsBatch::update(const double *S)
+{
+    ++n_updates;
+
+    if (statistics & path_maximum)
+        for (std::size_t p = 0; p < n_paths; ++p)
+            maximum[p] = std::max(maximum[p], S[p]);
+
+    if (statistics & path_minimum)
+        for (std::size_t p = 0; p < n_paths; ++p)
+            minimum[p] = std::min(minimum[p], S[p]);
+
+    if (statistics & path_average)
+        for (std::size_t p = 0; p < n_paths; ++p)
+            sum[p] += S[p];
+}
+
+PathState PathStatisticsBatch::state(std::size_t p, double terminal) const
+{
+    PathState result;
+    result.terminal = terminal;
+    result.maximum = maximum.empty() ? terminal : maximum[p];
+    result.minimum = minimum.empty() ? terminal : minimum[p];
+    result.average = sum.empty() || n_updates == 0 ? terminal : sum[p] / n_updates;
+
+    return result;
+}
@@ -0,0 +1,527 @@
+#include "portfolio.hpp"
+#include "instrumentation.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+    // Grid points of the recursion when no loss unit is set
+    constexpr double default_loss_buckets = 2000;
+
+    // Quadrature nodes handled by one parallel task; fixed so that the
+    // weighted sum is the same for every thread count
+    constexpr std::size_t nodes_per_task = 4;
+
+    // Obligors sharing one thinning rate in the Monte Carlo engine
+    constexpr std::size_t sampling_block = 256;
+
+    // Quadrature nodes lighter than this are dropped
+    constexpr double min_node_weight = 1e-18;
+
+    // Uniform on (0, 1) from 53 bits of two Philox outputs
+    double open_uniform(Philox4x32 &rng)
+    {
+        std::uint32_t a = rng() >> 5, b = rng() >> 6;
+        return (a * 67108864.0 + b + 0.5) / 9007199254740992.0;
+    }
+
+    // One obligor's loss in grid units, split between floor and floor + 1 so
+    // that the mean is exact: k with probability 1 - frac, k + 1 with frac
+    struct grid_loss
+    {
+        std::size_t k{};
+        double frac{};
+    };
+
+    // Conditional loss probabilities below this are dropped from the window
+    // the recursion works on; at most obligors x grid x 1e-20 of mass is lost
+    constexpr double negligible_mass = 1e-20;
+
+    // P(L = l), nonzero only for l in [lo, hi], -> the distribution after
+    // adding an obligor defaulting with probability p. Losses past the last
+    // grid point G are kept there. Returns the new hi; out is only valid on
+    // [lo, new hi].
+    std::size_t add_obligor(const double *in, double *out, std::size_t lo, std::size_t hi,
+                            std::size_t G, grid_loss loss, double p)
+    {
+        double q = 1 - p, a = p * (1 - loss.frac), b = p * loss.frac;
+        std::size_t k = loss.k;
+        std::size_t new_hi = std::min(hi + k + 1, G);
+
+        std::fill(out + lo, out + new_hi + 1, 0.);
+
+        for (std::size_t l = lo; l <= hi; ++l)
+            out[l] += q * in[l];
+
+        // Sources whose default loss stays on the grid, then the rest into G
+        std::size_t a_stop = std::min(hi + 1, G - k + 1), b_stop = std::min(hi + 1, G - k);
+
+        for (std::size_t l = lo; l < a_stop; ++l)
+            out[l + k] += a * in[l];
+
+        for (std::size_t l = lo; l < b_stop; ++l)
+            out[l + k + 1] += b * in[l];
+
+        for (std::size_t l = std::max(lo, a_stop); l <= hi; ++l)
+            out[G] += a * in[l];
+
+        for (std::size_t l = std::max(lo, b_stop); l <= hi; ++l)
+            out[G] += b * in[l];
+
+        return new_hi;
+    }
+
+    // Trapezoid rule for E[f(Z)], Z ~ N(0, 1), on n equally spaced nodes over
+    // [-z_max, z_max]; weights are normalized to sum to 1. For smooth f it
+    // converges faster than any power of the spacing, and unlike Gauss-Hermite
+    // the nodes stay dense in the tails that drive VaR.
+    void normal_trapezoid_rule(int n, std::vector<double> &nodes, std::vector<double> &weights)
+    {
+        constexpr double z_max = 8.5;
+
+        nodes.resize(n);
+        weights.resize(n);
+
+        double h = n > 1 ? 2 * z_max / (n - 1) : 0., sum = 0.;
+        for (int k = 0; k < n; ++k)
+        {
+            nodes[k] = n > 1 ? -z_max + k * h : 0.;
+            weights[k] = std::exp(-0.5 * nodes[k] * nodes[k]);
+            sum += weights[k];
+        }
+
+        for (auto &weight : weights)
+            weight /= sum;
+    }
+}
+
+double hazard_default_probability(double hazard_rate, double T)
+{
+    return -std::expm1(-hazard_rate * T);
+}
+
+double hazard_default_probability(const PiecewiseFlatCurve &hazard, double T)
+{
+    return -std::expm1(-hazard.integral(T));
+}
+
+double PortfolioLossResults::quantile(double level) const
+{
+    double cumulative = 0.;
+    for (std::size_t k = 0; k < loss.size(); ++k)
+    {
+        cumulative += probability[k];
+        if (cumulative + 1e-12 >= level)
+            return loss[k];
+    }
+
+    return loss.empty() ? 0. : loss.back();
+}
+
+double PortfolioLossResults::shortfall(double level) const
+{
+    if (!(level > 0 && level < 1))
+        throw std::invalid_argument("PortfolioLossResults::shortfall: level must be in (0, 1)");
+
+    double var = quantile(level), tail = 0., at_or_below = 0.;
+    for (std::size_t k = 0; k < loss.size(); ++k)
+    {
+        if (loss[k] > var)
+            tail += probability[k] * loss[k];
+        else
+            at_or_below += probability[k];
+    }
+
+    return (tail + var * std::max(at_or_below - level, 0.)) / (1 - level);
+}
+
+double PortfolioLossResults::tranche_loss(double attachment, double detachment) const
+{
+    if (!(detachment > attachment))
+        throw std::invalid_argument("PortfolioLossResults::tranche_loss: detachment must exceed attachment");
+
+    double expected = 0.;
+    for (std::size_t k = 0; k < loss.size(); ++k)
+        expected += probability[k] * std::min(std::max(loss[k] - attachment, 0.), detachment - attachment);
+
+    return expected;
+}
+
+CreditPortfolio::CreditPortfolio(std::vector<double> default_probability, std::vector<double> exposure,
+                                 std::vector<double> recovery, double rho)
+{
+    if (!(rho >= 0 && rho < 1))
+        throw std::invalid_argument("CreditPortfolio: rho must be in [0, 1)");
+
+    matrix<double> one_factor(exposure.size(), 1, matrix_layout::column_major, std::sqrt(rho));
+    *this = CreditPortfolio(std::move(default_probability), std::move(exposure), std::move(recovery), std::move(one_factor));
+}
+
+CreditPortfolio::CreditPortfolio(std::vector<double> default_probability, std::vector<double> exposure,
+                                 std::vector<double> recovery, matrix<double> loadings)
+    : default_probability(std::move(default_probability)), exposure(std::move(exposure)), recovery(std::move(recovery))
+{
+    std::size_t n = this->exposure.size();
+    if (this->default_probability.size() != n || this->recovery.size() != n || loadings.rows() != n)
+        throw std::invalid_argument("CreditPortfolio: need one probability, exposure, recovery and loading row per obligor");
+
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        if (!(this->default_probability[i] >= 0 && this->default_probability[i] <= 1))
+            throw std::invalid_argument("CreditPortfolio: default probabilities must be in [0, 1]");
+
+        if (!(this->recovery[i] >= 0 && this->recovery[i] <= 1))
+            throw std::invalid_argument("CreditPortfolio: recovery rates must be in [0, 1]");
+
+        if (!(this->exposure[i] >= 0))
+            throw std::invalid_argument("CreditPortfolio: exposures must be non-negative");
+
+        double norm = 0.;
+        for (std::size_t f = 0; f < loadings.cols(); ++f)
+            norm += loadings(i, f) * loadings(i, f);
+
+        if (!(norm < 1))
+            throw std::invalid_argument("CreditPortfolio: each obligor's loadings need |a_i| < 1");
+    }
+
+    // Column f holds every obligor's loading on factor f
+    this->loadings = matrix<double>(n, loadings.cols(), matrix_layout::column_major);
+    for (std::size_t i = 0; i < n; ++i)
+        for (std::size_t f = 0; f < loadings.cols(); ++f)
+            this->loadings(i, f) = loadings(i, f);
+}
+
+PortfolioLossResults CreditPortfolio::find_loss_distribution() const
+{
+    if (!(confidence > 0 && confidence < 1))
+        throw std::invalid_argument("CreditPortfolio: confidence must be in (0, 1)");
+
+    bool recursive = engine == PricingEngine::analytic || (engine == PricingEngine::automatic && factors() <= 1);
+
+    PortfolioLossResults results = recursive ? find_recursive_distribution() : find_simulated_distribution();
+
+    results.value_at_risk = results.quantile(confidence);
+    results.expected_shortfall = results.shortfall(confidence);
+
+    return results;
+}
+
+PortfolioLossResults CreditPortfolio::find_recursive_distribution() const
+{
+    WAB_TIME_SCOPE("portfolio.recursion");
+
+    std::size_t n = obligors(), F = factors();
+
+    PortfolioLossResults results;
+    for (double p : default_probability)
+        results.expected_defaults += p;
+
+    double total = 0.;
+    for (std::size_t i = 0; i < n; ++i)
+        total += exposure[i] * (1 - recovery[i]);
+
+    if (total <= 0)
+    {
+        results.loss = {0.};
+        results.probability = {1.};
+        return results;
+    }
+
+    double unit = loss_unit > 0 ? loss_unit : total / default_loss_buckets;
+    std::size_t G = static_cast<std::size_t>(std::ceil(total / unit));
+
+    std::vector<grid_loss> grid(n);
+    std::vector<double> threshold(n), inverse_scale(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        double units = exposure[i] * (1 - recovery[i]) / unit;
+        grid[i].k = std::min(static_cast<std::size_t>(units), G);
+        grid[i].frac = grid[i].k == G ? 0. : units - grid[i].k;
+
+        double norm = 0.;
+        for (std::size_t f = 0; f < F; ++f)
+            norm += loadings(i, f) * loadings(i, f);
+
+        threshold[i] = normal_quantile(default_probability[i]);
+        inverse_scale[i] = 1 / std::sqrt(1 - norm);
+    }
+
+    // Tensor trapezoid nodes over the factors
+    int per_factor = quadrature_nodes > 0 ? quadrature_nodes : F <= 1 ? 201 : 41;
+    std::vector<double> x, w;
+    normal_trapezoid_rule(per_factor, x, w);
+
+    std::vector<std::vector<double>> nodes;
+    std::vector<double> node_weight;
+    {
+        std::size_t count = 1;
+        for (std::size_t f = 0; f < F; ++f)
+            count *= x.size();
+
+        for (std::size_t index = 0; index < count; ++index)
+        {
+            std::vector<double> z(F);
+            double weight = 1.;
+
+            std::size_t rest = index;
+            for (std::size_t f = 0; f < F; ++f)
+            {
+                z[f] = x[rest % x.size()];
+                weight *= w[rest % x.size()];
+                rest /= x.size();
+            }
+
+            if (weight < min_node_weight)
+                continue;
+
+            nodes.push_back(std::move(z));
+            node_weight.push_back(weight);
+        }
+    }
+
+    WAB_COUNT("portfolio.nodes", nodes.size());
+
+    // Each task sums weight * P(L = l | Z) over its nodes
+    auto integrate = [&](std::size_t, std::size_t begin, std::size_t end)
+    {
+        std::vector<double> sum(G + 1), in(G + 1), out(G + 1);
+
+        for (std::size_t node = begin; node < end; ++node)
+        {
+            const std::vector<double> &z = nodes[node];
+
+            // Only [lo, hi] of in holds the distribution
+            std::size_t lo = 0, hi = 0;
+            in[0] = 1.;
+
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                double shift = 0.;
+                for (std::size_t f = 0; f < F; ++f)
+                    shift += loadings(i, f) * z[f];
+
+                double p = normal_cdf((threshold[i] - shift) * inverse_scale[i]);
+                if (p <= 0 || (grid[i].k == 0 && grid[i].frac == 0))
+                    continue;
+
+                hi = add_obligor(in.data(), out.data(), lo, hi, G, grid[i], p);
+
+                while (lo < hi && out[lo] < negligible_mass)
+                    ++lo;
+
+                while (hi > lo && out[hi] < negligible_mass)
+                    --hi;
+
+                std::swap(in, out);
+            }
+
+            for (std::size_t l = lo; l <= hi; ++l)
+                sum[l] += node_weight[node] * in[l];
+        }
+
+        return sum;
+    };
+
+    std::vector<double> density(G + 1);
+    for (const auto &part : parallel_chunks<std::vector<double>>(nodes.size(), nodes_per_task, threads, integrate))
+        for (std::size_t l = 0; l <= G; ++l)
+            density[l] += part[l];
+
+    // Trim the grid after the last point with any mass
+    std::size_t last = G;
+    while (last > 0 && density[last] <= 0)
+        --last;
+
+    for (std::size_t l = 0; l <= last; ++l)
+    {
+        results.loss.push_back(l * unit);
+        results.probability.push_back(density[l]);
+        results.expected_loss += density[l] * l * unit;
+    }
+
+    return results;
+}
+
+// Each scenario draws the factors, then the defaulters only. Obligor i
+// defaults with probability Phi(t_i), t_i = alpha_i + beta_i . Z. Obligors
+// are sorted by alpha and taken in blocks that keep the largest alpha and the
+// range of each beta, which bounds every t_i of the block by some t_bound in
+// O(factors). Candidates are then visited by geometric skips of rate
+// q = Phi(t_bound) and kept with probability Phi(t_i) / q, so the work per
+// scenario scales with the blocks and the defaults, not with the obligors.
+PortfolioLossResults CreditPortfolio::find_simulated_distribution() const
+{
+    WAB_TIME_SCOPE("portfolio.simulation");
+
+    std::size_t n = obligors(), F = factors();
+
+    if (M <= 0)
+        throw std::invalid_argument("CreditPortfolio: need at least one scenario");
+
+    // alpha_i = Phi^-1(p_i) / sqrt(1 - |a_i|^2), beta_i = -a_i / sqrt(1 - |a_i|^2)
+    std::vector<double> unsorted_alpha(n), unsorted_scale(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        double norm = 0.;
+        for (std::size_t f = 0; f < F; ++f)
+            norm += loadings(i, f) * loadings(i, f);
+
+        unsorted_scale[i] = 1 / std::sqrt(1 - norm);
+        unsorted_alpha[i] = normal_quantile(default_probability[i]) * unsorted_scale[i];
+    }
+
+    std::vector<std::size_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t i, std::size_t j)
+                     { return unsorted_alpha[i] > unsorted_alpha[j]; });
+
+    // Obligor data in sampling order; beta row-major so a candidate's row is contiguous
+    std::vector<double> alpha(n), loss(n);
+    matrix<double> beta(n, F);
+    for (std::size_t s = 0; s < n; ++s)
+    {
+        std::size_t i = order[s];
+
+        alpha[s] = unsorted_alpha[i];
+        loss[s] = exposure[i] * (1 - recovery[i]);
+
+        for (std::size_t f = 0; f < F; ++f)
+            beta(s, f) = -loadings(i, f) * unsorted_scale[i];
+    }
+
+    std::size_t n_blocks = (n + sampling_block - 1) / sampling_block;
+    std::vector<double> block_alpha(n_blocks);
+    matrix<double> beta_max(n_blocks, F), beta_min(n_blocks, F);
+    for (std::size_t b = 0; b < n_blocks; ++b)
+    {
+        std::size_t first = b * sampling_block, last = std::min(first + sampling_block, n);
+
+        block_alpha[b] = alpha[first];
+        for (std::size_t f = 0; f < F; ++f)
+        {
+            beta_max(b, f) = beta_min(b, f) = beta(first, f);
+            for (std::size_t s = first + 1; s < last; ++s)
+            {
+                beta_max(b, f) = std::max(beta_max(b, f), beta(s, f));
+                beta_min(b, f) = std::min(beta_min(b, f), beta(s, f));
+            }
+        }
+    }
+
+    struct chunk_result
+    {
+        RunningStats stats;
+        std::vector<double> losses;
+        double defaults{};
+    };
+
+    auto simulate_chunk = [&](std::size_t, std::size_t begin, std::size_t end)
+    {
+        chunk_result result;
+        result.losses.reserve(end - begin);
+
+        std::vector<double> z(F);
+
+        WAB_COUNT("portfolio.scenarios", end - begin);
+
+        for (std::size_t scenario = begin; scenario < end; ++scenario)
+        {
+            Philox4x32 rng(seed, scenario);
+
+            for (auto &factor : z)
+                factor = normal_quantile(open_uniform(rng));
+
+            double scenario_loss = 0.;
+            std::size_t defaults = 0;
+
+            for (std::size_t b = 0; b < n_blocks; ++b)
+            {
+                std::size_t block_end = std::min((b + 1) * sampling_block, n);
+
+                double t_bound = block_alpha[b];
+                for (std::size_t f = 0; f < F; ++f)
+                    t_bound += (z[f] > 0 ? beta_max(b, f) : beta_min(b, f)) * z[f];
+
+                double q = normal_cdf(t_bound);
+                if (q <= 0)
+                    continue;
+
+                double log_miss = std::log1p(-q);
+
+                for (std::size_t i = b * sampling_block;; ++i)
+                {
+                    // Obligors skipped before the next candidate
+                    if (q < 1)
+                    {
+                        double skip = std::floor(std::log(open_uniform(rng)) / log_miss);
+                        if (skip >= static_cast<double>(block_end - i))
+                            break;
+
+                        i += static_cast<std::size_t>(skip);
+                    }
+
+                    if (i >= block_end)
+                        break;
+
+                    double t = alpha[i];
+                    for (std::size_t f = 0; f < F; ++f)
+                        t += beta(i, f) * z[f];
+
+                    if (open_uniform(rng) * q < normal_cdf(t))
+                    {
+                        scenario_loss += loss[i];
+                        ++defaults;
+                    }
+                }
+            }
+
+            result.losses.push_back(scenario_loss);
+            result.stats.add(scenario_loss);
+            result.defaults += defaults;
+        }
+
+        return result;
+    };
+
+    auto chunks = parallel_chunks<chunk_result>(M, mc_chunk_paths, threads, simulate_chunk);
+
+    RunningStats stats;
+    double defaults = 0.;
+    std::vector<double> losses;
+    losses.reserve(M);
+
+    for (const auto &chunk : chunks)
+    {
+        stats.merge(chunk.stats);
+        defaults += chunk.defaults;
+        losses.insert(losses.end(), chunk.losses.begin(), chunk.losses.end());
+    }
+
+    std::sort(losses.begin(), losses.end());
+
+    // Equal scenario losses become one atom of the distribution
+    PortfolioLossResults results;
+    for (double value : losses)
+    {
+        if (results.loss.empty() || results.loss.back() != value)
+        {
+            results.loss.push_back(value);
+            results.probability.push_back(0.);
+        }
+
+        results.probability.back() += 1.;
+    }
+
+    for (auto &probability : results.probability)
+        probability /= M;
+
+    results.expected_loss_estimate = stats.estimate();
+    results.expected_loss = results.expected_loss_estimate.value;
+    results.expected_defaults = defaults / M;
+
+    return results;
+}
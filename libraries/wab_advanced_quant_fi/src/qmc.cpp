@@ -0,0 +1,271 @@
+#include "qmc.hpp"
+#include "instrumentation.hpp"
+#include "variance_reduction.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+    // Direction numbers are part of the sequence, not of a run, so they come
+    // from a fixed stream
+    constexpr std::uint64_t sobol_direction_seed = 0x50B01;
+
+    // Multiply polynomials over GF(2) modulo the degree-d polynomial poly
+    std::uint64_t gf2_mulmod(std::uint64_t a, std::uint64_t b, std::uint64_t poly, int d)
+    {
+        std::uint64_t result = 0;
+        while (b)
+        {
+            if (b & 1)
+                result ^= a;
+            b >>= 1;
+            a <<= 1;
+            if (a >> d & 1)
+                a ^= poly;
+        }
+        return result;
+    }
+
+    std::uint64_t gf2_powmod(std::uint64_t e, std::uint64_t poly, int d)
+    {
+        std::uint64_t result = 1, base = 2; // base is the polynomial x
+        while (e)
+        {
+            if (e & 1)
+                result = gf2_mulmod(result, base, poly, d);
+            base = gf2_mulmod(base, base, poly, d);
+            e >>= 1;
+        }
+        return result;
+    }
+
+    // poly has degree d: x has multiplicative order 2^d - 1
+    bool is_primitive(std::uint64_t poly, int d)
+    {
+        if (!(poly & 1))
+            return false;
+
+        std::uint64_t order = (std::uint64_t{1} << d) - 1;
+        if (gf2_powmod(order, poly, d) != 1)
+            return false;
+
+        // x^(order / q) != 1 for every prime factor q of the order
+        std::uint64_t rest = order;
+        for (std::uint64_t q = 2; q * q <= rest; ++q)
+        {
+            if (rest % q)
+                continue;
+
+            if (gf2_powmod(order / q, poly, d) == 1)
+                return false;
+            while (rest % q == 0)
+                rest /= q;
+        }
+
+        return rest == 1 || gf2_powmod(order / rest, poly, d) != 1;
+    }
+
+    inline int trailing_zeros(std::uint64_t n)
+    {
+        int count = 0;
+        while (!(n & 1))
+        {
+            n >>= 1;
+            ++count;
+        }
+        return count;
+    }
+}
+
+SobolSequence::SobolSequence(std::size_t dimensions) : n_dimensions(dimensions), directions(dimensions * bits)
+{
+    if (dimensions == 0)
+        return;
+
+    for (int k = 0; k < bits; ++k)
+        directions[k] = std::uint32_t{1} << (bits - 1 - k);
+
+    Philox4x32 engine(sobol_direction_seed);
+
+    std::size_t d = 1;
+    for (int degree = 1; d < dimensions; ++degree)
+    {
+        if (degree >= bits)
+            throw std::invalid_argument("SobolSequence: too many dimensions");
+
+        for (std::uint64_t poly = std::uint64_t{1} << degree | 1; poly < std::uint64_t{2} << degree && d < dimensions; poly += 2)
+        {
+            if (!is_primitive(poly, degree))
+                continue;
+
+            std::uint32_t *v = &directions[d * bits];
+
+            // m_k odd in [1, 2^k), stored left-aligned
+            for (int k = 0; k < degree; ++k)
+            {
+                std::uint32_t m = (engine() >> (bits - 1 - k)) | 1u;
+                v[k] = m << (bits - 1 - k);
+            }
+
+            for (int k = degree; k < bits; ++k)
+            {
+                v[k] = v[k - degree] ^ (v[k - degree] >> degree);
+                for (int i = 1; i < degree; ++i)
+                    if (poly >> (degree - i) & 1)
+                        v[k] ^= v[k - i];
+            }
+
+            ++d;
+        }
+    }
+}
+
+void SobolSequence::point(std::uint64_t index, std::uint32_t *out) const
+{
+    std::uint64_t gray = index ^ (index >> 1);
+
+    for (std::size_t d = 0; d < n_dimensions; ++d)
+    {
+        std::uint32_t x = 0;
+        for (int k = 0; k < bits && (gray >> k); ++k)
+            if (gray >> k & 1)
+                x ^= directions[d * bits + k];
+        out[d] = x;
+    }
+}
+
+void SobolSequence::next(std::uint64_t index, std::uint32_t *x) const
+{
+    int k = trailing_zeros(index);
+
+    for (std::size_t d = 0; d < n_dimensions; ++d)
+        x[d] ^= directions[d * bits + k];
+}
+
+BrownianBridge::BrownianBridge(std::size_t steps)
+    : steps(steps), bridge_index(steps), left_index(steps), right_index(steps),
+      left_weight(steps), right_weight(steps), std_dev(steps)
+{
+    if (steps == 0)
+        return;
+
+    // map[i] != 0 once W at step i is constructed; times are t_i = i + 1
+    std::vector<std::size_t> map(steps);
+    map[steps - 1] = 1;
+    bridge_index[0] = steps - 1;
+    std_dev[0] = std::sqrt(static_cast<double>(steps));
+
+    for (std::size_t i = 1, j = 0; i < steps; ++i)
+    {
+        while (map[j])
+            ++j;
+
+        std::size_t k = j;
+        while (!map[k])
+            ++k;
+
+        std::size_t l = j + ((k - 1 - j) >> 1);
+        map[l] = i;
+
+        bridge_index[i] = l;
+        left_index[i] = j;
+        right_index[i] = k;
+
+        double t_left = static_cast<double>(j), t_mid = l + 1., t_right = k + 1.;
+        left_weight[i] = (t_right - t_mid) / (t_right - t_left);
+        right_weight[i] = (t_mid - t_left) / (t_right - t_left);
+        std_dev[i] = std::sqrt((t_mid - t_left) * (t_right - t_mid) / (t_right - t_left));
+
+        j = k + 1;
+        if (j >= steps)
+            j = 0;
+    }
+}
+
+void BrownianBridge::increments(const double *z, double *out) const
+{
+    if (steps == 0)
+        return;
+
+    // Build W(t_i) in out, then difference in place from the end
+    out[steps - 1] = std_dev[0] * z[0];
+
+    for (std::size_t i = 1; i < steps; ++i)
+    {
+        std::size_t j = left_index[i], k = right_index[i], l = bridge_index[i];
+        double left = j ? out[j - 1] : 0.;
+
+        out[l] = left_weight[i] * left + right_weight[i] * out[k] + std_dev[i] * z[i];
+    }
+
+    for (std::size_t i = steps - 1; i > 0; --i)
+        out[i] -= out[i - 1];
+}
+
+SobolPaths::SobolPaths(std::size_t steps, std::size_t factors, std::uint64_t seed)
+    : steps(steps), factors(factors), sobol(steps * factors), bridge(steps),
+      shifts(sobol_replications * steps * factors)
+{
+    Philox4x32 engine(seed, sobol_direction_seed);
+
+    for (auto &shift : shifts)
+        shift = engine();
+}
+
+void SobolPaths::chunk_increments(std::size_t chunk, std::size_t n_paths, double *out) const
+{
+    std::size_t dimensions = steps * factors;
+    const std::uint32_t *shift = &shifts[replication(chunk) * dimensions];
+    WAB_COUNT("rng.sobol_normals", n_paths * dimensions);
+    std::uint64_t first = static_cast<std::uint64_t>(chunk / sobol_replications) * mc_chunk_paths;
+
+    std::vector<std::uint32_t> x(dimensions);
+    std::vector<double> z(steps), dW(steps);
+
+    sobol.point(first, x.data());
+
+    for (std::size_t p = 0; p < n_paths; ++p)
+    {
+        if (p > 0)
+            sobol.next(first + p, x.data());
+
+        for (std::size_t f = 0; f < factors; ++f)
+        {
+            // Bridge rank i of factor f is dimension i * factors + f
+            for (std::size_t i = 0; i < steps; ++i)
+            {
+                std::uint32_t u = x[i * factors + f] ^ shift[i * factors + f];
+                z[i] = normal_quantile((u + 0.5) * 0x1p-32);
+            }
+
+            bridge.increments(z.data(), dW.data());
+
+            for (std::size_t i = 0; i < steps; ++i)
+                out[(i * factors + f) * n_paths + p] = dW[i];
+        }
+    }
+}
+
+ChunkNormals::ChunkNormals(const SobolPaths *sobol, std::uint64_t seed, std::size_t chunk, std::size_t n_paths,
+                           std::size_t steps, std::size_t factors, unsigned variance_reduction)
+    : normal(seed, chunk), n_paths(n_paths), variance_reduction(variance_reduction)
+{
+    if (sobol)
+    {
+        increments.resize(steps * factors * n_paths);
+        sobol->chunk_increments(chunk, n_paths, increments.data());
+    }
+}
+
+void ChunkNormals::fill(double *eps)
+{
+    if (increments.empty())
+    {
+        fill_step_normals(normal, eps, n_paths, variance_reduction);
+        return;
+    }
+
+    std::copy_n(&increments[next_block * n_paths], n_paths, eps);
+    ++next_block;
+}
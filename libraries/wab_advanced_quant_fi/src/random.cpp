@@ -1,16 +1,158 @@
 #include "random.hpp"
+#include "instrumentation.hpp"
+#include "simd.hpp"
+#include "simd_kernels.hpp"
+#include <algorithm>
 #include <cmath>
 
+namespace
+{
+    constexpr std::uint32_t philox_m0 = 0xD2511F53, philox_m1 = 0xCD9E8D57;
+    constexpr std::uint32_t philox_w0 = 0x9E3779B9, philox_w1 = 0xBB67AE85;
+    constexpr int philox_rounds = 10;
+
+    constexpr std::size_t normal_tile_pairs = 128;
+
+    inline Philox4x32::counter_type make_counter(std::uint64_t block, std::uint64_t stream)
+    {
+        return {static_cast<std::uint32_t>(block), static_cast<std::uint32_t>(block >> 32),
+                static_cast<std::uint32_t>(stream), static_cast<std::uint32_t>(stream >> 32)};
+    }
+
+    inline Philox4x32::key_type make_key(std::uint64_t seed)
+    {
+        return {static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)};
+    }
+
+    void box_muller_pairs(std::uint64_t first_pair, std::uint64_t stream, std::uint64_t seed,
+                          std::size_t n_pairs, double *z0, double *z1)
+    {
+        switch (active_simd_level())
+        {
+#if defined(WAB_SIMD_X86)
+        case SimdLevel::avx512:
+            box_muller_pairs_avx512(first_pair, stream, seed, n_pairs, z0, z1);
+            break;
+        case SimdLevel::avx2:
+            box_muller_pairs_avx2(first_pair, stream, seed, n_pairs, z0, z1);
+            break;
+#endif
+        default:
+            box_muller_pairs_lanes<ScalarLanes>(first_pair, stream, seed, n_pairs, z0, z1);
+        }
+    }
+}
+
+Philox4x32::Philox4x32(std::uint64_t seed, std::uint64_t stream) : seed(seed), stream(stream)
+{
+}
+
+Philox4x32::counter_type Philox4x32::generate_block(counter_type ctr, key_type key)
+{
+    for (int round = 0; round < philox_rounds; ++round)
+    {
+        std::uint64_t p0 = static_cast<std::uint64_t>(philox_m0) * ctr[0];
+        std::uint64_t p1 = static_cast<std::uint64_t>(philox_m1) * ctr[2];
+
+        ctr = {static_cast<std::uint32_t>(p1 >> 32) ^ ctr[1] ^ key[0], static_cast<std::uint32_t>(p1),
+               static_cast<std::uint32_t>(p0 >> 32) ^ ctr[3] ^ key[1], static_cast<std::uint32_t>(p0)};
+
+        key[0] += philox_w0;
+        key[1] += philox_w1;
+    }
+
+    return ctr;
+}
+
+Philox4x32::result_type Philox4x32::operator()()
+{
+    std::size_t lane = position & 3;
+
+    if (lane == 0 || !buffer_valid)
+    {
+        buffer = generate_block(make_counter(position >> 2, stream), make_key(seed));
+        buffer_valid = true;
+    }
+
+    ++position;
+    return buffer[lane];
+}
+
+void Philox4x32::skip_ahead(std::uint64_t n)
+{
+    position += n;
+    buffer_valid = false;
+}
+
+void NormalGenerator::normal_pair(std::uint64_t pair_index, double &z0, double &z1) const
+{
+    box_muller_block<ScalarLanes>(pair_index, stream, seed, &z0, &z1);
+}
+
+double NormalGenerator::operator()()
+{
+    double z0{}, z1{};
+
+    if (position & 1)
+    {
+        if (!has_spare)
+            normal_pair(position >> 1, z0, spare);
+
+        has_spare = false;
+        ++position;
+        return spare;
+    }
+
+    normal_pair(position >> 1, z0, z1);
+    spare = z1;
+    has_spare = true;
+    ++position;
+
+    return z0;
+}
+
+void NormalGenerator::fill(double *out, std::size_t n)
+{
+    WAB_COUNT("rng.normals", n);
+
+    std::size_t i = 0;
+
+    if (n && (position & 1))
+        out[i++] = (*this)();
+
+    double z0[normal_tile_pairs], z1[normal_tile_pairs];
+
+    while (i + 1 < n)
+    {
+        std::size_t n_pairs = std::min(normal_tile_pairs, (n - i) / 2);
+        box_muller_pairs(position >> 1, stream, seed, n_pairs, z0, z1);
+
+        for (std::size_t k = 0; k < n_pairs; ++k)
+        {
+            out[i + 2 * k] = z0[k];
+            out[i + 2 * k + 1] = z1[k];
+        }
+
+        i += 2 * n_pairs;
+        position += 2 * n_pairs;
+    }
+
+    has_spare = false;
+
+    if (i < n)
+        out[i] = (*this)();
+}
+
 double SampleBoxMuller::operator()()
 {
     do
     {
-        x = 2. * rand() / RAND_MAX - 1;
-        y = 2. * rand() / RAND_MAX - 1;
+        x = 2. * ((engine() + 0.5) * 0x1.0p-32) - 1;
+        y = 2. * ((engine() + 0.5) * 0x1.0p-32) - 1;
 
         norm2_sq = x * x + y * y;
     } while (norm2_sq >= 1.);
 
     result = x * std::sqrt(-2 * std::log(norm2_sq) / norm2_sq);
     return result;
-}
\ No newline at end of file
+}
@@ -1,112 +1,360 @@
 #include "rates.hpp"
+#include "analytic.hpp"
+#include "instrumentation.hpp"
+#include "parallel.hpp"
+#include "qmc.hpp"
 #include "random.hpp"
-#include "linalg.hpp"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
 
-IR_results IR::run_LIBOR_simulations() const
+void IR::set_correlation(const matrix<double> &correlation, CorrelationFactorization method, std::size_t factors)
 {
-    matrix<double> L;
-    matrix_resize(L, N + 1, N + 1);
-    matrix<double> D;
-    matrix_resize(D, N + 2, N + 2);
+    if (correlation.rows() != static_cast<std::size_t>(N + 1))
+        throw std::invalid_argument("IR::set_correlation: need one row per forward rate, N + 1");
 
-    std::vector<double> dW(N + 1);
-    std::vector<double> FV(N + 2);
+    rate_factors = CorrelatedNormals(correlation, method, factors);
+    ++correlation_version;
+}
 
-    std::vector<double> FVprime(N + 2);
+IR_results IR::run_LIBOR_simulations() const
+{
     std::vector<double> V(M);
 
-    SampleBoxMuller normal;
+    double spot_init = 0.05;
 
-    double df_prod = 1.;
-    double drift_sum = 0.;
-    double sumPV = 0.;
-    double PV = 0.;
+    // D[i][0]: discount factors of the initial curve
+    std::vector<double> D0(N + 2);
+    D0[0] = 1.;
+    for (int i = 1; i < N + 2; i++)
+        D0[i] = D0[i - 1] * (1 / (1 + alpha * spot_init));
 
-    double spot_init = 0.05;
+    // Caplet on column n: Black on the initial forward, fixing at n dT and
+    // paid at the next date. The swap is only simulated.
+    if (engine != PricingEngine::monte_carlo)
+    {
+        if (cap)
+        {
+            double value = 0.;
+            for (int n = 0; n < N + 1; n++)
+                value += black_caplet(spot_init, K, sigma, n * dT, D0[n + 1]);
+
+            IR_results results;
+            results.value = results.estimate.value = value;
+
+            return results;
+        }
+
+        if (engine == PricingEngine::analytic)
+            throw std::logic_error("IR::get_simulation_data: only caps have a closed form");
+    }
+
+    // The cap is discounted to today after averaging; the swap legs already are
+    double scale = cap ? D0[N + 1] : 1.;
 
-    for (int i = 0; i < N + 1; i++)
-        L[i][0] = spot_init;
+    CorrelatedNormals correlated = find_rate_factors();
 
-    dW[0] = 0.;
+    std::unique_ptr<SobolPaths> sobol;
+    if (sampling == SamplingMethod::sobol)
+        sobol = std::make_unique<SobolPaths>(N, correlated.factors(), seed);
 
-    for (int nsim = 0; nsim < M; nsim++)
+    if (scenarios)
+        scenarios->check(ScenarioEngine::IR, find_scenario_key(correlated), "IR::get_simulation_data");
+
+    RateFixingStore *store = nullptr;
+    std::unique_lock<std::mutex> lock;
+    if (caching && !scenarios)
     {
-        for (int j = 1; j < N + 1; j++)
-            dW[j] = sqrt(dT) * normal();
+        std::size_t n_chunks = (static_cast<std::size_t>(M) + mc_chunk_paths - 1) / mc_chunk_paths;
+
+        lock = path_cache.lock();
+        store = &path_cache.fetch(path_key(alpha, sigma, dT, N, M, seed, sampling, correlation_version), [&](RateFixingStore &fresh)
+                                  {
+                                      fresh.fixing.resize(n_chunks);
+                                      fresh.deflator.resize(n_chunks); });
+    }
 
-        for (int n = 0; n < N; n++)
+    // Payment i = n + 1 fixes on column n and is worth FV D[n+1][n] / D[N+1][n];
+    // deflator holds D[N+1][n] / D[n+1][n]
+    auto add_payment = [&](int n, const double *L_n, const double *deflator, double *value, std::size_t n_paths)
+    {
+        WAB_TIME_SCOPE("ir.payoff");
+
+        for (std::size_t p = 0; p < n_paths; ++p)
         {
-            for (int i = n + 1; i < N + 1; i++)
-            {
-                drift_sum = 0.;
-                for (int k = i + 1; k < N + 1; k++)
-                    drift_sum += (alpha * sigma * L[k][n]) / (1 + alpha * L[k][n]);
+            if (cap)
+                value[p] += std::max(L_n[p] - K, 0.) / deflator[p];
+
+            else
+                value[p] += notional * alpha * (L_n[p] - K) / deflator[p] * D0[n + 1];
+        }
+    };
+
+    // Stored fixings, from a scenario file or the cache, are read in place
+    auto simulate_chunk = [&](std::size_t chunk, std::size_t begin, std::size_t end)
+    {
+        std::size_t n_paths = end - begin;
+        std::vector<double> value(n_paths);
+        std::vector<double> simulated_fixing, simulated_deflator;
+        const double *fixing = nullptr, *deflator = nullptr;
+
+        WAB_COUNT("ir.paths", n_paths);
 
-                L[i][n + 1] = L[i][n] * exp((-drift_sum * sigma - 0.5 * sigma * sigma) * dT + sigma * dW[n + 1]);
+        if (scenarios)
+        {
+            WAB_COUNT("ir.scenario_paths", n_paths);
+
+            fixing = scenarios->chunk("fixing", chunk);
+            deflator = scenarios->chunk("deflator", chunk);
+        }
+
+        else if (store && !store->fixing[chunk].empty())
+        {
+            WAB_COUNT("ir.cached_paths", n_paths);
+
+            fixing = store->fixing[chunk].data();
+            deflator = store->deflator[chunk].data();
+        }
+
+        else
+        {
+            simulated_fixing.resize((N + 1) * n_paths);
+            simulated_deflator.resize(simulated_fixing.size());
+            simulate_fixings(correlated, sobol.get(), chunk, begin, n_paths, simulated_fixing.data(), simulated_deflator.data());
+
+            // Each chunk is written by the one thread simulating it
+            if (store)
+            {
+                store->fixing[chunk] = simulated_fixing;
+                store->deflator[chunk] = simulated_deflator;
             }
+
+            fixing = simulated_fixing.data();
+            deflator = simulated_deflator.data();
         }
 
         for (int n = 0; n < N + 1; n++)
+            add_payment(n, &fixing[n * n_paths], &deflator[n * n_paths], value.data(), n_paths);
+
+        RunningStats stats;
+        for (std::size_t p = 0; p < n_paths; ++p)
+        {
+            V[begin + p] = value[p];
+            stats.add(value[p]);
+        }
+
+        return stats;
+    };
+
+    MCEstimate estimate;
+    if (sobol)
+        estimate = sobol_estimate(M, threads, target_error, scale, simulate_chunk);
+
+    else
+    {
+        auto error = [&](const RunningStats &stats)
+        { return scale * stats.standard_error(); };
+
+        estimate = merge_chunks_to_target<RunningStats>(M, mc_chunk_paths, threads, target_error, simulate_chunk, error)
+                       .estimate(scale);
+    }
+
+    // Chunks merge in order, so the simulated paths are a prefix of V
+    V.resize(estimate.samples);
+
+    IR_results results(V, estimate.value);
+    results.estimate = estimate;
+
+    return results;
+}
+
+CorrelatedNormals IR::find_rate_factors() const
+{
+    // The one-factor model loads every rate fully on a single factor
+    if (rate_factors.empty())
+        return CorrelatedNormals::from_loadings(matrix<double>(N + 1, 1, matrix_layout::row_major, 1.));
+
+    return rate_factors;
+}
+
+std::vector<double> IR::find_scenario_key(const CorrelatedNormals &correlated) const
+{
+    std::vector<double> key = scenario_key({alpha, sigma, dT, static_cast<double>(N), static_cast<double>(M),
+                                            static_cast<double>(sampling), static_cast<double>(correlated.factors())},
+                                           seed);
+
+    const matrix<double> &loadings = correlated.loadings();
+    for (std::size_t k = 0; k < loadings.rows(); ++k)
+        for (std::size_t f = 0; f < loadings.cols(); ++f)
+            key.push_back(loadings(k, f));
+
+    return key;
+}
+
+// A chunk's paths advance together, rates stored rate-major as
+// L[k * n_paths + p], keeping only the current column of the forward-rate
+// surface. On column n one sweep from k = N down to n + 1 builds each path's
+// drift of rate k, sum over k' > k of rho_kk' alpha sigma L[k'] /
+// (1 + alpha L[k']), through per-factor sums (rho = A A^T), and the product
+// of 1 / (1 + alpha L[k]); rate k is evolved as soon as its drift is known.
+// That is O(N F) per column. Column n leaves the fixing L_n and the deflator
+// of the payment it fixes.
+void IR::simulate_fixings(const CorrelatedNormals &correlated, const SobolPaths *sobol, std::size_t chunk, std::size_t begin,
+                          std::size_t n_paths, double *fixing, double *deflator) const
+{
+    // Copies, so that the compiler need not reload them after every store
+    // through fixing and deflator
+    const double alpha = this->alpha, sigma = this->sigma, dT = this->dT;
+
+    double spot_init = 0.05;
+    double sqrt_dT = std::sqrt(dT);
+    double log_growth = -0.5 * sigma * sigma * dT;
+
+    std::size_t n_factors = correlated.factors();
+    const matrix<double> &loadings = correlated.loadings();
+
+    std::vector<double> L((N + 1) * n_paths, spot_init);
+    std::vector<double> dZ(N * n_factors * n_paths), dW((N + 1) * n_paths);
+    std::vector<double> factor_drift(n_factors * n_paths);
+    std::vector<double> drift(n_paths), term(n_paths);
+
+    WAB_COUNT("ir.steps", static_cast<std::uint64_t>(N) * n_paths);
+
+    // dZ[(n * n_factors + f) * n_paths + p]: factor f of path p over step n
+    {
+        WAB_TIME_SCOPE("ir.normals");
+
+        if (sobol)
+            sobol->chunk_increments(chunk, n_paths, dZ.data());
+
+        else
         {
-            for (int i = n + 1; i < N + 2; i++)
+            std::vector<double> z(N * n_factors);
+            for (std::size_t p = 0; p < n_paths; ++p)
             {
-                df_prod = 1.;
-                for (int k = n; k < i; k++)
-                {
-                    df_prod *= 1 / (1 + alpha * L[k][n]);
-                }
+                NormalGenerator normal(seed, begin + p);
+                normal.fill(z.data(), z.size());
 
-                D[i][n] = df_prod;
+                for (std::size_t j = 0; j < z.size(); j++)
+                    dZ[j * n_paths + p] = z[j];
             }
         }
 
-        double diff(0.);
-        V[nsim] = 0.;
+        for (auto &increment : dZ)
+            increment *= sqrt_dT;
+    }
 
-        for (int i = 1; i < N + 2; i++)
+    for (int n = 0; n < N + 1; n++)
+    {
+        double *df_prod = &deflator[n * n_paths];
+
+        std::fill(factor_drift.begin(), factor_drift.end(), 0.);
+        std::fill_n(df_prod, n_paths, 1.);
+
+        // dW[k * n_paths + p]: increment of rate k over step n
+        if (n < N)
         {
+            WAB_TIME_SCOPE("ir.correlate");
+            correlated.apply(&dZ[n * n_factors * n_paths], dW.data(), n_paths);
+        }
 
-            if (cap)
-            {
-                diff = L[i - 1][i - 1] - K;
-                FV[i] = std::max(diff, 0.);
-            }
+        // The deflators are accumulated in the same sweep as the rates
+        WAB_TIME_SCOPE("ir.evolve");
 
-            else
+        for (int k = N; k > n; k--)
+        {
+            double *L_k = &L[k * n_paths];
+            const double *dW_k = &dW[k * n_paths];
+
+            std::fill(drift.begin(), drift.end(), 0.);
+            for (std::size_t f = 0; f < n_factors; f++)
             {
-                diff = notional * alpha * (L[i - 1][i - 1] - K);
-                FV[i] = diff;
-            }
+                double a = loadings(k, f);
+                const double *sum = &factor_drift[f * n_paths];
 
-            FVprime[i] = FV[i] * D[i][i - 1] / D[N + 1][i - 1];
+                for (std::size_t p = 0; p < n_paths; ++p)
+                    drift[p] += a * sum[p];
+            }
 
-            if (cap)
+            for (std::size_t p = 0; p < n_paths; ++p)
             {
-                V[nsim] += FVprime[i];
+                double inverse = 1 / (1 + alpha * L_k[p]);
+                term[p] = alpha * sigma * L_k[p] * inverse;
+
+                df_prod[p] *= inverse;
+                L_k[p] *= std::exp(-drift[p] * sigma * dT + (log_growth + sigma * dW_k[p]));
             }
 
-            else
+            for (std::size_t f = 0; f < n_factors; f++)
             {
-                V[nsim] += FVprime[i] * D[i][0];
+                double a = loadings(k, f);
+                double *sum = &factor_drift[f * n_paths];
+
+                for (std::size_t p = 0; p < n_paths; ++p)
+                    sum[p] += a * term[p];
             }
         }
+
+        std::copy_n(&L[n * n_paths], n_paths, &fixing[n * n_paths]);
     }
+}
+
+void IR::write_scenarios(const std::string &path) const
+{
+    CorrelatedNormals correlated = find_rate_factors();
 
-    sumPV = 0.;
+    std::unique_ptr<SobolPaths> sobol;
+    if (sampling == SamplingMethod::sobol)
+        sobol = std::make_unique<SobolPaths>(N, correlated.factors(), seed);
 
-    for (int nsim = 0; nsim < M; nsim++)
-        sumPV += V[nsim];
+    ScenarioWriter writer(path, ScenarioEngine::IR, find_scenario_key(correlated), M, 0);
+    std::size_t fixing_id = writer.declare("fixing", N + 1);
+    std::size_t deflator_id = writer.declare("deflator", N + 1);
 
-    if (cap)
+    struct chunk_fixings
     {
-        PV = D[N + 1][0] * sumPV / M;
-    }
-    else
+        std::vector<double> fixing, deflator;
+    };
+
+    auto simulate_chunk = [&](std::size_t chunk, std::size_t begin, std::size_t end)
     {
-        PV = sumPV / M;
-    }
+        std::size_t n_paths = end - begin;
+        WAB_COUNT("ir.paths", n_paths);
+
+        chunk_fixings result;
+        result.fixing.resize((N + 1) * n_paths);
+        result.deflator.resize(result.fixing.size());
+        simulate_fixings(correlated, sobol.get(), chunk, begin, n_paths, result.fixing.data(), result.deflator.data());
+
+        return result;
+    };
+
+    stream_chunks<chunk_fixings>(M, mc_chunk_paths, threads, simulate_chunk, [&](std::size_t chunk, const chunk_fixings &result)
+                                 {
+                                     writer.append(fixing_id, chunk, result.fixing.data());
+                                     writer.append(deflator_id, chunk, result.deflator.data()); });
+
+    writer.close();
+}
+
+void write_datapoints(GridWriter &writer, const IR_results &results)
+{
+    writer.write("datapoints", results.datapoints);
+    writer.write("value", results.value);
+    writer.write("estimate", results.estimate.value);
+    writer.write("standard_error", results.estimate.standard_error);
+    writer.write("samples", static_cast<double>(results.estimate.samples));
+}
+
+IR_results read_datapoints(const GridReader &reader)
+{
+    std::vector<double> datapoints = reader.read_vector("datapoints");
 
-    IR_results results(V, PV);
+    IR_results results(datapoints, reader.read_scalar("value"));
+    results.estimate.value = reader.read_scalar("estimate");
+    results.estimate.standard_error = reader.read_scalar("standard_error");
+    results.estimate.samples = static_cast<std::size_t>(reader.read_scalar("samples"));
 
     return results;
-}
\ No newline at end of file
+}
@@ -0,0 +1,156 @@
+#include "scenario.hpp"
+#include "parallel.hpp"
+#include "variance_reduction.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+std::vector<double> scenario_key(std::initializer_list<double> inputs, std::uint64_t seed)
+{
+    std::vector<double> key(inputs);
+    key.push_back(static_cast<double>(seed >> 32));
+    key.push_back(static_cast<double>(seed & 0xffffffffu));
+
+    return key;
+}
+
+ScenarioWriter::ScenarioWriter(const std::string &path, ScenarioEngine engine, const std::vector<double> &key,
+                               std::size_t paths, unsigned variance_reduction)
+    : writer(path)
+{
+    std::size_t n_chunks = (paths + mc_chunk_paths - 1) / mc_chunk_paths;
+    std::vector<double> chunk_sizes(n_chunks);
+    for (std::size_t c = 0; c < n_chunks; ++c)
+    {
+        std::size_t begin = c * mc_chunk_paths;
+        paths_per_chunk.push_back(vr_chunk_paths(std::min(paths, begin + mc_chunk_paths) - begin, variance_reduction));
+        chunk_sizes[c] = static_cast<double>(paths_per_chunk[c]);
+        slice_paths = std::max(slice_paths, paths_per_chunk[c]);
+    }
+
+    writer.write("engine", static_cast<double>(engine));
+    writer.write("key", key);
+    writer.write("paths", static_cast<double>(paths));
+    writer.write("chunk_paths", chunk_sizes);
+
+    writer.set_alignment(scenario_alignment);
+}
+
+std::size_t ScenarioWriter::declare(const std::string &name, std::size_t values)
+{
+    std::size_t id = writer.declare(name, values * slice_paths);
+    values_per_path.resize(id + 1);
+    values_per_path[id] = values;
+
+    return id;
+}
+
+void ScenarioWriter::append(std::size_t id, std::size_t chunk, const double *values)
+{
+    if (id >= values_per_path.size() || values_per_path[id] == 0 || chunk >= paths_per_chunk.size())
+        throw std::invalid_argument("ScenarioWriter::append: no such array or chunk");
+
+    std::size_t n = values_per_path[id] * paths_per_chunk[chunk];
+    std::size_t slice = values_per_path[id] * slice_paths;
+    if (n == slice)
+    {
+        writer.append(id, values);
+        return;
+    }
+
+    padded.assign(slice, 0.);
+    std::copy_n(values, n, padded.begin());
+    writer.append(id, padded.data());
+}
+
+void ScenarioWriter::close()
+{
+    writer.close();
+}
+
+ScenarioSet::ScenarioSet(const std::string &path) : grid(path)
+{
+    for (const char *name : {"engine", "key", "paths", "chunk_paths"})
+        if (!grid.contains(name))
+            throw std::runtime_error("ScenarioSet: " + path + " is not a scenario file");
+
+    auto corrupt = [&](const std::string &reason)
+    {
+        return std::runtime_error("ScenarioSet: " + path + " is corrupt: " + reason);
+    };
+
+    // Header values are stored as doubles; counts must be whole and in range
+    auto whole = [](double value, double lowest, double highest)
+    {
+        return value >= lowest && value <= highest && value == std::floor(value);
+    };
+
+    const GridArrayInfo &engine_info = grid.info("engine"), &paths_info = grid.info("paths");
+    if (engine_info.rows * engine_info.cols != 1 || paths_info.rows * paths_info.cols != 1)
+        throw corrupt("engine and paths must be single values");
+
+    double engine = grid.read_scalar("engine"), paths = grid.read_scalar("paths");
+    if (!whole(engine, static_cast<double>(ScenarioEngine::EQ1), static_cast<double>(ScenarioEngine::IR)))
+        throw corrupt("unknown engine");
+    if (!whole(paths, 1, 9007199254740992.))
+        throw corrupt("paths must be a positive count");
+
+    written_by = static_cast<ScenarioEngine>(engine);
+    inputs = grid.read_vector("key");
+    n_paths = static_cast<std::size_t>(paths);
+
+    // One chunk per mc_chunk_paths paths, each holding its share of paths,
+    // rounded up by one for antithetic pairs, and none larger than chunk 0
+    std::vector<double> chunk_sizes = grid.read_vector("chunk_paths");
+    if (chunk_sizes.size() != (n_paths + mc_chunk_paths - 1) / mc_chunk_paths)
+        throw corrupt("chunk_paths must have one entry per chunk of paths");
+
+    for (std::size_t c = 0; c < chunk_sizes.size(); ++c)
+    {
+        std::size_t begin = c * mc_chunk_paths;
+        double share = static_cast<double>(std::min(n_paths, begin + mc_chunk_paths) - begin);
+        if (!whole(chunk_sizes[c], share, share + 1) || (c && chunk_sizes[c] > chunk_sizes[0]))
+            throw corrupt("chunk " + std::to_string(c) + " does not match the number of paths");
+
+        paths_per_chunk.push_back(static_cast<std::size_t>(chunk_sizes[c]));
+    }
+
+    // Path arrays hold a whole number of values per path of chunk 0 in one
+    // mappable slice per chunk
+    for (const auto &array : grid.arrays())
+    {
+        if (array.name == "engine" || array.name == "key" || array.name == "paths" || array.name == "chunk_paths")
+            continue;
+
+        if (array.cols != chunks() || array.rows == 0 || array.rows % paths_per_chunk[0] != 0 ||
+            array.codec != GridCodec::none || array.dtype != GridDtype::float64)
+            throw corrupt("array " + array.name + " does not hold one float64 slice per chunk");
+    }
+}
+
+const double *ScenarioSet::chunk(const std::string &name, std::size_t chunk) const
+{
+    if (chunk >= chunks())
+        throw std::invalid_argument("ScenarioSet::chunk: no chunk " + std::to_string(chunk));
+
+    return grid.slice(name, chunk);
+}
+
+std::size_t ScenarioSet::chunk_values(const std::string &name, std::size_t chunk) const
+{
+    if (chunk >= chunks())
+        throw std::invalid_argument("ScenarioSet::chunk_values: no chunk " + std::to_string(chunk));
+
+    // Chunk 0 is always a full slice
+    return grid.info(name).rows / paths_per_chunk[0] * paths_per_chunk[chunk];
+}
+
+void ScenarioSet::check(ScenarioEngine engine, const std::vector<double> &key, const std::string &caller) const
+{
+    if (engine != written_by)
+        throw std::invalid_argument(caller + ": the scenarios were written by another engine");
+
+    if (key != inputs)
+        throw std::invalid_argument(caller + ": the scenarios were simulated with other inputs");
+}
@@ -0,0 +1,50 @@
+#include "simd.hpp"
+#include <atomic>
+
+namespace
+{
+    std::atomic<int> simd_level_limit{static_cast<int>(SimdLevel::avx512)};
+
+    SimdLevel probe_simd_level()
+    {
+#if defined(WAB_SIMD_X86)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f"))
+            return SimdLevel::avx512;
+        if (__builtin_cpu_supports("avx2"))
+            return SimdLevel::avx2;
+#endif
+        return SimdLevel::scalar;
+    }
+}
+
+SimdLevel detected_simd_level()
+{
+    static const SimdLevel level = probe_simd_level();
+    return level;
+}
+
+SimdLevel active_simd_level()
+{
+    int limit = simd_level_limit.load(std::memory_order_relaxed);
+    int detected = static_cast<int>(detected_simd_level());
+    return static_cast<SimdLevel>(limit < detected ? limit : detected);
+}
+
+void set_simd_level(SimdLevel level)
+{
+    simd_level_limit.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+const char *simd_level_name(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::avx2:
+        return "avx2";
+    case SimdLevel::avx512:
+        return "avx512";
+    default:
+        return "scalar";
+    }
+}
@@ -0,0 +1,62 @@
+#include "simd_kernels.hpp"
+
+#if defined(WAB_SIMD_X86)
+#include <immintrin.h>
+
+namespace
+{
+    struct Avx2Lanes
+    {
+        using D = __m256d;
+        using U = __m256i;
+        using Mask = __m256d;
+        static constexpr std::size_t width = 4;
+
+        static D load(const double *p) { return _mm256_loadu_pd(p); }
+        static void store(double *p, D v) { _mm256_storeu_pd(p, v); }
+        static D set(double v) { return _mm256_set1_pd(v); }
+        static U set_u(std::uint64_t v) { return _mm256_set1_epi64x(static_cast<long long>(v)); }
+        static U iota_u(std::uint64_t first) { return _mm256_add_epi64(set_u(first), _mm256_setr_epi64x(0, 1, 2, 3)); }
+
+        static D add(D a, D b) { return _mm256_add_pd(a, b); }
+        static D sub(D a, D b) { return _mm256_sub_pd(a, b); }
+        static D mul(D a, D b) { return _mm256_mul_pd(a, b); }
+        static D div(D a, D b) { return _mm256_div_pd(a, b); }
+        static D sqrt(D a) { return _mm256_sqrt_pd(a); }
+
+        static U mul32(U a, U b) { return _mm256_mul_epu32(a, b); }
+        template <int Shift>
+        static U shr(U a) { return _mm256_srli_epi64(a, Shift); }
+        template <int Shift>
+        static U shl(U a) { return _mm256_slli_epi64(a, Shift); }
+        static U band(U a, U b) { return _mm256_and_si256(a, b); }
+        static U bor(U a, U b) { return _mm256_or_si256(a, b); }
+        static U bxor(U a, U b) { return _mm256_xor_si256(a, b); }
+
+        static D as_double(U a) { return _mm256_castsi256_pd(a); }
+        static U as_bits(D a) { return _mm256_castpd_si256(a); }
+
+        static Mask gt(D a, D b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+        static Mask eq(D a, D b) { return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+        static D select(Mask m, D a, D b) { return _mm256_blendv_pd(b, a, m); }
+    };
+}
+
+void box_muller_pairs_avx2(std::uint64_t first_pair, std::uint64_t stream, std::uint64_t seed,
+                           std::size_t n_pairs, double *z0, double *z1)
+{
+    box_muller_pairs_lanes<Avx2Lanes>(first_pair, stream, seed, n_pairs, z0, z1);
+}
+
+void gbm_step_avx2(double *S, const double *eps, std::size_t n, double growth, double vol)
+{
+    gbm_step_lanes<Avx2Lanes>(S, eps, n, growth, vol);
+}
+
+void cds_legs_avx2(const double *discount, const double *discount_accrual, const std::size_t *pattern,
+                   std::size_t n_periods, const double *step, std::size_t n_trades, double *premium, double *protection)
+{
+    cds_legs_lanes<Avx2Lanes>(discount, discount_accrual, pattern, n_periods, step, n_trades, premium, protection);
+}
+
+#endif
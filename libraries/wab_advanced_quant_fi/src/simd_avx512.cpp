@@ -0,0 +1,68 @@
+#include "simd_kernels.hpp"
+
+#if defined(WAB_SIMD_X86)
+#include <immintrin.h>
+
+namespace
+{
+    struct Avx512Lanes
+    {
+        using D = __m512d;
+        using U = __m512i;
+        using Mask = __mmask8;
+        static constexpr std::size_t width = 8;
+
+        // GCC's unmasked sqrt, mul_epu32 and 64-bit shifts pass an
+        // _mm512_undefined_* source that -Wuninitialized reports once
+        // inlined; the zero-masked forms with every lane selected are the
+        // same instructions.
+        static constexpr Mask all = 0xFF;
+
+        static D load(const double *p) { return _mm512_loadu_pd(p); }
+        static void store(double *p, D v) { _mm512_storeu_pd(p, v); }
+        static D set(double v) { return _mm512_set1_pd(v); }
+        static U set_u(std::uint64_t v) { return _mm512_set1_epi64(static_cast<long long>(v)); }
+        static U iota_u(std::uint64_t first) { return _mm512_add_epi64(set_u(first), _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0)); }
+
+        static D add(D a, D b) { return _mm512_add_pd(a, b); }
+        static D sub(D a, D b) { return _mm512_sub_pd(a, b); }
+        static D mul(D a, D b) { return _mm512_mul_pd(a, b); }
+        static D div(D a, D b) { return _mm512_div_pd(a, b); }
+        static D sqrt(D a) { return _mm512_maskz_sqrt_pd(all, a); }
+
+        static U mul32(U a, U b) { return _mm512_maskz_mul_epu32(all, a, b); }
+        template <int Shift>
+        static U shr(U a) { return _mm512_maskz_srli_epi64(all, a, Shift); }
+        template <int Shift>
+        static U shl(U a) { return _mm512_maskz_slli_epi64(all, a, Shift); }
+        static U band(U a, U b) { return _mm512_and_si512(a, b); }
+        static U bor(U a, U b) { return _mm512_or_si512(a, b); }
+        static U bxor(U a, U b) { return _mm512_xor_si512(a, b); }
+
+        static D as_double(U a) { return _mm512_castsi512_pd(a); }
+        static U as_bits(D a) { return _mm512_castpd_si512(a); }
+
+        static Mask gt(D a, D b) { return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ); }
+        static Mask eq(D a, D b) { return _mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ); }
+        static D select(Mask m, D a, D b) { return _mm512_mask_blend_pd(m, b, a); }
+    };
+}
+
+void box_muller_pairs_avx512(std::uint64_t first_pair, std::uint64_t stream, std::uint64_t seed,
+                             std::size_t n_pairs, double *z0, double *z1)
+{
+    box_muller_pairs_lanes<Avx512Lanes>(first_pair, stream, seed, n_pairs, z0, z1);
+}
+
+void gbm_step_avx512(double *S, const double *eps, std::size_t n, double growth, double vol)
+{
+    gbm_step_lanes<Avx512Lanes>(S, eps, n, growth, vol);
+}
+
+void cds_legs_avx512(const double *discount, const double *discount_accrual, const std::size_t *pattern,
+                     std::size_t n_periods, const double *step, std::size_t n_trades, double *premium, double *protection)
+{
+    cds_legs_lanes<Avx512Lanes>(discount, discount_accrual, pattern, n_periods, step, n_trades, premium, protection);
+}
+
+#endif
@@ -0,0 +1,268 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Kernels shared by the scalar, AVX2 and AVX-512 translation units. Each
+// algorithm is written once against a "lanes" type that supplies the
+// arithmetic, so every instruction set performs the same IEEE operations in
+// the same order and returns bit-identical results. The transcendental
+// functions are evaluated with our own polynomials rather than libm for the
+// same reason.
+//
+// Everything lives in an unnamed namespace: the translation units are built
+// with different -m flags and must not share inline definitions.
+
+namespace
+{
+    struct ScalarLanes
+    {
+        using D = double;
+        using U = std::uint64_t;
+        using Mask = bool;
+        static constexpr std::size_t width = 1;
+
+        static D load(const double *p) { return *p; }
+        static void store(double *p, D v) { *p = v; }
+        static D set(double v) { return v; }
+        static U set_u(std::uint64_t v) { return v; }
+        static U iota_u(std::uint64_t first) { return first; }
+
+        static D add(D a, D b) { return a + b; }
+        static D sub(D a, D b) { return a - b; }
+        static D mul(D a, D b) { return a * b; }
+        static D div(D a, D b) { return a / b; }
+        static D sqrt(D a) { return std::sqrt(a); }
+
+        static U mul32(U a, U b) { return (a & 0xFFFFFFFFu) * (b & 0xFFFFFFFFu); }
+        template <int Shift>
+        static U shr(U a) { return a >> Shift; }
+        template <int Shift>
+        static U shl(U a) { return a << Shift; }
+        static U band(U a, U b) { return a & b; }
+        static U bor(U a, U b) { return a | b; }
+        static U bxor(U a, U b) { return a ^ b; }
+
+        static D as_double(U a)
+        {
+            D d;
+            std::memcpy(&d, &a, sizeof d);
+            return d;
+        }
+        static U as_bits(D a)
+        {
+            U u;
+            std::memcpy(&u, &a, sizeof u);
+            return u;
+        }
+
+        static Mask gt(D a, D b) { return a > b; }
+        static Mask eq(D a, D b) { return a == b; }
+        static D select(Mask m, D a, D b) { return m ? a : b; }
+    };
+
+    constexpr std::uint64_t lane_mask32 = 0xFFFFFFFFu;
+    constexpr std::uint32_t kernel_philox_m0 = 0xD2511F53, kernel_philox_m1 = 0xCD9E8D57;
+    constexpr std::uint32_t kernel_philox_w0 = 0x9E3779B9, kernel_philox_w1 = 0xBB67AE85;
+
+    constexpr double kernel_two_pi = 6.283185307179586476925286766559;
+    constexpr double kernel_sqrt2 = 1.4142135623730950488016887242097;
+    constexpr double kernel_ln2_hi = 6.93147180369123816490e-01;
+    constexpr double kernel_ln2_lo = 1.90821492927058770002e-10;
+
+    // Philox4x32-10 on counters held in the low 32 bits of 64-bit lanes.
+    template <class L>
+    inline void philox_lanes(typename L::U ctr[4], std::uint64_t seed)
+    {
+        using U = typename L::U;
+
+        std::uint32_t k0 = static_cast<std::uint32_t>(seed), k1 = static_cast<std::uint32_t>(seed >> 32);
+        const U mask = L::set_u(lane_mask32);
+
+        for (int round = 0; round < 10; ++round)
+        {
+            U p0 = L::mul32(ctr[0], L::set_u(kernel_philox_m0));
+            U p1 = L::mul32(ctr[2], L::set_u(kernel_philox_m1));
+
+            U n0 = L::bxor(L::bxor(L::template shr<32>(p1), ctr[1]), L::set_u(k0));
+            U n2 = L::bxor(L::bxor(L::template shr<32>(p0), ctr[3]), L::set_u(k1));
+
+            ctr[0] = n0;
+            ctr[1] = L::band(p1, mask);
+            ctr[2] = n2;
+            ctr[3] = L::band(p0, mask);
+
+            k0 += kernel_philox_w0;
+            k1 += kernel_philox_w1;
+        }
+    }
+
+    // 52 random bits -> uniform on the open interval (0, 1).
+    template <class L>
+    inline typename L::D open_uniform_lanes(typename L::U lo, typename L::U hi)
+    {
+        auto bits = L::template shr<12>(L::bor(L::template shl<32>(hi), lo));
+        auto whole = L::sub(L::as_double(L::bor(bits, L::set_u(0x4330000000000000u))), L::set(0x1p52));
+        return L::mul(L::add(whole, L::set(0.5)), L::set(0x1p-52));
+    }
+
+    // Natural log for 0 < u < 1 via log(m) = 2 atanh((m - 1) / (m + 1)).
+    template <class L>
+    inline typename L::D log_lanes(typename L::D u)
+    {
+        using D = typename L::D;
+
+        auto bits = L::as_bits(u);
+        D m = L::as_double(L::bor(L::band(bits, L::set_u(0x000FFFFFFFFFFFFFu)), L::set_u(0x3FF0000000000000u)));
+        D e = L::sub(L::as_double(L::bor(L::template shr<52>(bits), L::set_u(0x4330000000000000u))), L::set(0x1p52 + 1023.));
+
+        auto big = L::gt(m, L::set(kernel_sqrt2));
+        m = L::select(big, L::mul(m, L::set(0.5)), m);
+        e = L::add(e, L::select(big, L::set(1.), L::set(0.)));
+
+        D f = L::div(L::sub(m, L::set(1.)), L::add(m, L::set(1.)));
+        D z = L::mul(f, f);
+
+        D poly = L::set(1. / 23.);
+        for (int k = 10; k >= 0; --k)
+            poly = L::add(L::set(1. / (2 * k + 1)), L::mul(z, poly));
+
+        D log_m = L::mul(L::add(f, f), poly);
+
+        return L::add(L::mul(e, L::set(kernel_ln2_hi)), L::add(L::mul(e, L::set(kernel_ln2_lo)), log_m));
+    }
+
+    // sin and cos of 2 pi t for 0 < t < 1, reduced to |x| <= pi / 4.
+    template <class L>
+    inline void sincos_two_pi_lanes(typename L::D t, typename L::D &sin_out, typename L::D &cos_out)
+    {
+        using D = typename L::D;
+
+        constexpr double sin_coeff[] = {1., -1. / 6., 1. / 120., -1. / 5040., 1. / 362880., -1. / 39916800.,
+                                        1. / 6227020800., -1. / 1307674368000., 1. / 355687428096000.};
+        constexpr double cos_coeff[] = {1., -1. / 2., 1. / 24., -1. / 720., 1. / 40320., -1. / 3628800.,
+                                        1. / 479001600., -1. / 87178291200., 1. / 20922789888000.,
+                                        -1. / 6402373705728000.};
+
+        D q = L::sub(L::add(L::mul(t, L::set(4.)), L::set(0x1p52)), L::set(0x1p52));
+        D x = L::mul(L::sub(t, L::mul(q, L::set(0.25))), L::set(kernel_two_pi));
+        D x2 = L::mul(x, x);
+
+        D ps = L::set(sin_coeff[8]);
+        for (int k = 7; k >= 0; --k)
+            ps = L::add(L::set(sin_coeff[k]), L::mul(x2, ps));
+        D s = L::mul(x, ps);
+
+        D c = L::set(cos_coeff[9]);
+        for (int k = 8; k >= 0; --k)
+            c = L::add(L::set(cos_coeff[k]), L::mul(x2, c));
+
+        D neg_s = L::mul(s, L::set(-1.)), neg_c = L::mul(c, L::set(-1.));
+        auto q1 = L::eq(q, L::set(1.)), q2 = L::eq(q, L::set(2.)), q3 = L::eq(q, L::set(3.));
+
+        sin_out = L::select(q1, c, L::select(q2, neg_s, L::select(q3, neg_c, s)));
+        cos_out = L::select(q1, neg_s, L::select(q2, neg_c, L::select(q3, s, c)));
+    }
+
+    // Box-Muller normal pairs for Philox blocks first_pair .. first_pair + width - 1.
+    template <class L>
+    inline void box_muller_block(std::uint64_t first_pair, std::uint64_t stream, std::uint64_t seed,
+                                 double *z0, double *z1)
+    {
+        using D = typename L::D;
+        using U = typename L::U;
+
+        U index = L::iota_u(first_pair);
+        U ctr[4] = {L::band(index, L::set_u(lane_mask32)), L::template shr<32>(index),
+                    L::set_u(stream & lane_mask32), L::set_u(stream >> 32)};
+
+        philox_lanes<L>(ctr, seed);
+
+        D u1 = open_uniform_lanes<L>(ctr[0], ctr[1]);
+        D u2 = open_uniform_lanes<L>(ctr[2], ctr[3]);
+
+        D radius = L::sqrt(L::mul(L::set(-2.), log_lanes<L>(u1)));
+        D s, c;
+        sincos_two_pi_lanes<L>(u2, s, c);
+
+        L::store(z0, L::mul(radius, c));
+        L::store(z1, L::mul(radius, s));
+    }
+
+    template <class L>
+    inline void box_muller_pairs_lanes(std::uint64_t first_pair, std::uint64_t stream, std::uint64_t seed,
+                                       std::size_t n_pairs, double *z0, double *z1)
+    {
+        std::size_t k = 0;
+        for (; k + L::width <= n_pairs; k += L::width)
+            box_muller_block<L>(first_pair + k, stream, seed, z0 + k, z1 + k);
+
+        for (; k < n_pairs; ++k)
+            box_muller_block<ScalarLanes>(first_pair + k, stream, seed, z0 + k, z1 + k);
+    }
+
+    template <class L>
+    inline void gbm_step_lanes(double *S, const double *eps, std::size_t n, double growth, double vol)
+    {
+        auto g = L::set(growth), v = L::set(vol);
+
+        std::size_t p = 0;
+        for (; p + L::width <= n; p += L::width)
+            L::store(S + p, L::mul(L::load(S + p), L::add(g, L::mul(v, L::load(eps + p)))));
+
+        for (; p < n; ++p)
+            S[p] = S[p] * (growth + vol * eps[p]);
+    }
+
+    // CDS legs of trades first .. first + width - 1 per unit notional:
+    // survival Q_j = Q_{j-1} step_j, premium += discount_accrual_j Q_j and
+    // protection += discount_j (Q_{j-1} - Q_j), with step_j read from row
+    // pattern[j] of the trade-contiguous step table.
+    template <class L>
+    inline void cds_legs_block(const double *discount, const double *discount_accrual, const std::size_t *pattern,
+                               std::size_t n_periods, const double *step, std::size_t n_trades, std::size_t first,
+                               double *premium, double *protection)
+    {
+        using D = typename L::D;
+
+        D survival = L::set(1.), premium_sum = L::set(0.), protection_sum = L::set(0.);
+
+        for (std::size_t j = 0; j < n_periods; ++j)
+        {
+            D next = L::mul(survival, L::load(step + pattern[j] * n_trades + first));
+            premium_sum = L::add(premium_sum, L::mul(L::set(discount_accrual[j]), next));
+            protection_sum = L::add(protection_sum, L::mul(L::set(discount[j]), L::sub(survival, next)));
+            survival = next;
+        }
+
+        L::store(premium + first, premium_sum);
+        L::store(protection + first, protection_sum);
+    }
+
+    template <class L>
+    inline void cds_legs_lanes(const double *discount, const double *discount_accrual, const std::size_t *pattern,
+                               std::size_t n_periods, const double *step, std::size_t n_trades,
+                               double *premium, double *protection)
+    {
+        std::size_t i = 0;
+        for (; i + L::width <= n_trades; i += L::width)
+            cds_legs_block<L>(discount, discount_accrual, pattern, n_periods, step, n_trades, i, premium, protection);
+
+        for (; i < n_trades; ++i)
+            cds_legs_block<ScalarLanes>(discount, discount_accrual, pattern, n_periods, step, n_trades, i, premium, protection);
+    }
+}
+
+void box_muller_pairs_avx2(std::uint64_t first_pair, std::uint64_t stream, std::uint64_t seed,
+                           std::size_t n_pairs, double *z0, double *z1);
+void box_muller_pairs_avx512(std::uint64_t first_pair, std::uint64_t stream, std::uint64_t seed,
+                             std::size_t n_pairs, double *z0, double *z1);
+
+void gbm_step_avx2(double *S, const double *eps, std::size_t n, double growth, double vol);
+void gbm_step_avx512(double *S, const double *eps, std::size_t n, double growth, double vol);
+
+void cds_legs_avx2(const double *discount, const double *discount_accrual, const std::size_t *pattern,
+                   std::size_t n_periods, const double *step, std::size_t n_trades, double *premium, double *protection);
+void cds_legs_avx512(const double *discount, const double *discount_accrual, const std::size_t *pattern,
+                     std::size_t n_periods, const double *step, std::size_t n_trades, double *premium, double *protection);
@@ -0,0 +1,49 @@
+#include "statistics.hpp"
+#include <cmath>
+#include <limits>
+
+double normal_quantile(double p)
+{
+    if (!(p > 0 && p < 1))
+        return p == 0 ? -std::numeric_limits<double>::infinity()
+                      : p == 1 ? std::numeric_limits<double>::infinity() : std::numeric_limits<double>::quiet_NaN();
+
+    static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                               1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                               6.680131188771972e+01, -1.328068155288572e+01};
+    static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                               -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+    static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                               3.754408661907416e+00};
+
+    const double p_low = 0.02425;
+    double x{};
+
+    if (p < p_low)
+    {
+        double q = std::sqrt(-2 * std::log(p));
+        x = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+            ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
+    }
+    else if (p <= 1 - p_low)
+    {
+        double q = p - 0.5;
+        double t = q * q;
+        x = (((((a[0] * t + a[1]) * t + a[2]) * t + a[3]) * t + a[4]) * t + a[5]) * q /
+            (((((b[0] * t + b[1]) * t + b[2]) * t + b[3]) * t + b[4]) * t + 1);
+    }
+    else
+    {
+        double q = std::sqrt(-2 * std::log1p(-p));
+        x = -(((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+            ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
+    }
+
+    // Halley step on Phi(x) - p; the tail uses erfc to keep relative accuracy
+    double e = x < 0 ? 0.5 * std::erfc(-x / std::sqrt(2.)) - p : -(0.5 * std::erfc(x / std::sqrt(2.)) - (1 - p));
+    const double sqrt_two_pi = 2.506628274631000502415765284811;
+    double u = e * sqrt_two_pi * std::exp(0.5 * x * x);
+
+    return x - u / (1 + 0.5 * x * u);
+}
@@ -0,0 +1,72 @@
+#include "variance_reduction.hpp"
+#include <cmath>
+
+std::size_t vr_chunk_paths(std::size_t n, unsigned variance_reduction)
+{
+    if (variance_reduction & vr_antithetic)
+        return n + n % 2;
+
+    return n;
+}
+
+void fill_step_normals(NormalGenerator &normal, double *eps, std::size_t n, unsigned variance_reduction)
+{
+    if (variance_reduction & vr_antithetic)
+    {
+        std::size_t half = n / 2;
+        normal.fill(eps, half);
+
+        for (std::size_t p = 0; p < half; ++p)
+            eps[half + p] = -eps[p];
+    }
+    else
+    {
+        normal.fill(eps, n);
+    }
+
+    if ((variance_reduction & vr_moment_matching) && n > 1)
+    {
+        double mean{};
+        for (std::size_t p = 0; p < n; ++p)
+            mean += eps[p];
+        mean /= n;
+
+        double sum_squares{};
+        for (std::size_t p = 0; p < n; ++p)
+            sum_squares += (eps[p] - mean) * (eps[p] - mean);
+
+        double inverse_sd = 1 / std::sqrt(sum_squares / (n - 1));
+        for (std::size_t p = 0; p < n; ++p)
+            eps[p] = (eps[p] - mean) * inverse_sd;
+    }
+}
+
+void add_path_samples(RunningStats &stats, const double *x, std::size_t n, unsigned variance_reduction)
+{
+    if (variance_reduction & vr_antithetic)
+    {
+        std::size_t half = n / 2;
+        for (std::size_t p = 0; p < half; ++p)
+            stats.add(0.5 * (x[p] + x[half + p]));
+    }
+    else
+    {
+        for (std::size_t p = 0; p < n; ++p)
+            stats.add(x[p]);
+    }
+}
+
+void add_path_samples(RunningCovariance &stats, const double *x, const double *y, std::size_t n, unsigned variance_reduction)
+{
+    if (variance_reduction & vr_antithetic)
+    {
+        std::size_t half = n / 2;
+        for (std::size_t p = 0; p < half; ++p)
+            stats.add(0.5 * (x[p] + x[half + p]), 0.5 * (y[p] + y[half + p]));
+    }
+    else
+    {
+        for (std::size_t p = 0; p < n; ++p)
+            stats.add(x[p], y[p]);
+    }
+}
@@ -12,6 +12,7 @@ Usage:
     python test_quantitative_finance.py
 """
 
+import math
 import sys
 from pathlib import Path
 
@@ -33,6 +34,33 @@ except ImportError as e:
     sys.exit(1)
 
 
+def fresh_and_cached(make):
+    """Return an uncached engine and a caching one built by the same factory"""
+    fresh, cached = make(), make()
+    cached.set_caching(True)
+    return fresh, cached
+
+
+def instrumentation_after(price):
+    """Reset the hot-path counters, run price() and return the report by name, or None when not instrumented"""
+    qf.reset_instrumentation()
+    price()
+    report = {record.name: record for record in qf.instrumentation_report()}
+    if not qf.instrumentation_enabled():
+        assert report == {}
+        return None
+    return report
+
+
+def written_and_replayed(make, path, *args):
+    """Return an engine that wrote its scenarios to path and a twin priced off that file"""
+    engine = make()
+    engine.write_scenarios(path, *args)
+    replayed = make()
+    replayed.set_scenarios(qf.ScenarioSet(path))
+    return engine, replayed
+
+
 class TestEquityOptions:
     """Test suite for Equity Options (mirrors apps/equities.cpp)"""
 
@@ -56,6 +84,497 @@ class TestEquityOptions:
         assert premium > 0
         print(f"EQ1 premium (custom params) = {premium}")
 
+    def test_eq1_seed_reproducibility(self):
+        """Test that EQ1 reproduces its premium exactly for a given seed"""
+        eq1 = qf.EQ1(1.0, 100.0, 100.0, 0.1, 0.05, 50, 2000)
+        eq1.set_seed(11)
+        first = eq1.get_premium()
+        second = eq1.get_premium()
+        eq1.set_seed(12)
+        other = eq1.get_premium()
+
+        assert first == second
+        assert first != other
+
+    def test_eq1_eq2_thread_count_invariance(self):
+        """Test that the premium is bit-identical for any thread count"""
+        eq1 = qf.EQ1(1.0, 100.0, 100.0, 0.1, 0.05, 50, 3000)
+        eq2 = qf.EQ2(1.0, 0.05, 120.0, 100.0, 0.1, 0.15, 0.5, 50, 3000)
+
+        premiums = []
+        for threads in (1, 2, 3, 0):
+            eq1.set_threads(threads)
+            eq2.set_threads(threads)
+            premiums.append((eq1.get_premium(), eq2.get_premium()))
+
+        assert all(p == premiums[0] for p in premiums)
+
+    def test_eq1_pricing_releases_the_gil(self):
+        """Test that Python threads keep running while EQ1 prices, and threaded pricing matches serial runs"""
+        import threading
+        import time
+        from concurrent.futures import ThreadPoolExecutor
+
+        ticks = []
+        stop = threading.Event()
+
+        def tick():
+            while not stop.is_set():
+                ticks.append(time.perf_counter())
+                time.sleep(0.001)
+
+        option = qf.EQ1(1.0, 100.0, 100.0, 0.2, 0.05, 252, 200000)
+        ticker = threading.Thread(target=tick)
+        ticker.start()
+        start = time.perf_counter()
+        option.get_premium()
+        end = time.perf_counter()
+        stop.set()
+        ticker.join()
+
+        # A call holding the GIL would stall the ticker from start to end
+        during = [start] + [t for t in ticks if start < t < end] + [end]
+        longest_gap = max(b - a for a, b in zip(during, during[1:]))
+        assert len(during) > 2 and longest_gap < 0.5 * (end - start)
+
+        options = [qf.EQ1(1.0, K, 100.0, 0.2, 0.05, 50, 20000) for K in (90.0, 100.0, 110.0, 120.0)]
+        serial = [option.get_premium() for option in options]
+
+        with ThreadPoolExecutor(max_workers=4) as pool:
+            concurrent = list(pool.map(lambda option: option.get_premium(), options))
+
+        assert concurrent == serial
+        print(f"GIL release - ticker ran {len(during) - 2} times during a {end - start:.3f}s pricing call")
+
+    def test_simd_levels_bit_identical(self):
+        """Test that every SIMD level gives the same premium"""
+        eq1 = qf.EQ1(1.0, 100.0, 100.0, 0.1, 0.05, 50, 3000)
+        cr1 = qf.CR1(4.0, 70.0, 100.0, 0.2, 0.05, 50, 3000)
+
+        best = qf.detected_simd_level()
+        results = []
+        for level in (qf.SimdLevel.scalar, qf.SimdLevel.avx2, qf.SimdLevel.avx512):
+            qf.set_simd_level(level)
+            results.append((eq1.get_premium(), cr1.get_payoff_and_defaults().equity_payoff))
+        qf.set_simd_level(best)
+
+        assert all(r == results[0] for r in results)
+
+    def test_eq1_payoffs(self):
+        """Test EQ1 with path-dependent payoffs"""
+        eq1 = qf.EQ1(1.0, 100.0, 100.0, 0.2, 0.05, 100, 5000)
+        call = eq1.get_premium()
+
+        eq1.set_payoff(qf.CallPayoff(100.0))
+        assert eq1.get_premium() == call
+
+        eq1.set_payoff(qf.UpAndOutCallPayoff(100.0, 130.0))
+        knock_out = eq1.get_premium()
+        eq1.set_payoff(qf.AsianCallPayoff(100.0))
+        asian = eq1.get_premium()
+        eq1.set_payoff(qf.LookbackCallPayoff())
+        lookback = eq1.get_premium()
+
+        assert 0 < knock_out < call
+        assert 0 < asian < call
+        assert lookback > call
+
+        eq1.set_payoff(None)
+        assert eq1.get_premium() == call
+
+    def test_eq1_greeks(self):
+        """Test single-pass Greeks against Black-Scholes and bump-and-reprice"""
+        from statistics import NormalDist
+
+        T, K, S0, sigma, r = 1.0, 100.0, 100.0, 0.1, 0.05
+        eq1 = qf.EQ1(T, K, S0, sigma, r, 100, 20000)
+        greeks = eq1.get_greeks()
+
+        assert abs(greeks.premium.value - eq1.get_premium()) < 1e-9
+
+        # Black-Scholes values, up to Monte Carlo and time-step error
+        d1 = (math.log(S0 / K) + (r + 0.5 * sigma ** 2) * T) / (sigma * math.sqrt(T))
+        d2 = d1 - sigma * math.sqrt(T)
+        N = NormalDist()
+        expected = {
+            'delta': N.cdf(d1),
+            'gamma': N.pdf(d1) / (S0 * sigma * math.sqrt(T)),
+            'vega': S0 * N.pdf(d1) * math.sqrt(T),
+            'rho': K * T * math.exp(-r * T) * N.cdf(d2),
+        }
+        for name, value in expected.items():
+            estimate = getattr(greeks, name)
+            assert estimate.standard_error > 0
+            assert abs(estimate.value - value) < 5 * estimate.standard_error + 0.01 * abs(value)
+
+        # Pathwise vega is the derivative of the simulated premium itself
+        h = 1e-5
+        up = qf.EQ1(T, K, S0, sigma + h, r, 100, 20000).get_premium()
+        down = qf.EQ1(T, K, S0, sigma - h, r, 100, 20000).get_premium()
+        assert abs(greeks.vega.value - (up - down) / (2 * h)) < 1e-3 * greeks.vega.value
+
+        # Greeks need a payoff of the terminal value
+        eq1.set_payoff(qf.AsianCallPayoff(K))
+        try:
+            eq1.get_greeks()
+            assert False, "expected ValueError"
+        except ValueError:
+            pass
+
+    def test_eq2_cr1_greeks(self):
+        """Test that EQ2 and CR1 Greeks agree with bump-and-reprice on the same paths"""
+        h = 1e-5
+        greeks = qf.EQ2().get_greeks()
+        up = qf.EQ2(1.0, 0.05 + h, 120.0, 100.0, 0.1, 0.15, 0.5, 300, 1000).get_premium()
+        down = qf.EQ2(1.0, 0.05 - h, 120.0, 100.0, 0.1, 0.15, 0.5, 300, 1000).get_premium()
+        assert abs(greeks.rho.value - (up - down) / (2 * h)) < 1e-4
+        assert greeks.delta1.value + greeks.delta2.value > 0
+
+        # rho = +-1 prices, but its likelihood-ratio gammas are undefined
+        for rho in (1.0, -1.0):
+            eq2 = qf.EQ2(1.0, 0.05, 120.0, 100.0, 0.1, 0.15, rho, 50, 1000)
+            assert eq2.get_premium() > 0
+            try:
+                eq2.get_greeks()
+                assert False, "expected ValueError"
+            except ValueError:
+                pass
+
+        cr1 = qf.CR1()
+        greeks = cr1.get_greeks()
+        assert abs(greeks.premium.value - cr1.get_payoff_and_defaults().equity_payoff) < 1e-9
+        assert 0 < greeks.delta.value <= 1.0 + 5 * greeks.delta.standard_error
+
+    def test_standard_errors_and_target_precision(self):
+        """Test standard errors, confidence intervals and the target-precision mode"""
+        from statistics import NormalDist
+
+        assert abs(qf.normal_quantile(0.975) - NormalDist().inv_cdf(0.975)) < 1e-14
+
+        eq1 = qf.EQ1(1.0, 100.0, 100.0, 0.1, 0.05, 50, 20000)
+        estimate = eq1.get_premium_estimate()
+        assert estimate.value == eq1.get_premium()
+        assert estimate.samples == 20000
+        assert estimate.standard_error > 0
+
+        interval = estimate.confidence_interval(0.95)
+        assert interval.lower < estimate.value < interval.upper
+        half_width = 1.959963984540054 * estimate.standard_error
+        assert abs((interval.upper - interval.lower) - 2 * half_width) < 1e-12
+
+        # Stops early once the standard error is small enough, for any thread count
+        target = 2 * estimate.standard_error
+        eq1.set_target_error(target)
+        stopped = eq1.get_premium_estimate()
+        assert stopped.standard_error <= target
+        assert stopped.samples < 20000
+        eq1.set_threads(4)
+        assert eq1.get_premium_estimate().value == stopped.value
+
+        cr1 = qf.CR1()
+        results = cr1.get_payoff_and_defaults()
+        assert results.equity_payoff_estimate.value == results.equity_payoff
+        assert results.percentage_defaults_estimate.standard_error > 0
+
+        ir = qf.IR(0.05, 0.5, 0.15, 0.5, 4, 20000, True)
+        ir.set_target_error(2e-4)
+        results = ir.get_simulation_data()
+        assert results.estimate.value == results.value
+        assert results.estimate.standard_error <= 2e-4
+        assert len(results.datapoints) == results.estimate.samples < 20000
+
+    def test_variance_reduction(self):
+        """Test that antithetic paths and control variates cut the standard error"""
+        VR = qf.VarianceReduction
+
+        eq1 = qf.EQ1(1.0, 100.0, 100.0, 0.1, 0.05, 50, 20000)
+        crude = eq1.get_premium_estimate()
+
+        eq1.set_variance_reduction(VR.none)
+        assert eq1.get_premium_estimate().value == crude.value
+
+        eq1.set_variance_reduction(VR.antithetic)
+        antithetic = eq1.get_premium_estimate()
+        assert antithetic.samples == 10000
+        assert antithetic.standard_error < 0.7 * crude.standard_error
+
+        eq1.set_variance_reduction(VR.control_variate | VR.antithetic | VR.moment_matching)
+        controlled = eq1.get_premium_estimate()
+        assert controlled.standard_error < 0.05 * crude.standard_error
+        assert abs(controlled.value - crude.value) < 4 * crude.standard_error
+
+        eq2 = qf.EQ2()
+        crude = eq2.get_premium_estimate()
+        eq2.set_variance_reduction(VR.control_variate)
+        controlled = eq2.get_premium_estimate()
+        assert controlled.standard_error < crude.standard_error
+        assert abs(controlled.value - crude.value) < 4 * crude.standard_error
+
+        cr1 = qf.CR1(4.0, 70.0, 100.0, 0.2, 0.05, 100, 10000)
+        crude = cr1.get_payoff_and_defaults().equity_payoff_estimate
+        cr1.set_variance_reduction(VR.control_variate)
+        controlled = cr1.get_payoff_and_defaults().equity_payoff_estimate
+        assert controlled.standard_error < 0.1 * crude.standard_error
+
+    def test_sobol_sampling(self):
+        """Test that Sobol paths converge faster than pseudo-random ones"""
+        Sampling = qf.SamplingMethod
+
+        eq1 = qf.EQ1(1.0, 100.0, 100.0, 0.2, 0.05, 64, 16384)
+        pseudo = eq1.get_premium_estimate()
+        eq1.set_sampling(Sampling.sobol)
+        sobol = eq1.get_premium_estimate()
+        assert sobol.samples == 16384
+        assert sobol.standard_error < 0.2 * pseudo.standard_error
+        assert abs(sobol.value - 10.450583572185565) < 4 * sobol.standard_error + 0.01
+
+        eq1.set_threads(3)
+        assert eq1.get_premium_estimate().value == sobol.value
+
+        eq2 = qf.EQ2()
+        pseudo = eq2.get_premium_estimate()
+        eq2.set_sampling(Sampling.sobol)
+        sobol = eq2.get_premium_estimate()
+        assert sobol.standard_error < pseudo.standard_error
+        assert abs(sobol.value - pseudo.value) < 4 * pseudo.standard_error
+
+        ir = qf.IR(0.05, 0.5, 0.15, 0.5, 4, 8192, True)
+        pseudo = ir.get_simulation_data()
+        ir.set_sampling(Sampling.sobol)
+        sobol = ir.get_simulation_data()
+        assert sobol.estimate.standard_error < 0.2 * pseudo.estimate.standard_error
+        assert abs(sobol.value - pseudo.value) < 4 * pseudo.estimate.standard_error
+
+        # One chunk of 256 paths samples a single digital shift: the error is
+        # unknown, not zero, and a target error keeps simulating past it
+        small = qf.EQ1(1.0, 100.0, 100.0, 0.2, 0.05, 64, 256)
+        small.set_sampling(Sampling.sobol)
+        assert math.isinf(small.get_premium_estimate().standard_error)
+
+        ir = qf.IR(0.05, 0.5, 0.15, 0.5, 4, 256, True)
+        ir.set_sampling(Sampling.sobol)
+        ir.set_target_error(1e-3)
+        assert math.isinf(ir.get_simulation_data().estimate.standard_error)
+
+        ir = qf.IR(0.05, 0.5, 0.15, 0.5, 4, 4096, True)
+        ir.set_sampling(Sampling.sobol)
+        ir.set_target_error(1e3)
+        loose = ir.get_simulation_data().estimate
+        assert loose.samples > 256 and 0 < loose.standard_error < 1e3
+
+    def test_analytic_dispatch(self):
+        """Test closed-form engines against Monte Carlo and the dispatch rules"""
+        Engine = qf.PricingEngine
+
+        eq1 = qf.EQ1()
+        mc = eq1.get_premium_estimate()
+        eq1.set_engine(Engine.automatic)
+        exact = eq1.get_premium_estimate()
+        assert exact.value == qf.black_scholes_call(100.0, 100.0, 0.05, 0.1, 1.0)
+        assert exact.standard_error == 0 and exact.samples == 0
+        assert abs(exact.value - mc.value) < 4 * mc.standard_error
+
+        eq1.set_payoff(qf.PutPayoff(100.0))
+        assert eq1.get_premium() == qf.black_scholes_put(100.0, 100.0, 0.05, 0.1, 1.0)
+
+        # No closed form: automatic falls back to simulation, analytic refuses
+        eq1.set_payoff(qf.AsianCallPayoff(100.0))
+        assert eq1.get_premium_estimate().samples > 0
+        eq1.set_engine(Engine.analytic)
+        try:
+            eq1.get_premium()
+            assert False, "expected RuntimeError"
+        except RuntimeError:
+            pass
+
+        eq2 = qf.EQ2(1.0, 0.05, 120.0, 100.0, 0.1, 0.15, 0.5, 300, 10000)
+        mc = eq2.get_premium_estimate()
+        eq2.set_engine(Engine.automatic)
+        assert abs(eq2.get_premium() - mc.value) < 4 * mc.standard_error
+
+        cr1 = qf.CR1(4.0, 70.0, 100.0, 0.2, 0.05, 500, 10000)
+        mc = cr1.get_payoff_and_defaults()
+        cr1.set_engine(Engine.automatic)
+        exact = cr1.get_payoff_and_defaults()
+        assert exact.equity_payoff == qf.merton_equity(100.0, 70.0, 0.05, 0.2, 4.0)
+        assert abs(exact.equity_payoff - mc.equity_payoff) < 4 * mc.equity_payoff_estimate.standard_error
+        assert abs(exact.percentage_defaults - mc.percentage_defaults) < 4 * mc.percentage_defaults_estimate.standard_error
+
+        ir = qf.IR(0.05, 0.5, 0.15, 0.5, 4, 8192, True)
+        ir.set_sampling(qf.SamplingMethod.sobol)
+        mc = ir.get_simulation_data()
+        ir.set_engine(Engine.automatic)
+        exact = ir.get_simulation_data()
+        assert len(exact.datapoints) == 0
+        assert abs(exact.value - mc.value) < 4 * mc.estimate.standard_error
+
+    def test_eq1_repricing_cache(self):
+        """Cached EQ1 reprices moved strikes on stored paths and matches a fresh engine exactly"""
+        fresh, cached = fresh_and_cached(lambda: qf.EQ1(1.0, 100.0, 100.0, 0.2, 0.05, 100, 20000))
+        for K in [90.0, 100.0, 110.0]:
+            fresh.set_strike(K)
+            cached.set_strike(K)
+            assert cached.get_premium() == fresh.get_premium()
+        stats = cached.get_cache_stats()
+        assert stats.misses == 1 and stats.hits == 2
+
+        cached.set_spot(101.0)
+        cached.get_premium()
+        assert cached.get_cache_stats().misses == 2
+
+        print(f"Repricing cache - EQ1 hits/misses = {stats.hits}/{stats.misses}")
+
+    def test_eq1_scenario_files(self):
+        """EQ1 priced off a written scenario file matches fresh simulations exactly"""
+        import os
+        import tempfile
+        import numpy as np
+
+        with tempfile.TemporaryDirectory() as directory:
+            path = os.path.join(directory, "eq1.wab")
+            eq1, priced = written_and_replayed(lambda: qf.EQ1(1.0, 100.0, 100.0, 0.2, 0.05, 50, 3000), path, True)
+
+            scenarios = qf.ScenarioSet(path)
+            assert scenarios.engine == qf.ScenarioEngine.EQ1
+            assert scenarios.paths == 3000 and scenarios.chunks == 12
+            assert "state" in scenarios and "path" in scenarios
+
+            # The last step of each full path is the terminal value of its state
+            n = scenarios.chunk_paths(11)
+            state = scenarios.chunk("state", 11).reshape(n, 4)
+            path_grid = scenarios.chunk("path", 11).reshape(50, n)
+            assert (path_grid[-1] == state[:, 0]).all()
+            assert not state.flags.writeable
+
+            for K in [90.0, 100.0, 110.0]:
+                eq1.set_strike(K)
+                priced.set_strike(K)
+                assert priced.get_premium() == eq1.get_premium()
+            eq1.set_payoff(qf.AsianCallPayoff(100.0))
+            priced.set_payoff(qf.AsianCallPayoff(100.0))
+            assert priced.get_premium() == eq1.get_premium()
+
+            # Paths simulated with another spot cannot be reused
+            priced.set_spot(101.0)
+            try:
+                priced.get_premium()
+                assert False, "expected ValueError"
+            except ValueError:
+                pass
+
+            # Files with a missing or inconsistent header are rejected up front
+            broken = os.path.join(directory, "broken.wab")
+            for chunk_paths, paths in [([256.0, 256.0], 3000.0), ([0.0], 100.0), ([], None)]:
+                with qf.GridWriter(broken) as writer:
+                    writer.write("engine", np.array([1.0]))
+                    writer.write("key", np.array([1.0, 2.0]))
+                    if paths is not None:
+                        writer.write("paths", np.array([paths]))
+                    writer.write("chunk_paths", np.array(chunk_paths))
+                try:
+                    qf.ScenarioSet(broken)
+                    assert False, "expected RuntimeError"
+                except RuntimeError:
+                    pass
+
+    def test_eq1_batch_premiums(self):
+        """Test that a batch of contracts matches pricing each one on the same paths"""
+        import numpy as np
+
+        strikes = np.array([80.0, 90.0, 100.0, 110.0, 120.0])
+        maturities = np.full(len(strikes), 1.0)
+
+        eq1 = qf.EQ1(1.0, 100.0, 100.0, 0.1, 0.05, 100, 2000)
+        premiums = eq1.get_premiums(maturities, strikes)
+
+        assert premiums.shape == strikes.shape
+        for K, premium in zip(strikes, premiums):
+            assert premium == qf.EQ1(1.0, K, 100.0, 0.1, 0.05, 100, 2000).get_premium()
+
+        # Half of the steps fall before T = 0.5, on the same normals
+        mixed = eq1.get_premiums(np.array([1.0, 0.5]), np.array([100.0, 100.0]))
+        assert mixed[0] == premiums[2]
+        assert mixed[1] == qf.EQ1(0.5, 100.0, 100.0, 0.1, 0.05, 50, 2000).get_premium()
+
+    def test_eqn_basket_engine(self):
+        """Test the N-asset engine against EQ2 and on larger baskets"""
+        import numpy as np
+
+        correlation = [[1.0, 0.5], [0.5, 1.0]]
+        eqn = qf.EQN(1.0, 0.05, [120.0, 100.0], [0.1, 0.15], correlation, 300, 1000)
+        assert eqn.assets == 2
+        assert eqn.get_premium() == qf.EQ2().get_premium()
+
+        # sigma2 now drives the second asset
+        h = 1e-5
+        greeks = qf.EQ2().get_greeks()
+        up = qf.EQ2(1.0, 0.05, 120.0, 100.0, 0.1, 0.15 + h, 0.5, 300, 1000).get_premium()
+        down = qf.EQ2(1.0, 0.05, 120.0, 100.0, 0.1, 0.15 - h, 0.5, 300, 1000).get_premium()
+        assert greeks.vega2.value > 0
+        assert abs(greeks.vega2.value - (up - down) / (2 * h)) < 1e-4
+
+        n = 20
+        correlation = np.asarray(qf.exponential_correlation(n, 0.05))
+        weights = [1.0 / n] * n
+        basket = qf.EQN(1.0, 0.05, [100.0] * n, [0.2] * n, correlation, 20, 4096,
+                        qf.CorrelationFactorization.pca, 5)
+        basket.set_payoff(qf.BasketCallPayoff(weights, 100.0))
+        serial = basket.get_premium_estimate()
+        basket.set_threads(3)
+        assert basket.get_premium_estimate().value == serial.value
+        assert 0 < serial.value < qf.EQ1(1.0, 100.0, 100.0, 0.2, 0.05, 20, 4096).get_premium() + 4 * serial.standard_error
+
+        basket.set_payoff(qf.BestOfCallPayoff(100.0))
+        best = basket.get_premium()
+        basket.set_payoff(qf.WorstOfPutPayoff(100.0))
+        assert best > serial.value and basket.get_premium() > 0
+
+        terminal = np.array([[1.0, 5.0], [3.0, 2.0]])
+        assert list(qf.MaxOfAssetsPayoff()(terminal)) == [3.0, 5.0]
+
+        try:
+            qf.EQN(1.0, 0.05, [100.0, 100.0], [0.2], np.eye(2), 10, 100)
+            assert False, "expected ValueError"
+        except ValueError:
+            pass
+
+    def test_eq1_american_exercise(self):
+        """Longstaff-Schwartz American and Bermudan puts against the European and the LS (2001) value"""
+        eq1 = qf.EQ1(1.0, 40.0, 36.0, 0.2, 0.06, 50, 20000)
+        eq1.set_payoff(qf.PutPayoff(40.0))
+
+        american = eq1.get_american_premium()
+        european = eq1.get_premium_estimate()
+        assert abs(american.value - 4.478) < 0.1
+        assert american.value > european.value + 10 * american.standard_error
+
+        # Exercisable only at T: the European premium on the same paths
+        assert abs(eq1.get_bermudan_premium([1.0]).value - european.value) < 1e-12
+        quarterly = eq1.get_bermudan_premium([0.25, 0.5, 0.75, 1.0]).value
+        assert european.value < quarterly < american.value
+
+        eq1.set_threads(3)
+        assert eq1.get_american_premium().value == american.value
+
+        # No early exercise premium for a call without dividends
+        call = qf.EQ1(1.0, 40.0, 36.0, 0.2, 0.06, 50, 20000)
+        estimate = call.get_american_premium()
+        assert abs(estimate.value - call.get_premium()) < 2 * estimate.standard_error
+
+        for times in [[], [1.5]]:
+            try:
+                eq1.get_bermudan_premium(times)
+                assert False, "expected ValueError"
+            except ValueError:
+                pass
+
+        eq1.set_payoff(qf.AsianCallPayoff(40.0))
+        try:
+            eq1.get_american_premium()
+            assert False, "expected ValueError"
+        except ValueError:
+            pass
+
     def test_eq2_default_constructor(self):
         """Test EQ2 basket option with default constructor"""
         eq2 = qf.EQ2()
@@ -151,6 +670,110 @@ class TestCreditRisk:
         print(f"CR2 - PV default leg = {results.pv_default_leg}")
         print(f"CR2 - CDS spread in bps = {results.cds_spread_in_bps}")
 
+    def test_cr1_scenario_files(self):
+        """CR1 priced off a written scenario file matches fresh simulations exactly"""
+        import os
+        import tempfile
+
+        with tempfile.TemporaryDirectory() as directory:
+            path = os.path.join(directory, "cr1.wab")
+            cr1, priced = written_and_replayed(lambda: qf.CR1(4.0, 70.0, 100.0, 0.2, 0.05, 50, 2000), path)
+            for D in [70.0, 90.0]:
+                cr1.set_debt(D)
+                priced.set_debt(D)
+                assert priced.get_payoff_and_defaults().equity_payoff == cr1.get_payoff_and_defaults().equity_payoff
+
+    def test_cr2_repricing_cache(self):
+        """Cached CR2 reprices moved notionals on the stored curve and matches a fresh engine exactly"""
+        fresh, cached = fresh_and_cached(qf.CR2)
+        for notional in [100.0, 250.0]:
+            fresh.set_notional(notional)
+            cached.set_notional(notional)
+            assert (cached.get_pv_premium_and_default_legs_and_cds_spread().pv_default_leg
+                    == fresh.get_pv_premium_and_default_legs_and_cds_spread().pv_default_leg)
+        assert cached.get_cache_stats().hits == 2
+
+    def test_cds_batch_and_bootstrap(self):
+        """Batched CDS legs match CR2 on a flat curve; a bootstrapped hazard curve reprices its quotes"""
+        cr2 = qf.CR2(1.0, 4, 100.0, 0.05, 0.01, 0.5)
+        single = cr2.get_pv_premium_and_default_legs_and_cds_spread()
+
+        pricer = qf.CdsBatchPricer(qf.PiecewiseFlatCurve(0.05), qf.cds_payment_times(1.0, 4), [1.0])
+        batch = pricer.price([[0.01], [0.02]], [0.5, 0.5], [100.0, 100.0])
+        assert abs(batch.pv_premium_leg[0] - single.pv_premium_leg) < 1e-10
+        assert abs(batch.cds_spread_in_bps[0] - single.cds_spread_in_bps) < 1e-9
+        assert batch.cds_spread_in_bps[1] > batch.cds_spread_in_bps[0]
+
+        discount = qf.PiecewiseFlatCurve([1.0, 3.0, 10.0], [0.03, 0.035, 0.04])
+        tenors = [1.0, 2.0, 3.0, 5.0, 7.0, 10.0]
+        quotes = [60.0, 75.0, 90.0, 110.0, 120.0, 125.0]
+        curve = qf.bootstrap_hazard_curve(discount, tenors, quotes, 0.4)
+        assert all(h > 0 for h in curve.values)
+
+        for tenor, quote in zip(tenors, quotes):
+            pricer = qf.CdsBatchPricer(discount, qf.cds_payment_times(tenor, 4), curve.knots)
+            repriced = pricer.price([curve.values], [0.4], [1.0])
+            assert abs(repriced.cds_spread_in_bps[0] - quote) < 1e-8
+
+        try:
+            qf.bootstrap_hazard_curve(discount, [1.0, 2.0], [200.0, 20.0], 0.4)
+            assert False, "an inverted quote curve should need a negative hazard"
+        except ValueError:
+            pass
+
+        # At high recovery the first year's premium is already too large for any
+        # hazard rate to reach a steep second quote
+        steep = qf.bootstrap_hazard_curve(discount, [1.0, 2.0], [200.0, 3000.0], 0.4)
+        assert all(h > 0 for h in steep.values)
+        for quotes in ([200.0, 3000.0], [60.0, 1e7]):
+            try:
+                qf.bootstrap_hazard_curve(discount, [1.0, 2.0], quotes, 0.9)
+                assert False, "expected ValueError"
+            except ValueError as error:
+                assert "pillar 1 is not attainable" in str(error)
+
+        print(f"CDS bootstrap - hazard rates = {list(curve.values)}")
+
+    def test_credit_portfolio_loss_distribution(self):
+        """The recursion and Monte Carlo agree on a one-factor portfolio loss distribution"""
+        n = 100
+        pd = [0.005 + 0.045 * i / (n - 1) for i in range(n)]
+        exposure = [1.0 + i % 5 for i in range(n)]
+        recovery = [0.4] * n
+        expected = sum(p * e * 0.6 for p, e in zip(pd, exposure))
+
+        portfolio = qf.CreditPortfolio(pd, exposure, recovery, 0.2)
+        portfolio.set_engine(qf.PricingEngine.analytic)
+        recursion = portfolio.get_loss_distribution()
+        assert abs(recursion.probability.sum() - 1.0) < 1e-12
+        assert abs(recursion.expected_loss - expected) < 1e-9
+        assert recursion.expected_loss < recursion.value_at_risk < recursion.expected_shortfall
+        tranches = recursion.tranche_loss(0.0, 5.0) + recursion.tranche_loss(5.0, 15.0) + recursion.tranche_loss(15.0, 1e9)
+        assert abs(tranches - expected) < 1e-9
+
+        loadings = qf.Matrix([[0.2 ** 0.5]] * n)
+        same = qf.CreditPortfolio(pd, exposure, recovery, loadings)
+        same.set_engine(qf.PricingEngine.analytic)
+        assert abs(same.get_loss_distribution().value_at_risk - recursion.value_at_risk) < 1e-12
+
+        portfolio.set_engine(qf.PricingEngine.monte_carlo)
+        portfolio.set_scenarios(200000)
+        simulated = portfolio.get_loss_distribution()
+        estimate = simulated.expected_loss_estimate
+        assert abs(estimate.value - expected) < 4 * estimate.standard_error
+        assert abs(simulated.value_at_risk - recursion.value_at_risk) < 1.0
+        assert abs(simulated.expected_shortfall - recursion.expected_shortfall) < 0.02 * recursion.expected_shortfall
+
+        assert abs(qf.hazard_default_probability(0.02, 5.0) - (1.0 - math.exp(-0.1))) < 1e-15
+
+        try:
+            qf.CreditPortfolio([1.5], [1.0], [0.4], 0.2)
+            assert False, "a default probability above 1 should be rejected"
+        except ValueError:
+            pass
+
+        print(f"Credit portfolio - 99% VaR = {recursion.value_at_risk}, ES = {recursion.expected_shortfall}")
+
 
 class TestInterestRates:
     """Test suite for Interest Rates (mirrors apps/interest_rates.cpp)"""
@@ -220,6 +843,152 @@ class TestInterestRates:
 
         assert isinstance(results2.value, float)
 
+    def test_ir_datapoints_are_numpy_views(self):
+        """Test that IR datapoints are a numpy view of the C++-owned buffer"""
+        import numpy as np
+
+        data = qf.IR(0.05, 0.5, 0.15, 0.5, 4, 2000, True).get_simulation_data()
+        assert isinstance(data.datapoints, np.ndarray) and data.datapoints.shape == (2000,)
+        # Each access is a new view of the same buffer, not a copy
+        assert np.shares_memory(data.datapoints, data.datapoints)
+
+    def test_ir_datapoints_binary_round_trip(self):
+        """Test that IR datapoints written to a binary file read back unchanged"""
+        import os
+        import tempfile
+        import numpy as np
+
+        results = qf.IR(0.05, 0.5, 0.15, 0.5, 4, 3000, True).get_simulation_data()
+
+        with tempfile.TemporaryDirectory() as directory:
+            path = os.path.join(directory, "ir.grid")
+            with qf.GridWriter(path) as writer:
+                qf.write_datapoints(writer, results)
+                writer.write("datapoints32", results.datapoints, qf.GridDtype.float32)
+
+            reader = qf.GridReader(path)
+            back = qf.read_datapoints(reader)
+
+            assert np.array_equal(back.datapoints, results.datapoints)
+            assert back.value == results.value
+            assert back.estimate.standard_error == results.estimate.standard_error
+            assert back.estimate.samples == results.estimate.samples
+
+            single = reader.read_vector("datapoints32")
+            assert np.allclose(single, results.datapoints, rtol=1e-6)
+
+            try:
+                reader.view("datapoints32")
+                assert False, "float32 arrays cannot be viewed as float64"
+            except RuntimeError:
+                pass
+
+            del reader
+
+    def test_ir_repricing_cache(self):
+        """Cached IR reprices moved strikes on stored paths and matches a fresh engine exactly"""
+        fresh, cached = fresh_and_cached(lambda: qf.IR(1000000.0, 0.05, 0.5, 0.15, 0.5, 8, 5000, True))
+        for K in [0.04, 0.06]:
+            fresh.set_strike(K)
+            cached.set_strike(K)
+            assert cached.get_simulation_data().value == fresh.get_simulation_data().value
+        assert cached.get_cache_stats().hits == 1
+
+    def test_ir_instrumentation_report(self):
+        """IR counters see every simulated path when the library is instrumented"""
+        report = instrumentation_after(qf.IR(1000000.0, 0.05, 0.5, 0.15, 0.5, 8, 3000, True).get_simulation_data)
+        if report is None:
+            return
+
+        assert report["ir.paths"].count == 3000
+        assert report["ir.steps"].count == 8 * 3000
+        for phase in ["ir.evolve", "ir.payoff"]:
+            assert report[phase].calls > 0
+
+        qf.reset_instrumentation()
+        assert qf.instrumentation_report() == []
+
+    def test_ir_scenario_files(self):
+        """IR priced off a written scenario file matches fresh simulations, and other engines reject the file"""
+        import os
+        import tempfile
+
+        with tempfile.TemporaryDirectory() as directory:
+            path = os.path.join(directory, "ir.wab")
+            ir, priced = written_and_replayed(lambda: qf.IR(1000000.0, 0.05, 0.5, 0.15, 0.5, 8, 2000, True), path)
+            for K in [0.04, 0.06]:
+                ir.set_strike(K)
+                priced.set_strike(K)
+                fresh, stored = ir.get_simulation_data(), priced.get_simulation_data()
+                assert stored.value == fresh.value
+                assert (stored.datapoints == fresh.datapoints).all()
+
+            try:
+                eq1 = qf.EQ1()
+                eq1.set_scenarios(qf.ScenarioSet(path))
+                eq1.get_premium()
+                assert False, "expected ValueError"
+            except ValueError:
+                pass
+
+    def test_ir_long_dated_threads(self):
+        """Test a 30-year quarterly cap and swap on several threads"""
+        for cap in (True, False):
+            ir = qf.IR(1e6, 0.05, 0.25, 0.15, 0.25, 120, 1000, cap)
+            serial = ir.get_simulation_data()
+
+            ir.set_threads(4)
+            threaded = ir.get_simulation_data()
+
+            assert len(threaded.datapoints) == 1000
+            assert threaded.value == serial.value
+            assert (threaded.datapoints == serial.datapoints).all()
+            assert math.isfinite(threaded.value)
+
+    def test_ir_multi_factor(self):
+        """Test correlation factorization and the multi-factor LMM"""
+        import numpy as np
+
+        correlation = np.asarray(qf.exponential_correlation(5, 0.5))
+        for method in (qf.CorrelationFactorization.cholesky, qf.CorrelationFactorization.pca):
+            loadings = np.asarray(qf.CorrelatedNormals(correlation, method).loadings)
+            assert np.allclose(loadings @ loadings.T, correlation, atol=1e-12)
+
+        pca = qf.CorrelatedNormals(correlation, qf.CorrelationFactorization.pca, 2)
+        loadings = np.asarray(pca.loadings)
+        assert loadings.shape == (5, 2)
+        assert np.allclose((loadings ** 2).sum(axis=1), 1.0)
+        draws = pca.apply(np.random.default_rng(1).standard_normal((2, 1000)))
+        assert draws.shape == (5, 1000)
+
+        # An eigen decomposition that cannot converge is reported, not returned
+        broken = np.eye(3)
+        broken[0, 1] = broken[1, 0] = float("nan")
+        try:
+            qf.CorrelatedNormals(broken, qf.CorrelationFactorization.pca)
+            assert False, "expected RuntimeError"
+        except RuntimeError:
+            pass
+
+        # Perfectly correlated rates reproduce the one-factor model
+        N = 8
+        one_factor = qf.IR(0.05, 0.5, 0.15, 0.5, N, 2000, True)
+        ir = qf.IR(0.05, 0.5, 0.15, 0.5, N, 2000, True)
+        ir.set_correlation(np.ones((N + 1, N + 1)), qf.CorrelationFactorization.pca, 1)
+        assert ir.get_simulation_data().value == one_factor.get_simulation_data().value
+
+        ir.set_correlation(qf.exponential_correlation(N + 1, 0.1, 0.5), qf.CorrelationFactorization.pca, 3)
+        serial = ir.get_simulation_data()
+        ir.set_threads(3)
+        assert ir.get_simulation_data().value == serial.value
+        assert math.isfinite(serial.value)
+
+        try:
+            ir.set_correlation(np.eye(N), qf.CorrelationFactorization.pca, 0)
+            assert False, "expected ValueError"
+        except ValueError:
+            pass
+
 
 class TestForexOptions:
     """Test suite for Forex Options (mirrors apps/forex.cpp)"""
@@ -295,6 +1064,171 @@ class TestForexOptions:
         print(f"\nFX1 Custom Parameters:")
         print(f"  Successfully computed with T={T}, K={K}, S0={S0}")
 
+    def test_fx1_grid_is_zero_copy(self):
+        """Test that FX grids are exposed as numpy views of the C++ storage"""
+        import numpy as np
+
+        fx = qf.FX1()
+        result = fx.get_data_and_premium()
+
+        u = np.asarray(result.u)
+        assert u.shape == (len(result.x), len(result.t))
+        assert result.u.layout == qf.MatrixLayout.column_major
+        assert u.flags['F_CONTIGUOUS']
+
+        u[1, 1] = 123.0
+        assert result.u[(1, 1)] == 123.0
+        assert result.u[1][1] == 123.0
+
+    def test_fx1_results_are_numpy_views(self):
+        """Test that FX1 result vectors are numpy views of C++-owned buffers"""
+        import numpy as np
+
+        result = qf.FX1().get_data_and_premium()
+        assert isinstance(result.x, np.ndarray) and isinstance(result.tau, np.ndarray)
+
+        # Writes through the array land in the C++ result
+        x = result.x
+        x[0] = -7.0
+        assert result.x[0] == -7.0
+
+        quote = qf.FX1().get_premium()
+        assert isinstance(quote.v, np.ndarray) and len(quote.v) == len(quote.S)
+
+    def test_fx1_repricing_cache(self):
+        """Cached FX1 reprices moved spots on the stored PDE slice and matches a fresh engine exactly"""
+        def make():
+            fx = qf.FX1(0.5, 75.0, 75.0, 0.3, 0.05, 0.001, 0.01, 201, 500)
+            fx.set_scheme(qf.FXScheme.crank_nicolson)
+            return fx
+
+        fresh, cached = fresh_and_cached(make)
+        for S0 in [70.0, 75.0, 80.0]:
+            fresh.set_spot(S0)
+            cached.set_spot(S0)
+            assert cached.get_premium().premium == fresh.get_premium().premium
+        assert cached.get_cache_stats().hits == 2
+
+    def test_fx1_instrumentation_report(self):
+        """FX1 counters see every grid node when the library is instrumented"""
+        report = instrumentation_after(qf.FX1(0.5, 75.0, 75.0, 0.3, 0.05, 0.001, 0.01, 201, 500).get_data_and_premium)
+        if report is None:
+            return
+
+        assert report["fx1.grid_nodes"].count == 201 * 500
+        for phase in ["fx1.mesh", "fx1.sweep", "fx1.transform"]:
+            assert report[phase].calls > 0
+
+    def test_fx1_implicit_schemes_large_dt(self):
+        """Test that implicit and Crank-Nicolson stay bounded where explicit is unstable, and converge"""
+        import numpy as np
+
+        # alpha = 2.25, well past the explicit limit of 0.5
+        def max_abs_u(scheme):
+            fx = qf.FX1(10.0, 75.0, 75.0, 0.3, 0.05, 0.5, 0.1, 21, 21, False)
+            fx.set_scheme(scheme)
+            result = fx.get_data_and_premium()
+            assert result.alpha > 0.5
+            u = np.asarray(result.u)
+            return np.abs(u).max(), np.abs(u[:, 0]).max()
+
+        explicit_max, payoff_max = max_abs_u(qf.FXScheme.explicit_fd)
+        assert explicit_max > 1e6 * payoff_max
+
+        for scheme in (qf.FXScheme.implicit_fd, qf.FXScheme.crank_nicolson):
+            scheme_max, payoff_max = max_abs_u(scheme)
+            assert scheme_max <= payoff_max * (1 + 1e-12)
+
+        # Both converge to Black-Scholes as dt shrinks (one rate, so
+        # Garman-Kohlhagen with no foreign rate); implicit is first order,
+        # Crank-Nicolson second, so it is closer at equal dt
+        exact = qf.black_scholes_call(100.0, 100.0, 0.05, 0.2, 1.0)
+
+        def error(scheme, steps):
+            fx = qf.FX1(1.0, 100.0, 100.0, 0.2, 0.05, 1.0 / steps, 0.01, 201, steps + 1, False)
+            fx.set_scheme(scheme)
+            return abs(fx.get_premium().premium - exact)
+
+        implicit_coarse = error(qf.FXScheme.implicit_fd, 40)
+        implicit_fine = error(qf.FXScheme.implicit_fd, 80)
+        crank_nicolson = error(qf.FXScheme.crank_nicolson, 40)
+        assert implicit_fine < 0.7 * implicit_coarse and implicit_fine < 0.02
+        assert crank_nicolson < 0.005 and crank_nicolson < 0.25 * implicit_coarse
+
+    def test_fx1_binary_grid_round_trip(self):
+        """Test that streamed and whole-grid binary files read back bit for bit"""
+        import os
+        import tempfile
+        import numpy as np
+
+        fx = qf.FX1(0.5, 75.0, 75.0, 0.3, 0.05, 0.01, 0.1, 21, 51, False)
+        full = fx.get_data_and_premium()
+
+        codecs = [qf.GridCodec.none]
+        if qf.grid_compression_available():
+            codecs.append(qf.GridCodec.zlib)
+
+        with tempfile.TemporaryDirectory() as directory:
+            for codec in codecs:
+                path = os.path.join(directory, "fx.grid")
+                with qf.GridWriter(path, codec) as writer:
+                    quote = fx.write_data_and_premium(writer)
+
+                assert quote.premium == fx.get_premium().premium
+
+                reader = qf.GridReader(path)
+                assert reader.info("u").rows == 21 and reader.info("u").cols == 51
+
+                back = qf.read_result_data(reader)
+                assert np.array_equal(np.asarray(back.u), np.asarray(full.u))
+                assert np.array_equal(np.asarray(back.v), np.asarray(full.v))
+                assert np.array_equal(back.tau, full.tau)
+
+                # Uncompressed grids are viewed in place, read-only
+                if codec == qf.GridCodec.none:
+                    u = reader.view("u")
+                    assert np.array_equal(u, np.asarray(full.u)) and not u.flags.writeable
+
+                del reader
+
+            # Appended slices must hold exactly the declared number of values
+            path = os.path.join(directory, "slices.grid")
+            with qf.GridWriter(path) as writer:
+                id = writer.declare("slices", 100)
+                assert writer.info(id).rows == 100
+                for bad in (np.zeros(3), np.zeros((10, 10))):
+                    try:
+                        writer.append(id, bad)
+                        assert False, "expected ValueError"
+                    except ValueError:
+                        pass
+                writer.append(id, np.arange(100.0))
+
+            reader = qf.GridReader(path)
+            assert reader.info("slices").cols == 1
+            assert np.array_equal(reader.read_vector("slices"), np.arange(100.0))
+            del reader
+
+    def test_fx1_premium_only_matches_full_grid(self):
+        """Test that the two-slice premium mode matches the final slice of the full grid"""
+        for barrier in (False, True):
+            for scheme in (qf.FXScheme.explicit_fd, qf.FXScheme.crank_nicolson):
+                fx = qf.FX1()
+                fx.set_barrier(barrier)
+                fx.set_scheme(scheme)
+
+                full = fx.get_data_and_premium()
+                quote = fx.get_premium()
+
+                last = len(full.t) - 1
+                for i in range(len(full.x)):
+                    assert quote.v[i] == full.v[(i, last)]
+
+                # Default spot is the middle node, where the full mode reads its premium
+                assert quote.premium == full.v[(len(full.x) // 2, last)]
+                assert quote.delta > 0
+                assert quote.gamma > 0
+
 
 class TestRandomNumberGeneration:
     """Test suite for Random Number Generation utilities"""
@@ -322,6 +1256,44 @@ class TestRandomNumberGeneration:
         assert abs(mean) < 0.1, f"Mean {mean} too far from 0"
         assert abs(std_dev - 1.0) < 0.1, f"Std dev {std_dev} too far from 1.0"
 
+    def test_box_muller_seeded(self):
+        """Test that seeded Box-Muller generators are reproducible"""
+        a = qf.SampleBoxMuller(5)
+        b = qf.SampleBoxMuller(5)
+
+        assert [a() for _ in range(10)] == [b() for _ in range(10)]
+
+    def test_normal_generator_fill_and_skip_ahead(self):
+        """Test block generation and skip-ahead of the counter-based generator"""
+        import numpy as np
+
+        gen = qf.NormalGenerator(7, 3)
+        block = np.empty(11)
+        gen.fill(block)
+        assert gen.position == 11
+
+        sequential = qf.NormalGenerator(7, 3)
+        assert all(sequential() == value for value in block)
+
+        skipped = qf.NormalGenerator(7, 3)
+        skipped.skip_ahead(5)
+        tail = np.empty(6)
+        skipped.fill(tail)
+        assert np.array_equal(tail, block[5:])
+
+        other_stream = gen.split(4)
+        assert other_stream() != block[0]
+
+    def test_normal_generator_statistics(self):
+        """Test mean and standard deviation of the counter-based generator"""
+        import numpy as np
+
+        samples = np.empty(100000)
+        qf.NormalGenerator(1).fill(samples)
+
+        assert abs(samples.mean()) < 0.02
+        assert abs(samples.std() - 1.0) < 0.02
+
 
 def test_module_import():
     """Test that the module can be imported and has expected attributes"""
@@ -332,6 +1304,7 @@ def test_module_import():
     assert hasattr(qf, 'IR')
     assert hasattr(qf, 'FX1')
     assert hasattr(qf, 'SampleBoxMuller')
+    assert hasattr(qf, 'NormalGenerator')
     print("\nAll expected classes are available in the module")
 
 
@@ -354,6 +1327,22 @@ if __name__ == "__main__":
     equity_tests = TestEquityOptions()
     equity_tests.test_eq1_default_constructor()
     equity_tests.test_eq1_custom_parameters()
+    equity_tests.test_eq1_seed_reproducibility()
+    equity_tests.test_eq1_eq2_thread_count_invariance()
+    equity_tests.test_eq1_pricing_releases_the_gil()
+    equity_tests.test_simd_levels_bit_identical()
+    equity_tests.test_eq1_payoffs()
+    equity_tests.test_eq1_greeks()
+    equity_tests.test_eq2_cr1_greeks()
+    equity_tests.test_standard_errors_and_target_precision()
+    equity_tests.test_variance_reduction()
+    equity_tests.test_sobol_sampling()
+    equity_tests.test_analytic_dispatch()
+    equity_tests.test_eq1_repricing_cache()
+    equity_tests.test_eq1_scenario_files()
+    equity_tests.test_eq1_batch_premiums()
+    equity_tests.test_eqn_basket_engine()
+    equity_tests.test_eq1_american_exercise()
     equity_tests.test_eq2_default_constructor()
     equity_tests.test_eq2_custom_parameters()
 
@@ -366,6 +1355,10 @@ if __name__ == "__main__":
     credit_tests.test_cr1_custom_parameters()
     credit_tests.test_cr2_default_constructor()
     credit_tests.test_cr2_custom_parameters()
+    credit_tests.test_cr1_scenario_files()
+    credit_tests.test_cr2_repricing_cache()
+    credit_tests.test_cds_batch_and_bootstrap()
+    credit_tests.test_credit_portfolio_loss_distribution()
 
     # Interest Rates Tests
     print("\n" + "=" * 80)
@@ -375,6 +1368,13 @@ if __name__ == "__main__":
     ir_tests.test_ir_default_constructor()
     ir_tests.test_ir_swap_pricing()
     ir_tests.test_ir_cap_pricing()
+    ir_tests.test_ir_datapoints_are_numpy_views()
+    ir_tests.test_ir_datapoints_binary_round_trip()
+    ir_tests.test_ir_repricing_cache()
+    ir_tests.test_ir_instrumentation_report()
+    ir_tests.test_ir_scenario_files()
+    ir_tests.test_ir_long_dated_threads()
+    ir_tests.test_ir_multi_factor()
 
     # Forex Options Tests
     print("\n" + "=" * 80)
@@ -385,6 +1385,13 @@ if __name__ == "__main__":
     fx_tests.test_fx1_vanilla_option()
     fx_tests.test_fx1_barrier_option()
     fx_tests.test_fx1_custom_parameters()
+    fx_tests.test_fx1_grid_is_zero_copy()
+    fx_tests.test_fx1_results_are_numpy_views()
+    fx_tests.test_fx1_repricing_cache()
+    fx_tests.test_fx1_instrumentation_report()
+    fx_tests.test_fx1_implicit_schemes_large_dt()
+    fx_tests.test_fx1_binary_grid_round_trip()
+    fx_tests.test_fx1_premium_only_matches_full_grid()
 
     # Random Number Generation Tests
     print("\n" + "=" * 80)
@@ -392,6 +1399,9 @@ if __name__ == "__main__":
     print("=" * 80)
     rng_tests = TestRandomNumberGeneration()
     rng_tests.test_box_muller_sampling()
+    rng_tests.test_box_muller_seeded()
+    rng_tests.test_normal_generator_fill_and_skip_ahead()
+    rng_tests.test_normal_generator_statistics()
 
     print("\n" + "=" * 80)
     print("ALL TESTS COMPLETED SUCCESSFULLY!")